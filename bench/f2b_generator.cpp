@@ -0,0 +1,99 @@
+/**
+ * @file f2b_generator.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the synthetic fail2ban output generator.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+
+#include <fmt/format.h>
+
+#include "category_table.hpp"
+#include "f2b_generator.hpp"
+
+static constexpr size_t CHUNK_SIZE = 1024 * 1024; //!< The amount of output buffered before it is passed to the sink
+
+string generatedJailName(size_t index) {
+    constexpr auto knownJails = std::size(DEFAULT_JAIL_CATEGORIES);
+    return index < knownJails ? string(DEFAULT_JAIL_CATEGORIES[index].jail) : fmt::format("custom-jail-{0:d}", index - knownJails);
+}
+
+void generateFail2BanOutput(const GeneratorOptions& options, const std::function<void(string_view)>& sink) {
+    std::mt19937_64 random(options.seed);
+    std::uniform_real_distribution<double> unitDistribution(0, 1);
+
+    // Zipf-like weights: jail n gets roughly 1/(n+1) of the bans
+    const auto jailCount = options.isSingleJail ? 1 : std::max<size_t>(1, options.jailCount);
+    std::vector<double> weights(jailCount);
+    double weightSum = 0;
+    for (size_t i = 0; i < jailCount; i++) { weightSum += weights[i] = 1.0 / static_cast<double>(i + 1); }
+
+    std::vector<size_t> ipsPerJail(jailCount);
+    size_t assigned = 0;
+    for (size_t i = 0; i < jailCount; i++) {
+        ipsPerJail[i] = static_cast<size_t>(static_cast<double>(options.ipCount) * weights[i] / weightSum);
+        assigned += ipsPerJail[i];
+    }
+    ipsPerJail[0] += options.ipCount - assigned;
+
+    fmt::memory_buffer buffer;
+    const auto flushIfFull = [&]() {
+        if (buffer.size() < CHUNK_SIZE) { return; }
+        sink(string_view(buffer.data(), buffer.size()));
+        buffer.clear();
+    };
+
+    const auto writeIp = [&]() {
+        const auto bits = random();
+        if (unitDistribution(random) < options.ipv6Ratio) {
+            // documentation/unique-local looking addresses with a mix of compressed and full forms
+            if ((bits & 1) == 0) {
+                fmt::format_to(std::back_inserter(buffer), "'2001:db8:{0:x}:{1:x}::{2:x}'", (bits >> 8) & 0xffff, (bits >> 24) & 0xffff, (bits >> 40) & 0xffff);
+            } else {
+                fmt::format_to(std::back_inserter(buffer), "'fd{0:02x}:{1:x}:{2:x}:{3:x}:{4:x}:{5:x}:{6:x}:{7:x}'", (bits >> 1) & 0xff,
+                               (bits >> 8) & 0xffff, (bits >> 16) & 0xffff, (bits >> 24) & 0xffff, (bits >> 32) & 0xffff,
+                               (bits >> 40) & 0xffff, (bits >> 48) & 0xffff, random() & 0xffff);
+            }
+        } else {
+            fmt::format_to(std::back_inserter(buffer), "'{0:d}.{1:d}.{2:d}.{3:d}'", 1 + (bits & 0xff) % 223, (bits >> 8) & 0xff, (bits >> 16) & 0xff, 1 + ((bits >> 24) & 0xff) % 254);
+        }
+    };
+
+    const auto writeIpList = [&](size_t count) {
+        buffer.push_back('[');
+        for (size_t i = 0; i < count; i++) {
+            if (i > 0) { buffer.append(string_view(", ")); }
+            writeIp();
+            flushIfFull();
+        }
+        buffer.push_back(']');
+    };
+
+    if (options.isSingleJail) {
+        writeIpList(ipsPerJail[0]);
+    } else {
+        buffer.push_back('[');
+        for (size_t jail = 0; jail < jailCount; jail++) {
+            if (jail > 0) { buffer.append(string_view(", ")); }
+            fmt::format_to(std::back_inserter(buffer), "{{'{0:s}': ", generatedJailName(jail));
+            writeIpList(ipsPerJail[jail]);
+            buffer.push_back('}');
+        }
+        buffer.push_back(']');
+    }
+
+    buffer.push_back('\n');
+    sink(string_view(buffer.data(), buffer.size()));
+}
+
+string generateFail2BanOutput(const GeneratorOptions& options) {
+    string output;
+    generateFail2BanOutput(options, [&](string_view chunk) { output.append(chunk); });
+    return output;
+}
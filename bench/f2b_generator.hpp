@@ -0,0 +1,59 @@
+/**
+ * @file f2b_generator.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the synthetic fail2ban output generator used by the benchmarks.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_BENCH_F2B_GENERATOR_HPP
+#define FAIL2ABUSEIPDB_BENCH_F2B_GENERATOR_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief The shape of the generated output.
+ */
+struct GeneratorOptions {
+    size_t      jailCount = 10; //!< The amount of jails (ignored for single-jail output)
+    size_t      ipCount = 10000; //!< The total amount of banned IPs
+    double      ipv6Ratio = 0.1; //!< The share of IPv6 addresses (0-1)
+    bool        isSingleJail = false; //!< Generate `get <jail> banned` output (a flat list) instead of `banned`
+    uint64_t    seed = 0x5eed; //!< The seed; the same options always produce the same output
+};
+
+/**
+ * @brief Generates output as printed by `fail2ban-client banned` or `fail2ban-client get <jail> banned`.
+ *
+ * Jails are named after the jails fail2abuseipdb knows (then "custom-jail-N"); the IPs are distributed unevenly across
+ * them, as in real exports, where a couple of jails (sshd, ...) hold most bans and some are empty.
+ *
+ * @param options The shape of the output.
+ * @param sink Receives the output in chunks of roughly 1MiB.
+ */
+void generateFail2BanOutput(const GeneratorOptions& options, const std::function<void(string_view)>& sink);
+
+/**
+ * @brief Generates the output into a string.
+ *
+ * @param options The shape of the output.
+ *
+ * @return string The complete output.
+ */
+string generateFail2BanOutput(const GeneratorOptions& options);
+
+/**
+ * @brief Gets the name of the n-th generated jail.
+ */
+string generatedJailName(size_t index);
+
+#endif // FAIL2ABUSEIPDB_BENCH_F2B_GENERATOR_HPP
@@ -0,0 +1,643 @@
+/**
+ * @file fail2abuseipdb_bench.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Benchmarks the individual stages of fail2abuseipdb and the application as a whole.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "category_table.hpp"
+#include "cidr_trie.hpp"
+#include "comment_template.hpp"
+#include "compression.hpp"
+#include "csv_writer.hpp"
+#include "f2b_generator.hpp"
+#include "f2b_parser.hpp"
+#include "ip_address.hpp"
+#include "ip_deduplicator.hpp"
+#include "string_splitter.hpp"
+
+namespace fs = std::filesystem;
+
+using std::cerr;
+using std::endl;
+using std::string;
+using std::string_view;
+using std::vector;
+
+using bench_clock = std::chrono::steady_clock;
+
+extern char** environ;
+
+/**
+ * @brief The outcome of a single benchmark.
+ */
+struct BenchResult {
+    string  name; //!< The name of the benchmark
+    double  seconds; //!< The best time of all repetitions
+    size_t  items; //!< The amount of items (IPs, rows, lookups) processed per repetition
+    size_t  bytes; //!< The amount of bytes processed per repetition (0 if not meaningful)
+};
+
+static bool     checkStringSplit(string_view); //!< Checks StringSplit's run-time paths against its constexpr path
+static bool     parseArgs(int32_t argc, char** argv); //!< Parses the application arguments
+static bool     shouldRun(string_view); //!< Whether or not a benchmark matches the filter
+static double   runEndToEnd(const string&, const string&); //!< Runs the application on a file and returns the elapsed time
+static void     printHelpText(const string&); //!< Prints the help text to the terminal
+static void     printResult(const BenchResult&); //!< Prints a single result
+static bool     runMicroBenchmarks(); //!< Benchmarks the individual stages
+static void     runEndToEndBenchmarks(); //!< Benchmarks the application as a whole
+
+/**
+ * @brief A tokenisation case for @see checkStringSplit(): the input, the delimiter, and the expected tokens joined by '|'.
+ */
+struct SplitCase {
+    string_view input;
+    string_view delimiter;
+    size_t      tokenCount;
+    string_view joinedTokens;
+};
+
+/**
+ * @brief The tokens StringSplit yields for an input, as offsets into the input and lengths.
+ */
+struct SplitTokens {
+    static constexpr size_t MAX_TOKENS = 8;
+
+    size_t offsets[MAX_TOKENS]{};
+    size_t lengths[MAX_TOKENS]{};
+    size_t count = 0;
+
+    constexpr bool operator==(const SplitTokens& other) const {
+        if (count != other.count) { return false; }
+        for (size_t i = 0; i < count && i < MAX_TOKENS; i++) {
+            if (offsets[i] != other.offsets[i] || lengths[i] != other.lengths[i]) { return false; }
+        }
+        return true;
+    }
+};
+
+static constexpr SplitCase SPLIT_CASES[] = {
+    { "", ",", 0, "" },
+    { "token", ",", 1, "token" },
+    { ",a,bc", ",", 3, "|a|bc" },
+    { "a,bc,", ",", 3, "a|bc|" },
+    { "a,,,bc", ",", 4, "a|||bc" },
+    { ",", ",", 2, "|" },
+    { "a::b:c::", "::", 3, "a|b:c|" },
+    { "::::", "::", 3, "||" },
+    { "aaa", "aa", 2, "|a" },
+    { "a,b", "", 1, "a,b" },
+    { "", "", 0, "" },
+}; //!< The cases checked by @see checkStringSplit()
+
+/**
+ * @brief Splits the input, by the character overload if isCharOverload is set and the delimiter is a single character.
+ */
+static constexpr SplitTokens splitTokens(string_view input, string_view delimiter, bool isCharOverload) {
+    SplitTokens tokens;
+    const auto addToken = [&](string_view token) {
+        if (tokens.count < SplitTokens::MAX_TOKENS) {
+            tokens.offsets[tokens.count] = static_cast<size_t>(token.data() - input.data());
+            tokens.lengths[tokens.count] = token.size();
+        }
+        tokens.count++;
+    };
+
+    if (isCharOverload && delimiter.size() == 1) {
+        for (const auto token : StringSplit(input, delimiter.front())) { addToken(token); }
+    } else {
+        for (const auto token : StringSplit(input, delimiter)) { addToken(token); }
+    }
+
+    return tokens;
+}
+
+/**
+ * @brief Splits every case in a constant expression, i.e. without memchr().
+ */
+static constexpr std::array<SplitTokens, std::size(SPLIT_CASES)> splitCasesAtCompileTime(bool isCharOverload) {
+    std::array<SplitTokens, std::size(SPLIT_CASES)> results{};
+    for (size_t i = 0; i < std::size(SPLIT_CASES); i++) { results[i] = splitTokens(SPLIT_CASES[i].input, SPLIT_CASES[i].delimiter, isCharOverload); }
+    return results;
+}
+
+static constexpr auto SPLIT_EXPECTED = splitCasesAtCompileTime(false); //!< The constexpr path's tokens, by string delimiter
+static constexpr auto SPLIT_EXPECTED_CHAR = splitCasesAtCompileTime(true); //!< The constexpr path's tokens, by character delimiter
+
+template<typename Benchmark>
+static BenchResult measure(const string&, size_t, size_t, Benchmark&&); //!< Runs a benchmark repeatedly and keeps the best time
+
+static constexpr double MIN_BENCH_SECONDS = 0.5; //!< Each benchmark is repeated for at least this long...
+static constexpr size_t MAX_REPETITIONS = 10; //!< ...but no more often than this
+
+static volatile size_t  g_blackhole = 0; //!< Results are written here, so the compiler can't drop the work
+static bool             g_generateOnly = false; //!< Whether or not to only print generated fail2ban output
+static bool             g_isQuick = false; //!< Whether or not to skip the largest end-to-end run
+static GeneratorOptions g_generatorOptions; //!< The shape of the generated output (--generate)
+static size_t           g_microIpCount = 1000000; //!< The amount of IPs used by the stage benchmarks
+static string           g_filter = ""; //!< Only benchmarks whose name contains this are run
+static string           g_binary = FAIL2ABUSEIPDB_BINARY; //!< The application used by the end-to-end benchmarks
+
+int main(int32_t argc, char** argv) {
+    if (!parseArgs(argc, argv)) { return 1; }
+
+    if (g_generateOnly) {
+        generateFail2BanOutput(g_generatorOptions, [](string_view chunk) { fwrite(chunk.data(), 1, chunk.size(), stdout); });
+        return 0;
+    }
+
+    fmt::print("{0:<36} {1:>12} {2:>16} {3:>12}\n", "benchmark", "time", "items/s", "MB/s");
+    if (!runMicroBenchmarks()) { return 1; }
+    runEndToEndBenchmarks();
+
+    return 0;
+}
+
+/**
+ * @brief Benchmarks each stage of the pipeline on its own, on generated data.
+ * 
+ * @return false If a stage produced wrong results (checked before it's timed, where supported).
+ */
+bool runMicroBenchmarks() {
+    GeneratorOptions options;
+    options.jailCount = 50;
+    options.ipCount = g_microIpCount;
+    const auto bannedOutput = generateFail2BanOutput(options);
+
+    options.isSingleJail = true;
+    const auto jailOutput = generateFail2BanOutput(options);
+
+    // the inputs of the later stages, as the parser hands them out
+    vector<string> jails;
+    vector<string> ips;
+    {
+        Fail2BanParser parser([&](string_view jail, string_view ip) {
+            jails.emplace_back(jail);
+            ips.emplace_back(ip);
+        }, "");
+        parser.feed(bannedOutput);
+        parser.finish();
+    }
+
+    if (shouldRun("parse/banned")) {
+        printResult(measure("parse/banned", ips.size(), bannedOutput.size(), [&]() {
+            size_t ipCount = 0;
+            Fail2BanParser parser([&](string_view, string_view) { ipCount++; }, "");
+            parser.feed(bannedOutput);
+            parser.finish();
+            g_blackhole = g_blackhole + ipCount;
+        }));
+    }
+
+    if (shouldRun("parse/get-jail-banned")) {
+        printResult(measure("parse/get-jail-banned", ips.size(), jailOutput.size(), [&]() {
+            size_t ipCount = 0;
+            Fail2BanParser parser([&](string_view, string_view) { ipCount++; }, "sshd");
+            parser.feed(jailOutput);
+            parser.finish();
+            g_blackhole = g_blackhole + ipCount;
+        }));
+    }
+
+    if (shouldRun("parse/banned-64KiB-chunks")) {
+        printResult(measure("parse/banned-64KiB-chunks", ips.size(), bannedOutput.size(), [&]() {
+            size_t ipCount = 0;
+            Fail2BanParser parser([&](string_view, string_view) { ipCount++; }, "");
+            for (size_t offset = 0; offset < bannedOutput.size(); offset += 64 * 1024) {
+                parser.feed(string_view(bannedOutput).substr(offset, 64 * 1024));
+            }
+            parser.finish();
+            g_blackhole = g_blackhole + ipCount;
+        }));
+    }
+
+    if (shouldRun("ip-address/parse")) {
+        printResult(measure("ip-address/parse", ips.size(), 0, [&]() {
+            IpAddress address;
+            size_t parsed = 0;
+            for (const auto& ip : ips) { parsed += IpAddress::parse(ip, address); }
+            g_blackhole = g_blackhole + parsed;
+        }));
+    }
+
+    // the baseline for ip-address/parse: what IpAddress::parse did before it had its own IPv4 parser
+    if (shouldRun("ip-address/inet_pton")) {
+        printResult(measure("ip-address/inet_pton", ips.size(), 0, [&]() {
+            IpAddress address;
+            size_t parsed = 0;
+            for (const auto& ip : ips) {
+                char buffer[INET6_ADDRSTRLEN + 1] = {0};
+                std::memcpy(buffer, ip.data(), std::min(ip.size(), sizeof(buffer) - 1));
+                parsed += ip.find(':') == string::npos ? inet_pton(AF_INET, buffer, address.bytes.data() + 12) : inet_pton(AF_INET6, buffer, address.bytes.data());
+            }
+            g_blackhole = g_blackhole + parsed;
+        }));
+    }
+
+    if (shouldRun("ip-address/canonicalize")) {
+        vector<IpAddress> addresses(ips.size());
+        for (size_t i = 0; i < ips.size(); i++) { IpAddress::parse(ips[i], addresses[i]); }
+
+        printResult(measure("ip-address/canonicalize", addresses.size(), 0, [&]() {
+            size_t length = 0;
+            for (const auto& address : addresses) { length += address.toString().size(); }
+            g_blackhole = g_blackhole + length;
+        }));
+    }
+
+    if (shouldRun("exclusions/lookup")) {
+        vector<CidrTrie::Prefix> prefixes;
+        for (const auto text : { "10.0.0.0/8", "172.16.0.0/12", "192.168.0.0/16", "100.64.0.0/10", "203.0.113.0/24", "2001:db8:1::/48", "fd00::/8" }) {
+            CidrTrie::Prefix prefix{};
+            CidrTrie::parsePrefix(text, prefix);
+            prefixes.push_back(prefix);
+        }
+        const CidrTrie exclusions(prefixes);
+
+        vector<IpAddress> addresses(ips.size());
+        for (size_t i = 0; i < ips.size(); i++) { IpAddress::parse(ips[i], addresses[i]); }
+
+        printResult(measure("exclusions/lookup", addresses.size(), 0, [&]() {
+            size_t excluded = 0;
+            for (const auto& address : addresses) { excluded += exclusions.contains(address); }
+            g_blackhole = g_blackhole + excluded;
+        }));
+    }
+
+    if (shouldRun("dedupe/add")) {
+        vector<IpAddress> addresses(ips.size());
+        for (size_t i = 0; i < ips.size(); i++) { IpAddress::parse(ips[i], addresses[i]); }
+
+        printResult(measure("dedupe/add", addresses.size(), 0, [&]() {
+            IpDeduplicator deduplicator;
+            for (size_t i = 0; i < addresses.size(); i++) { deduplicator.add(addresses[i], deduplicator.jailId(jails[i])); }
+            deduplicator.finish();
+            g_blackhole = g_blackhole + deduplicator.entries().size();
+        }));
+    }
+
+    if (shouldRun("split/tokens")) {
+        if (!checkStringSplit(bannedOutput)) { return false; }
+
+        // as many tokens as IPs; the same single-character path the category and exclusion lists take
+        printResult(measure("split/tokens", ips.size(), bannedOutput.size(), [&]() {
+            size_t length = 0;
+            for (const auto token : StringSplit(bannedOutput, ',')) { length += token.size(); }
+            g_blackhole = g_blackhole + length;
+        }));
+    }
+
+    if (shouldRun("categories/lookup")) {
+        const CategoryTable categoryTable;
+        printResult(measure("categories/lookup", jails.size(), 0, [&]() {
+            size_t length = 0;
+            for (const auto& jail : jails) { length += categoryTable.categoriesFor(jail).size(); }
+            g_blackhole = g_blackhole + length;
+        }));
+    }
+
+    const string comment = "IP banned by fail2ban; banned in jail {0}. Report generated by fail2abuseipdb.";
+    if (shouldRun("comment/format")) {
+        printResult(measure("comment/format", jails.size(), 0, [&]() {
+            fmt::memory_buffer buffer;
+            size_t length = 0;
+            for (const auto& jail : jails) {
+                buffer.clear();
+                fmt::vformat_to(std::back_inserter(buffer), comment, fmt::make_format_args(jail));
+                length += buffer.size();
+            }
+            g_blackhole = g_blackhole + length;
+        }));
+    }
+
+    if (shouldRun("comment/template")) {
+        printResult(measure("comment/template", jails.size(), 0, [&]() {
+            // as in the application: compiled once, bound once per jail
+            const CommentTemplate compiled(comment);
+            std::map<string, CommentTemplate, std::less<>> jailComments;
+            fmt::memory_buffer buffer;
+            size_t length = 0;
+            for (const auto& jail : jails) {
+                auto iter = jailComments.find(jail);
+                if (iter == jailComments.end()) { iter = jailComments.emplace(jail, compiled.bind(CommentTemplate::Field::Jails, jail)).first; }
+
+                buffer.clear();
+                iter->second.render(buffer);
+                length += buffer.size();
+            }
+            g_blackhole = g_blackhole + length;
+        }));
+    }
+
+    if (shouldRun("csv/emit")) {
+        const CategoryTable categoryTable;
+        const auto devNull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        size_t bytesWritten = 0;
+        printResult(measure("csv/emit", ips.size(), 0, [&]() {
+            CsvWriter csvWriter(devNull);
+            csvWriter.writeHeader();
+            for (size_t i = 0; i < ips.size(); i++) {
+                csvWriter.writeRow(ips[i], categoryTable.categoriesFor(jails[i]), "2026-10-16 12:00:00+0000", [&](fmt::memory_buffer& buffer) {
+                    fmt::vformat_to(std::back_inserter(buffer), comment, fmt::make_format_args(jails[i]));
+                });
+            }
+            csvWriter.flush();
+            bytesWritten = csvWriter.bytesWritten();
+        }));
+        close(devNull);
+        g_blackhole = g_blackhole + bytesWritten;
+    }
+
+    for (const auto& [name, compression] : { std::pair{ "csv/emit-plain", Compression::None }, std::pair{ "csv/emit-gzip", Compression::Gzip },
+                                             std::pair{ "csv/emit-zstd", Compression::Zstd } }) {
+        if (!shouldRun(name)) { continue; }
+        if (!isCompressionSupported(compression)) {
+            cerr << "Skipping " << name << ": not supported by this build." << endl;
+            continue;
+        }
+
+        const CategoryTable categoryTable;
+        uint64_t bytesIn = 0;
+        printResult(measure(name, ips.size(), 0, [&]() {
+            // as with --output: rows are handed to the writer, which compresses them on its own thread
+            CompressedWriter output("/dev/null", compression);
+            CsvWriter csvWriter([&](string_view rows, size_t) { output.write(rows); }, std::numeric_limits<size_t>::max(), CsvWriter::DEFAULT_BUFFER_SIZE);
+            csvWriter.writeHeader();
+            for (size_t i = 0; i < ips.size(); i++) {
+                csvWriter.writeRow(ips[i], categoryTable.categoriesFor(jails[i]), "2026-10-16 12:00:00+0000", [&](fmt::memory_buffer& buffer) {
+                    fmt::vformat_to(std::back_inserter(buffer), comment, fmt::make_format_args(jails[i]));
+                });
+            }
+            csvWriter.flush();
+            output.finish();
+            bytesIn = output.bytesIn();
+        }));
+        g_blackhole = g_blackhole + bytesIn;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Checks that StringSplit yields the same tokens at run time, where single-character delimiters are searched with
+ * memchr(), as in constant expressions; and that a long input is split like a plain search would.
+ * 
+ * @param longInput A long input with ','-delimited tokens.
+ * 
+ * @return true If all tokens matched.
+ * @return false Otherwise (the mismatches are printed).
+ */
+bool checkStringSplit(string_view longInput) {
+    bool isCorrect = true;
+
+    for (size_t i = 0; i < std::size(SPLIT_CASES); i++) {
+        const auto& splitCase = SPLIT_CASES[i];
+        // a copy, so the search really runs over run-time data
+        const string input(splitCase.input);
+
+        for (const bool isCharOverload : { false, true }) {
+            const auto tokens = splitTokens(input, splitCase.delimiter, isCharOverload);
+            const auto& expected = isCharOverload ? SPLIT_EXPECTED_CHAR[i] : SPLIT_EXPECTED[i];
+
+            string joinedTokens;
+            for (size_t j = 0; j < tokens.count && j < SplitTokens::MAX_TOKENS; j++) {
+                if (j > 0) { joinedTokens.push_back('|'); }
+                joinedTokens.append(input, tokens.offsets[j], tokens.lengths[j]);
+            }
+
+            if (!(tokens == expected) || tokens.count != splitCase.tokenCount || joinedTokens != splitCase.joinedTokens) {
+                cerr << "StringSplit(\"" << input << "\", \"" << splitCase.delimiter << "\") yields " << tokens.count << " token(s) \"" << joinedTokens
+                     << "\" at run time; expected " << splitCase.tokenCount << " token(s) \"" << splitCase.joinedTokens << "\"" << endl;
+                isCorrect = false;
+            }
+        }
+    }
+
+    string_view rest = longInput;
+    size_t tokenCount = 0;
+    for (const auto token : StringSplit(longInput, ',')) {
+        const auto tokenEnd = rest.find(',');
+        if (token.data() != rest.data() || token.size() != std::min(tokenEnd, rest.size())) {
+            cerr << "StringSplit yields a wrong token at offset " << (rest.data() - longInput.data()) << " of the generated input" << endl;
+            isCorrect = false;
+            break;
+        }
+        rest = tokenEnd == string_view::npos ? string_view{} : rest.substr(tokenEnd + 1);
+        tokenCount++;
+    }
+    if (isCorrect && tokenCount != static_cast<size_t>(std::count(longInput.begin(), longInput.end(), ',')) + (longInput.empty() ? 0 : 1)) {
+        cerr << "StringSplit yields " << tokenCount << " tokens for the generated input" << endl;
+        isCorrect = false;
+    }
+
+    if (!isCorrect) { cerr << "Failed to verify StringSplit!" << endl; }
+    return isCorrect;
+}
+
+/**
+ * @brief Runs the application on generated inputs of 10K, 1M and 10M IPs, discarding its output.
+ */
+void runEndToEndBenchmarks() {
+    if (!fs::exists(g_binary)) {
+        cerr << "Skipping end-to-end benchmarks: " << g_binary << " doesn't exist (see --binary)." << endl;
+        return;
+    }
+
+    vector<size_t> ipCounts{ 10000, 1000000 };
+    if (!g_isQuick) { ipCounts.push_back(10000000); }
+
+    for (const auto ipCount : ipCounts) {
+        const auto name = fmt::format("end-to-end/{0:d}-ips", ipCount);
+        if (!shouldRun(name)) { continue; }
+
+        const auto inputFile = (fs::temp_directory_path() / fmt::format("f2abipdb-bench-{0:d}-{1:d}.txt", getpid(), ipCount)).string();
+        {
+            GeneratorOptions options;
+            options.jailCount = 100;
+            options.ipCount = ipCount;
+            std::ofstream input(inputFile, std::ios::binary);
+            generateFail2BanOutput(options, [&](string_view chunk) { input.write(chunk.data(), static_cast<std::streamsize>(chunk.size())); });
+        }
+
+        const auto inputSize = fs::file_size(inputFile);
+        double bestSeconds = 0;
+        for (size_t i = 0; i < (ipCount >= 10000000 ? 1u : 3u); i++) {
+            const auto seconds = runEndToEnd(g_binary, inputFile);
+            if (seconds < 0) {
+                cerr << "Failed to run " << g_binary << "!" << endl;
+                break;
+            }
+            bestSeconds = i == 0 ? seconds : std::min(bestSeconds, seconds);
+        }
+
+        fs::remove(inputFile);
+        if (bestSeconds > 0) { printResult({ name, bestSeconds, ipCount, inputSize }); }
+    }
+}
+
+/**
+ * @brief Runs the application on a file with its output going to /dev/null.
+ *
+ * @param binary The application.
+ * @param inputFile The file to read.
+ *
+ * @return double The elapsed time in seconds, or -1 if the application failed.
+ */
+double runEndToEnd(const string& binary, const string& inputFile) {
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_addopen(&fileActions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    const string fileArg = "-f" + inputFile;
+    char* childArgv[] = { const_cast<char*>(binary.c_str()), const_cast<char*>(fileArg.c_str()), nullptr };
+
+    const auto start = bench_clock::now();
+    pid_t pid = -1;
+    const auto spawnResult = posix_spawn(&pid, binary.c_str(), &fileActions, nullptr, childArgv, environ);
+    posix_spawn_file_actions_destroy(&fileActions);
+    if (spawnResult != 0) { return -1; }
+
+    int32_t status = 0;
+    waitpid(pid, &status, 0);
+    const auto elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? elapsed : -1;
+}
+
+/**
+ * @brief Runs a benchmark once to warm up, then repeatedly, and keeps the fastest repetition.
+ *
+ * @param name The name of the benchmark.
+ * @param items The amount of items processed per repetition.
+ * @param bytes The amount of bytes processed per repetition.
+ * @param benchmark The code to measure.
+ *
+ * @return BenchResult The result.
+ */
+template<typename Benchmark>
+BenchResult measure(const string& name, size_t items, size_t bytes, Benchmark&& benchmark) {
+    benchmark();
+
+    double bestSeconds = 0;
+    double totalSeconds = 0;
+    for (size_t i = 0; i < MAX_REPETITIONS && (i < 3 || totalSeconds < MIN_BENCH_SECONDS); i++) {
+        const auto start = bench_clock::now();
+        benchmark();
+        const auto seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+        bestSeconds = i == 0 ? seconds : std::min(bestSeconds, seconds);
+        totalSeconds += seconds;
+    }
+
+    return { name, bestSeconds, items, bytes };
+}
+
+void printResult(const BenchResult& result) {
+    const auto itemsPerSecond = static_cast<double>(result.items) / result.seconds;
+    const auto bytesPerSecond = result.bytes == 0 ? string("-") : fmt::format("{0:.1f}", static_cast<double>(result.bytes) / result.seconds / 1e6);
+
+    fmt::print("{0:<36} {1:>9.3f} ms {2:>16.0f} {3:>12}\n", result.name, result.seconds * 1e3, itemsPerSecond, bytesPerSecond);
+    fflush(stdout);
+}
+
+bool shouldRun(string_view name) { return g_filter.empty() || name.find(g_filter) != string_view::npos; }
+
+/**
+ * @brief Parses the application arguments.
+ *
+ * @param argc The amount of arguments.
+ * @param argv The arguments.
+ *
+ * @return true If the benchmarks (or the generator) should run.
+ * @return false Otherwise.
+ */
+bool parseArgs(int32_t argc, char** argv) {
+    static const option OPTIONS[] = {
+        { "help",           no_argument,        nullptr, 'h' },
+        { "quick",          no_argument,        nullptr, 'q' },
+        { "filter",         required_argument,  nullptr, 'F' },
+        { "binary",         required_argument,  nullptr, 'b' },
+        { "micro-ips",      required_argument,  nullptr, 'm' },
+        { "generate",       no_argument,        nullptr, 'g' },
+        { "jails",          required_argument,  nullptr, 'J' },
+        { "ips",            required_argument,  nullptr, 'n' },
+        { "ipv6",           required_argument,  nullptr, '6' },
+        { "single-jail",    no_argument,        nullptr, '1' },
+        { "seed",           required_argument,  nullptr, 's' },
+        { nullptr,          no_argument,        nullptr,  0  }
+    };
+
+    int32_t optVal = -1;
+    try {
+        while ((optVal = getopt_long(argc, argv, "hqF:b:m:gJ:n:6:1s:", OPTIONS, nullptr)) != -1) {
+            switch (optVal) {
+                case 'q': g_isQuick = true; break;
+                case 'F': g_filter = optarg; break;
+                case 'b': g_binary = optarg; break;
+                case 'm': g_microIpCount = std::stoul(optarg); break;
+                case 'g': g_generateOnly = true; break;
+                case 'J': g_generatorOptions.jailCount = std::stoul(optarg); break;
+                case 'n': g_generatorOptions.ipCount = std::stoul(optarg); break;
+                case '6': g_generatorOptions.ipv6Ratio = std::stod(optarg); break;
+                case '1': g_generatorOptions.isSingleJail = true; break;
+                case 's': g_generatorOptions.seed = std::stoull(optarg); break;
+                default:
+                    printHelpText(argv[0]);
+                    return false;
+            }
+        }
+    } catch (const std::exception&) {
+        cerr << "Error: invalid value " << optarg << "!" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+void printHelpText(const string& binName) {
+    fmt::print(R"(
+{0:s} - benchmarks for fail2abuseipdb
+
+Usage:
+    {0:s} [--quick] [--filter=<name>] [--binary=<fail2abuseipdb>] [--micro-ips=<n>]
+    {0:s} --generate [--jails=<n>] [--ips=<n>] [--ipv6=<ratio>] [--single-jail] [--seed=<n>]
+
+Switches:
+            --quick                 Skips the 10M IP end-to-end run
+            --filter=<name>         Only runs benchmarks whose name contains <name>
+            --binary=<f>            The fail2abuseipdb binary used end-to-end (default: the one built alongside)
+            --micro-ips=<n>         The amount of IPs the stage benchmarks work on (default: 1000000)
+            --generate              Prints synthetic fail2ban-client output instead of benchmarking
+            --jails=<n>             The amount of jails to generate (default: 10)
+            --ips=<n>               The total amount of IPs to generate (default: 10000)
+            --ipv6=<ratio>          The share of IPv6 addresses, 0-1 (default: 0.1)
+            --single-jail           Generates `get <jail> banned` output instead of `banned`
+            --seed=<n>              The seed; equal seeds generate equal output
+)", binName);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file ban_snapshot.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the snapshot of the IPs banned at the end of the previous run.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_BAN_SNAPSHOT_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_BAN_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ip_address.hpp"
+#include "mapped_file.hpp"
+
+using std::string;
+
+/**
+ * @brief The set of IPs banned as of the previous run, used to output only the IPs banned since.
+ *
+ * A snapshot file is a small header followed by the IPs as a sorted array of packed 16-byte addresses. It is mapped, not
+ * read, and the IPs of the current run are radix-sorted and merged against it, so a run costs two linear passes over
+ * its IPs and one sequential scan of the snapshot, without any lookups into a large structure.
+ */
+class BanSnapshot {
+    public: // +++ Constructor +++
+        /**
+         * @brief Loads the snapshot at the given path; a missing file is an empty snapshot (every IP is new).
+         *
+         * @param path The path to the snapshot file.
+         *
+         * @throws std::system_error If the file exists, but can't be read.
+         * @throws std::runtime_error If the file is not a (valid) snapshot.
+         */
+        explicit BanSnapshot(const string& path);
+
+    public: // +++ Diffing +++
+        /**
+         * @brief Determines which of the currently banned IPs weren't banned at the time of the snapshot, and keeps the
+         * current IPs as the next snapshot.
+         *
+         * @param addresses The IPs banned right now (in any order).
+         *
+         * @return std::vector<bool> Whether the IP at the same index is new.
+         */
+        std::vector<bool> diff(const std::vector<IpAddress>& addresses);
+
+        /**
+         * @brief Replaces the snapshot file with the IPs passed to the last call to @see diff().
+         *
+         * @remarks The snapshot is written to a temporary file and renamed into place, so it is always either the old or
+         * the new one. Nothing is written if @see diff() wasn't called.
+         *
+         * @throws std::system_error If the snapshot can't be written.
+         */
+        void commit() const;
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets the amount of IPs in the loaded snapshot.
+         */
+        size_t previousCount() const { return m_previousCount; }
+
+    private: // +++ Members +++
+        string                          m_path; //!< The path to the snapshot file
+        std::unique_ptr<MappedFile>     m_previousFile; //!< The mapped snapshot (if there was one)
+        const uint8_t*                  m_previous = nullptr; //!< The previously banned IPs, sorted, 16 bytes each
+        size_t                          m_previousCount = 0; //!< The amount of previously banned IPs
+        std::vector<IpAddress>          m_current; //!< The currently banned IPs, sorted and unique
+        bool                            m_isDiffed = false; //!< Whether diff() was called
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_BAN_SNAPSHOT_HPP
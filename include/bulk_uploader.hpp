@@ -0,0 +1,140 @@
+/**
+ * @file bulk_uploader.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the abuseipdb bulk-report uploader.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_BULK_UPLOADER_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_BULK_UPLOADER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <curl/curl.h>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief Uploads CSV rows to abuseipdb's bulk-report endpoint.
+ *
+ * Rows are submitted in batches (see @see CsvWriter's batch sink), each of which becomes one multipart request
+ * carrying a complete CSV file. Up to a configurable amount of requests are kept in flight through a single libcurl
+ * multi handle, which reuses (and, with HTTP/2, multiplexes over) its connections.
+ *
+ * Requests answered with 429 or 5xx (or failing in transport) are retried; Retry-After is honoured and all uploads are
+ * paused meanwhile, otherwise the delay backs off exponentially. An exhausted rate limit (X-RateLimit-Remaining: 0)
+ * pauses uploads until X-RateLimit-Reset.
+ */
+class BulkUploader {
+    public: // +++ Types and constants +++
+        static constexpr const char* DEFAULT_URL = "https://api.abuseipdb.com/api/v2/bulk-report"; //!< abuseipdb's bulk-report endpoint
+        static constexpr size_t      MAX_BATCH_LINES = 10000; //!< The maximum amount of lines (including the header) per CSV file
+        static constexpr size_t      MAX_BATCH_BYTES = 2 * 1000 * 1000; //!< The maximum size of a CSV file (2MB)
+        static constexpr size_t      DEFAULT_MAX_IN_FLIGHT = 4; //!< The default amount of concurrent requests
+        static constexpr uint32_t    MAX_ATTEMPTS = 5; //!< The amount of attempts per batch before giving up on it
+
+        /**
+         * @brief Callback invoked once a batch was accepted or given up on.
+         *
+         * @param isAccepted Whether the server accepted the batch.
+         */
+        using CompletionCallback = std::function<void(bool isAccepted)>;
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Constructs a new uploader.
+         *
+         * @param url The URL of the bulk-report endpoint.
+         * @param apiKey The abuseipdb API key.
+         * @param maxInFlight The maximum amount of concurrent requests.
+         *
+         * @throws std::runtime_error If libcurl can't be initialised.
+         */
+        BulkUploader(const string& url, const string& apiKey, size_t maxInFlight);
+
+        BulkUploader(const BulkUploader&) = delete;
+        BulkUploader& operator=(const BulkUploader&) = delete;
+
+        /**
+         * @brief Aborts all outstanding requests.
+         */
+        ~BulkUploader();
+
+    public: // +++ Uploading +++
+        /**
+         * @brief Queues a batch of rows for upload and drives outstanding requests.
+         *
+         * Blocks while the maximum amount of requests is in flight, so the producer can't run arbitrarily far ahead.
+         *
+         * @param rows Complete CSV rows (without the header); at most MAX_BATCH_LINES - 1 rows and MAX_BATCH_BYTES bytes including the header.
+         * @param rowCount The amount of rows.
+         * @param onComplete Invoked (on the calling thread, during a later call) once the batch was accepted or given up on.
+         */
+        void submit(string_view rows, size_t rowCount, CompletionCallback onComplete = nullptr);
+
+        /**
+         * @brief Performs pending network I/O, starts due retries and handles finished requests without blocking.
+         *
+         * @remarks Long-running callers (watch mode) must call this regularly while @see isBusy(), as requests only make
+         * progress during calls into the uploader.
+         */
+        void poll() { drive(false); }
+
+        /**
+         * @brief Waits for all queued batches to be uploaded (or given up on).
+         *
+         * @return true If every batch was accepted.
+         * @return false If at least one batch was given up on; see @see lastError().
+         */
+        bool finish();
+
+    public: // +++ Getters +++
+        size_t batchesUploaded() const { return m_batchesUploaded; } //!< The amount of batches accepted by the server
+        size_t batchesFailed() const { return m_batchesFailed; } //!< The amount of batches given up on
+        size_t rowsUploaded() const { return m_rowsUploaded; } //!< The amount of rows in accepted batches
+        size_t reportsSaved() const { return m_reportsSaved; } //!< The amount of reports the server said it saved
+        size_t retries() const { return m_retries; } //!< The amount of retried requests
+        const string& lastError() const { return m_lastError; } //!< Describes the last batch which was given up on
+        bool isBusy() const { return !m_transfers.empty() || !m_pending.empty(); } //!< Whether any batch is in flight or waiting to be sent
+
+    private: // +++ Types +++
+        using clock = std::chrono::steady_clock;
+
+        struct Batch;
+        struct Transfer;
+
+    private: // +++ Member functions +++
+        void drive(bool wait);
+        void startReady();
+        void completeTransfer(Transfer& transfer, CURLcode curlResult);
+        void schedule(std::unique_ptr<Batch> batch, clock::duration delay);
+        void giveUp(const Batch& batch, const string& reason);
+
+    private: // +++ Members +++
+        string                                  m_url; //!< The endpoint
+        CURLM*                                  m_multi = nullptr; //!< The libcurl multi handle
+        curl_slist*                             m_headers = nullptr; //!< The request headers
+        size_t                                  m_maxInFlight; //!< The maximum amount of concurrent requests
+        std::deque<std::unique_ptr<Batch>>      m_pending; //!< Batches waiting to be sent (or retried)
+        std::vector<std::unique_ptr<Transfer>>  m_transfers; //!< The requests in flight
+        clock::time_point                       m_pausedUntil{}; //!< No requests are started before this point in time
+        size_t                                  m_batchesUploaded = 0; //!< The amount of batches accepted
+        size_t                                  m_batchesFailed = 0; //!< The amount of batches given up on
+        size_t                                  m_rowsUploaded = 0; //!< The amount of rows in accepted batches
+        size_t                                  m_reportsSaved = 0; //!< The sum of savedReports in the server's answers
+        size_t                                  m_retries = 0; //!< The amount of retried requests
+        string                                  m_lastError; //!< Describes the last batch given up on
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_BULK_UPLOADER_HPP
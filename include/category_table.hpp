@@ -0,0 +1,176 @@
+/**
+ * @file category_table.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the jail to abuseipdb category lookup table.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_CATEGORY_TABLE_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_CATEGORY_TABLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief A built-in jail to category mapping.
+ */
+struct JailCategory {
+    string_view jail; //!< The name of the jail
+    int32_t     category; //!< The category to add for this jail, or -1 if only the defaults apply
+};
+
+/**
+ * @brief The categories added to every report.
+ *
+ * @remarks Categories are listed [https://www.abuseipdb.com/categories](here)
+ */
+inline constexpr int32_t DEFAULT_CATEGORIES[] = {
+    15, 18
+};
+
+/**
+ * @brief The built-in jail to category mappings.
+ */
+inline constexpr JailCategory DEFAULT_JAIL_CATEGORIES[] = {
+    { "sshd",                   22 },
+    { "apache-auth",            21 },
+    { "apache-batbots",         19 },
+    { "apache-overflows",       21 },
+    { "apache-nohome",          21 },
+    { "apache-fakegooglebot",   19 },
+    { "apache-modsecurity",     21 },
+    { "apache-shellshock",      21 },
+    { "php-url-fopen",          21 },
+    { "roundcube-auth",         21 },
+    { "postfix",                -1 },
+    { "sendmail-auth",          20 },
+    { "sendmail-reject",        -1 },
+    { "dovecot",                -1 },
+    { "mysqld-auth",            21 },
+    { "pam-generic",            20 },
+    { "postfix-flood-attack",   04 }
+};
+
+/**
+ * @brief Maps jail names to their fully rendered, comma-separated category lists.
+ *
+ * The table is built once at startup from the built-in defaults and an optional override file. Every jail's category
+ * string is rendered up front and the jails are placed in a minimal-collision perfect hash table (hash and displace),
+ * so a lookup costs one hash, one displacement load and one key comparison.
+ *
+ * Override file format:
+ * @code
+ * # categories added to every report (replaces the built-in defaults)
+ * default = 15,18
+ * # categories added for a jail (replaces the built-in mapping; may be empty)
+ * sshd = 22
+ * my-custom-jail = 21,19
+ * @endcode
+ */
+class CategoryTable {
+    public: // +++ Constructor +++
+        /**
+         * @brief Constructs a table containing the built-in defaults.
+         */
+        CategoryTable();
+
+    public: // +++ Configuration +++
+        /**
+         * @brief Loads overrides from a file and rebuilds the table.
+         *
+         * @param path The path to the override file.
+         *
+         * @throws std::system_error If the file can't be read.
+         * @throws std::runtime_error If the file contains invalid lines.
+         */
+        void loadOverrides(const string& path);
+
+    public: // +++ Lookup +++
+        /**
+         * @brief Gets the rendered category list for a jail.
+         *
+         * @param jail The name of the jail.
+         *
+         * @return string_view The comma-separated categories; the default categories if the jail is unknown.
+         *
+         * @remarks The returned view remains valid until the table is modified.
+         */
+        string_view categoriesFor(string_view jail) const {
+            const auto hash = hashKey(jail);
+            const auto slot = slotFor(hash, m_displacements[hash & m_bucketMask]);
+            const auto& entry = m_slots[slot];
+
+            return entry.isUsed && entry.jail == jail ? string_view(entry.categories) : string_view(m_defaultRendered);
+        }
+
+        /**
+         * @brief Gets the union of the category lists of several jails.
+         *
+         * @param jails The names of the jails.
+         *
+         * @return string The comma-separated categories, in order of first appearance and without duplicates.
+         */
+        string categoriesFor(const std::vector<string_view>& jails) const;
+
+        /**
+         * @brief Gets the rendered default category list.
+         */
+        string_view defaultCategories() const { return m_defaultRendered; }
+
+    private: // +++ Types +++
+        /**
+         * @brief A jail and its (unrendered) extra categories.
+         */
+        struct JailEntry {
+            string                  jail; //!< The name of the jail
+            std::vector<int32_t>    categories; //!< The categories added for the jail
+        };
+
+        /**
+         * @brief A slot of the perfect hash table.
+         */
+        struct Slot {
+            string  jail; //!< The name of the jail
+            string  categories; //!< The rendered categories (defaults included)
+            bool    isUsed = false; //!< Whether this slot is occupied
+        };
+
+    private: // +++ Member functions +++
+        void rebuild();
+        string render(const std::vector<int32_t>& extraCategories) const;
+
+        static uint64_t hashKey(string_view key) {
+            // FNV-1a; jail names are short
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (const auto c : key) {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+        size_t slotFor(uint64_t hash, uint32_t displacement) const {
+            auto x = hash ^ (static_cast<uint64_t>(displacement) * 0x9e3779b97f4a7c15ull);
+            x ^= x >> 33; x *= 0xff51afd7ed558ccdull; x ^= x >> 33;
+            return static_cast<size_t>(x & m_slotMask);
+        }
+
+    private: // +++ Members +++
+        std::vector<int32_t>    m_defaultCategories; //!< The categories added to every report
+        std::vector<JailEntry>  m_jails; //!< The configured jails
+        std::vector<uint32_t>   m_displacements; //!< The displacement per bucket
+        std::vector<Slot>       m_slots; //!< The perfect hash table
+        string                  m_defaultRendered; //!< The rendered default categories
+        uint64_t                m_bucketMask = 0; //!< Mask selecting a bucket from a hash
+        uint64_t                m_slotMask = 0; //!< Mask selecting a slot from a displaced hash
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_CATEGORY_TABLE_HPP
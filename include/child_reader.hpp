@@ -0,0 +1,122 @@
+/**
+ * @file child_reader.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of a pipelined reader for the output of a child process.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_CHILD_READER_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_CHILD_READER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+using std::string;
+
+/**
+ * @brief Spawns a program (without a shell) and reads its standard output on a separate thread.
+ *
+ * The producer thread pulls the child's output in large chunks and queues them, so the child is never held up by the
+ * consumer (up to @see MAX_QUEUED_CHUNKS chunks) and the consumer can work on a chunk while the next one is being
+ * produced. The child's standard error is discarded.
+ *
+ * Several readers can be served by one consumer: each calls its ready callback whenever it has something new (a chunk
+ * or the end of the output), and @see tryNext() takes chunks without waiting.
+ */
+class ChildReader {
+    public: // +++ Types / Constants +++
+        /**
+         * @brief Called (on the reader's thread) when a chunk was queued or the output ended.
+         */
+        using ReadyCallback = std::function<void()>;
+
+        static constexpr size_t CHUNK_SIZE = 256 * 1024; //!< The amount of bytes read from the pipe at once
+        static constexpr size_t MAX_QUEUED_CHUNKS = 64; //!< The maximum amount of chunks buffered ahead of the consumer
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Spawns the program and starts reading its output.
+         *
+         * @param argv The program (looked up in $PATH if it contains no slash) followed by its arguments.
+         * @param onReady Called when a chunk was queued or the output ended (optional).
+         *
+         * @throws std::system_error If the pipe can't be created or the program can't be spawned.
+         */
+        explicit ChildReader(const std::vector<string>& argv, ReadyCallback onReady = nullptr);
+
+        ChildReader(const ChildReader&) = delete;
+        ChildReader& operator=(const ChildReader&) = delete;
+
+        /**
+         * @brief Terminates the child if its output wasn't read completely, then reaps it.
+         */
+        ~ChildReader();
+
+    public: // +++ Reading +++
+        /**
+         * @brief Waits for the next chunk of output.
+         *
+         * @param chunk Receives the chunk. The previous contents are discarded.
+         *
+         * @return true If a chunk was received.
+         * @return false If the child closed its output.
+         *
+         * @throws std::system_error If reading from the pipe failed.
+         */
+        bool next(string& chunk);
+
+        /**
+         * @brief Takes the next chunk of output if one is queued, without waiting.
+         *
+         * @param chunk Receives the chunk. The previous contents are discarded.
+         *
+         * @return true If a chunk was received.
+         * @return false If no chunk is queued; @see isDrained() tells whether more will follow (or reports the error).
+         */
+        bool tryNext(string& chunk);
+
+        /**
+         * @brief Indicates whether the child closed its output and every chunk was taken.
+         *
+         * @throws std::system_error If reading from the pipe failed.
+         */
+        bool isDrained();
+
+        /**
+         * @brief Waits for the child to exit.
+         *
+         * @return int32_t The child's exit code, or -1 if it was terminated by a signal.
+         */
+        int32_t wait();
+
+    private: // +++ Member functions +++
+        void produce();
+
+    private: // +++ Members +++
+        pid_t                   m_pid = -1; //!< The child's process ID (-1 once reaped)
+        int32_t                 m_pipeFd = -1; //!< The read end of the child's stdout
+        int32_t                 m_exitCode = -1; //!< The child's exit code once reaped
+        bool                    m_isFinished = false; //!< Whether the producer saw the end of the output (or failed)
+        bool                    m_isStopRequested = false; //!< Whether the consumer gave up on the output
+        std::exception_ptr      m_error; //!< The error which ended the producer, if any
+        std::deque<string>      m_chunks; //!< The chunks waiting for the consumer
+        std::mutex              m_mutex; //!< Protects the queue and the flags above
+        std::condition_variable m_chunkAvailable; //!< Signalled when a chunk was queued or the producer finished
+        std::condition_variable m_spaceAvailable; //!< Signalled when a chunk was taken or a stop was requested
+        ReadyCallback           m_onReady; //!< Called when a chunk was queued or the producer finished
+        std::thread             m_producer; //!< Reads the pipe
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_CHILD_READER_HPP
@@ -0,0 +1,129 @@
+/**
+ * @file cidr_trie.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of a compressed, popcount-indexed prefix trie for CIDR exclusion lists.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_CIDR_TRIE_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_CIDR_TRIE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ip_address.hpp"
+#include "mapped_file.hpp"
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief A set of IPv4/IPv6 CIDR ranges which answers "is this address in any of the ranges?".
+ *
+ * All ranges are stored in the IPv6 address space (IPv4 ranges as IPv4-mapped ranges). The trie is a multibit trie with
+ * a stride of up to 6 bits per node: each node holds a 64-bit bitmap of child slots and a 64-bit bitmap of slots which are
+ * entirely covered by a range. Children are stored contiguously, so the index of a child is the node's child base plus the
+ * popcount of the child bitmap below the slot. Chains of single-child nodes are path-compressed into a skip of up to 64 bits.
+ *
+ * A lookup therefore costs one 32 byte node (half a cache line) per 6 bits of distinguishing prefix, and typically a
+ * handful of nodes in total. The node array is position-independent and can be written to and mapped from a binary image.
+ */
+class CidrTrie {
+    public: // +++ Types +++
+        /**
+         * @brief A CIDR range in the IPv6 address space.
+         */
+        struct Prefix {
+            IpAddress   address; //!< The network address
+            uint8_t     length; //!< The prefix length (0-128; IPv4 ranges are offset by 96)
+        };
+
+        /**
+         * @brief A single trie node. Public for the sake of the on-disk image only.
+         */
+        struct Node {
+            uint64_t    children; //!< Slots which have a child node
+            uint64_t    leaves; //!< Slots which are entirely covered by a range
+            uint64_t    skipValue; //!< The bits which must match before this node's stride (right-aligned)
+            uint32_t    childBase; //!< The index of the first child node
+            uint8_t     skipLength; //!< The amount of bits in @see skipValue
+            uint8_t     stride; //!< The amount of address bits consumed by this node (1-6)
+            uint16_t    reserved; //!< Padding
+        };
+
+    public: // +++ Constructors +++
+        /**
+         * @brief Builds a trie from a list of ranges.
+         *
+         * @param prefixes The ranges to include.
+         */
+        explicit CidrTrie(const std::vector<Prefix>& prefixes);
+
+        /**
+         * @brief Loads a trie from a file, which is either a compiled image (see @see writeImage) or a text file with
+         * one CIDR range (or address) per line. Empty lines and lines starting with '#' are ignored.
+         *
+         * @param path The path to the file.
+         *
+         * @return CidrTrie The loaded trie.
+         *
+         * @throws std::system_error If the file can't be read.
+         * @throws std::runtime_error If the file contains invalid ranges or is a damaged image.
+         */
+        static CidrTrie load(const string& path);
+
+    public: // +++ Lookup +++
+        /**
+         * @brief Determines whether an address is covered by any of the ranges.
+         *
+         * @param address The address to look up.
+         *
+         * @return true If the address is in one of the ranges.
+         * @return false Otherwise.
+         */
+        bool contains(const IpAddress& address) const;
+
+    public: // +++ Serialisation +++
+        /**
+         * @brief Writes the trie to a binary image, which can later be loaded (mapped) by @see load.
+         *
+         * @param path The path of the image to write. The image is written to a temporary file and renamed into place.
+         *
+         * @throws std::system_error If the image can't be written.
+         */
+        void writeImage(const string& path) const;
+
+        /**
+         * @brief Parses a CIDR range ("192.0.2.0/24", "2001:db8::/32") or a single address.
+         *
+         * @param text The text to parse.
+         * @param out The parsed range. Host bits beyond the prefix length are cleared.
+         *
+         * @return true If the text is a valid range.
+         * @return false Otherwise.
+         */
+        static bool parsePrefix(string_view text, Prefix& out);
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets the amount of nodes in the trie.
+         */
+        size_t nodeCount() const { return m_nodeCount; }
+
+    private: // +++ Constructor +++
+        CidrTrie(MappedFile&& image, const Node* nodes, size_t nodeCount);
+
+    private: // +++ Members +++
+        std::vector<Node>               m_ownedNodes; //!< The nodes (if built in memory)
+        std::unique_ptr<MappedFile>     m_image; //!< The mapped image (if loaded from an image)
+        const Node*                     m_nodes = nullptr; //!< The node array, root first
+        size_t                          m_nodeCount = 0; //!< The amount of nodes
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_CIDR_TRIE_HPP
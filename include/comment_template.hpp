@@ -0,0 +1,112 @@
+/**
+ * @file comment_template.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the precompiled report comment.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_COMMENT_TEMPLATE_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_COMMENT_TEMPLATE_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief The report comment (-c), compiled into a list of segments.
+ *
+ * The comment is parsed once, into literal text and the variables it uses. Values which are the same for many rows (the
+ * hostname, the report time of a run, a jail's name) are bound ahead of time, which renders them into the neighbouring
+ * text; a comment bound to all of its variables is a single string, and rendering a row's comment is a single append.
+ * Only the variables left unbound are formatted per row.
+ *
+ * Variables are written like fmt's positional arguments ("{0}", "{1:>8}"); "{{" and "}}" are literal braces. Since the
+ * comment is quoted in the CSV, double quotes are doubled while rendering.
+ */
+class CommentTemplate {
+    public: // +++ Types +++
+        /**
+         * @brief The variables available in a comment; the value is the variable's index.
+         */
+        enum class Field: uint8_t {
+            Jails = 0, //!< The jail(s) the IP is banned in
+            ReportTime, //!< The report time
+            BanTime, //!< The time the IP was banned
+            Failures, //!< The amount of failures which led to the ban
+            Hostname, //!< The name of the reporting host
+            Hosts, //!< The amount of hosts which banned the IP
+            COUNT
+        };
+
+        /**
+         * @brief The values of the variables, indexed by @see Field.
+         */
+        using Values = std::array<string_view, static_cast<size_t>(Field::COUNT)>;
+
+    public: // +++ Constructor +++
+        CommentTemplate() = default;
+
+        /**
+         * @brief Compiles a comment.
+         *
+         * @param format The comment, as passed to -c.
+         *
+         * @throws std::runtime_error If the comment is malformed or uses an unknown variable.
+         */
+        explicit CommentTemplate(string_view format);
+
+    public: // +++ Binding +++
+        /**
+         * @brief Creates a copy of the template with a variable replaced by a fixed value.
+         *
+         * @param field The variable to replace.
+         * @param value The value to render in its place.
+         *
+         * @return CommentTemplate The new template.
+         */
+        CommentTemplate bind(Field field, string_view value) const;
+
+        /**
+         * @brief Whether or not the template still contains a variable.
+         */
+        bool uses(Field field) const;
+
+    public: // +++ Rendering +++
+        /**
+         * @brief Appends the comment to a buffer.
+         *
+         * @param buffer The buffer to append the comment to.
+         * @param values The values of the variables which aren't bound (all others are ignored).
+         */
+        void render(fmt::memory_buffer& buffer, const Values& values = {}) const;
+
+    private: // +++ Types +++
+        /**
+         * @brief A run of literal text, or a variable.
+         */
+        struct Segment {
+            bool    isVariable; //!< Whether the segment is a variable
+            Field   field; //!< The variable (if isVariable)
+            string  text; //!< The literal text (already escaped), or the variable's format ("{:spec}"; empty without spec)
+        };
+
+    private: // +++ Member functions +++
+        void appendLiteral(string_view text);
+        void appendEscapedText(string_view text);
+        static void appendValue(fmt::memory_buffer& buffer, const Segment& segment, string_view value);
+
+    private: // +++ Members +++
+        std::vector<Segment>    m_segments; //!< The segments, in order
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_COMMENT_TEMPLATE_HPP
@@ -0,0 +1,172 @@
+/**
+ * @file compression.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declarations of the streaming (de)compression used for archived output.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_COMPRESSION_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_COMPRESSION_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief The supported compression formats.
+ */
+enum class Compression {
+    None, //!< Plain text
+    Gzip, //!< gzip (zlib)
+    Zstd //!< Zstandard (only if built with libzstd)
+};
+
+/**
+ * @brief Whether or not the application was built with support for a compression format.
+ */
+bool isCompressionSupported(Compression compression);
+
+/**
+ * @brief Parses the name of a compression format ("none", "gzip"/"gz", "zstd"/"zst").
+ *
+ * @param name The name to parse.
+ * @param out The format.
+ *
+ * @return true If the name is known.
+ * @return false Otherwise.
+ */
+bool parseCompression(string_view name, Compression& out);
+
+/**
+ * @brief Determines the compression format from a file's extension (".gz", ".zst"; anything else is plain text).
+ */
+Compression compressionForPath(string_view path);
+
+/**
+ * @brief Determines the compression format of data from its magic bytes.
+ */
+Compression detectCompression(string_view data);
+
+/**
+ * @brief Decompresses data (in any supported format, detected from its magic bytes) chunk by chunk.
+ *
+ * @remarks Uncompressed data is passed on as is, in one piece. Concatenated gzip members and zstd frames are read as one
+ * stream, so archives which were appended to decompress completely.
+ *
+ * @param data The (complete) compressed data, e.g. a mapped file.
+ * @param onChunk Receives the decompressed data; the view is only valid for the duration of the call.
+ *
+ * @throws std::runtime_error If the data is damaged or truncated, or its format isn't supported by this build.
+ */
+void decompress(string_view data, const std::function<void(string_view)>& onChunk);
+
+/**
+ * @brief Writes a stream to a file, compressing it on a separate thread.
+ *
+ * Data is collected into one of two blocks while the other one is compressed and written by the worker thread, so the
+ * caller only ever waits for the worker if compression falls behind. @see flush() pushes everything written so far out
+ * to the file as a complete, decompressible prefix of the stream (e.g. for watch mode).
+ */
+class CompressedWriter {
+    public: // +++ Types +++
+        /**
+         * @brief How far a block ends the stream.
+         */
+        enum class BlockEnd {
+            Continue, //!< More data follows
+            Flush, //!< More data follows, but everything so far must be decompressible
+            Finish //!< The stream ends
+        };
+
+        /**
+         * @brief A compression format's encoder (defined in the implementation).
+         */
+        struct Encoder;
+
+    public: // +++ Constants +++
+        static constexpr size_t BLOCK_SIZE = 1024 * 1024; //!< The size of each of the two blocks
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Creates (or truncates) the file and starts the worker thread.
+         *
+         * @param path The file to write to.
+         * @param compression The compression format.
+         *
+         * @throws std::system_error If the file can't be created.
+         * @throws std::runtime_error If the compression format isn't supported by this build.
+         */
+        CompressedWriter(const string& path, Compression compression);
+
+        CompressedWriter(const CompressedWriter&) = delete;
+        CompressedWriter& operator=(const CompressedWriter&) = delete;
+
+        /**
+         * @brief Finishes the stream. Errors are ignored; call @see finish() beforehand to handle them.
+         */
+        ~CompressedWriter();
+
+    public: // +++ Writing +++
+        /**
+         * @brief Appends data to the stream.
+         *
+         * @throws std::exception If compressing or writing an earlier block failed.
+         */
+        void write(string_view data);
+
+        /**
+         * @brief Compresses and writes everything appended so far, and waits until it has been written.
+         *
+         * @throws std::exception If compressing or writing failed.
+         */
+        void flush();
+
+        /**
+         * @brief Ends the stream, waits for the worker and closes the file. Nothing may be written afterwards.
+         *
+         * @throws std::exception If compressing, writing or closing the file failed.
+         */
+        void finish();
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets the amount of (uncompressed) bytes appended so far.
+         */
+        uint64_t bytesIn() const { return m_bytesIn; }
+
+    private: // +++ Member functions +++
+        void submit(BlockEnd blockEnd);
+        void waitForWorker(std::unique_lock<std::mutex>& lock);
+        void runWorker();
+
+    private: // +++ Members +++
+        int32_t                     m_fd = -1; //!< The file
+        std::unique_ptr<Encoder>    m_encoder; //!< Compresses the blocks
+        std::vector<char>           m_blocks[2]; //!< The block being filled and the block being compressed
+        size_t                      m_fillingBlock = 0; //!< The index of the block being filled
+        uint64_t                    m_bytesIn = 0; //!< The amount of bytes appended
+        bool                        m_isFinished = false; //!< Whether the stream was ended
+
+        std::mutex                  m_mutex; //!< Guards the members below
+        std::condition_variable     m_condition; //!< Signals submitted and completed blocks
+        bool                        m_hasPendingBlock = false; //!< Whether the worker has a block to compress
+        BlockEnd                    m_pendingBlockEnd = BlockEnd::Continue; //!< How the pending block ends the stream
+        std::exception_ptr          m_error; //!< The worker's error, if any
+
+        std::thread                 m_worker; //!< Compresses and writes the submitted blocks
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_COMPRESSION_HPP
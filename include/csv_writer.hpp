@@ -0,0 +1,187 @@
+/**
+ * @file csv_writer.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the buffered, streaming CSV emitter.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_CSV_WRITER_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_CSV_WRITER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <utility>
+
+#include <fmt/format.h>
+
+using std::string_view;
+
+/**
+ * @brief Streams abuseipdb CSV rows to a file descriptor or a batch sink.
+ *
+ * Rows are formatted straight into a single, reusable write buffer, which is handed to write(2) (or the sink) whenever
+ * it exceeds the configured size. Rows are never stored individually and no flush happens per row.
+ */
+class CsvWriter {
+    public: // +++ Types +++
+        /**
+         * @brief Receives the buffered data on every flush; the data always consists of complete rows.
+         */
+        using BatchSink = std::function<void(string_view rows, size_t rowCount)>;
+
+    public: // +++ Constants +++
+        static constexpr size_t DEFAULT_BUFFER_SIZE = 1024 * 1024; //!< The default flush threshold (1MiB)
+        static constexpr string_view CSV_HEADER = "IP,Categories,ReportDate,Comment\n"; //!< The header expected by abuseipdb
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Constructs a new writer.
+         *
+         * @param fd The file descriptor to write to. The descriptor is not closed by the writer.
+         * @param bufferSize The amount of bytes to accumulate before writing them out.
+         */
+        explicit CsvWriter(int32_t fd, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+        /**
+         * @brief Constructs a new writer which hands batches of rows to a sink.
+         *
+         * @param sink The sink receiving the batches.
+         * @param maxBatchRows The maximum amount of rows per batch.
+         * @param maxBatchBytes The maximum size of a batch in bytes. A single row exceeding this is passed on by itself.
+         */
+        CsvWriter(BatchSink sink, size_t maxBatchRows, size_t maxBatchBytes);
+
+        CsvWriter(const CsvWriter&) = delete;
+        CsvWriter& operator=(const CsvWriter&) = delete;
+
+        CsvWriter(CsvWriter&&) = default;
+
+        /**
+         * @brief Flushes any remaining data. Errors are ignored; call @see flush() beforehand to handle them.
+         */
+        ~CsvWriter();
+
+    public: // +++ Writing +++
+        /**
+         * @brief Writes the CSV header.
+         */
+        void writeHeader() { append(CSV_HEADER); }
+
+        /**
+         * @brief Writes a single row.
+         *
+         * @param ip The reported IP.
+         * @param categories The comma-separated list of categories.
+         * @param reportDate The (pre-formatted) report date.
+         * @param comment The comment.
+         */
+        void writeRow(string_view ip, string_view categories, string_view reportDate, string_view comment) {
+            writeRow(ip, categories, reportDate, [&](fmt::memory_buffer& buffer) { buffer.append(comment); });
+        }
+
+        /**
+         * @brief Writes a single row, rendering the comment directly into the write buffer.
+         *
+         * @param ip The reported IP.
+         * @param categories The comma-separated list of categories.
+         * @param reportDate The (pre-formatted) report date.
+         * @param writeComment A callable which appends the comment to the given buffer.
+         */
+        template<typename CommentWriter>
+        void writeRow(string_view ip, string_view categories, string_view reportDate, CommentWriter&& writeComment) {
+            const auto rowStart = m_buffer.size();
+            formatRow(m_buffer, ip, categories, reportDate, std::forward<CommentWriter>(writeComment));
+            commitRow(rowStart);
+        }
+
+        /**
+         * @brief Writes a single row which was rendered elsewhere through @see formatRow().
+         *
+         * @param row The complete row, including the line terminator.
+         */
+        void appendRow(string_view row) {
+            const auto rowStart = m_buffer.size();
+            m_buffer.append(row);
+            commitRow(rowStart);
+        }
+
+        /**
+         * @brief Renders a single row into an arbitrary buffer, e.g. a per-thread one.
+         *
+         * @param buffer The buffer to append the row to.
+         * @param ip The reported IP.
+         * @param categories The comma-separated list of categories.
+         * @param reportDate The (pre-formatted) report date.
+         * @param writeComment A callable which appends the comment to the given buffer.
+         */
+        template<typename CommentWriter>
+        static void formatRow(fmt::memory_buffer& buffer, string_view ip, string_view categories, string_view reportDate, CommentWriter&& writeComment) {
+            fmt::format_to(std::back_inserter(buffer), R"({0:s},"{1:s}",{2:s},")", ip, categories, reportDate);
+            writeComment(buffer);
+            buffer.append(string_view("\"\n"));
+        }
+
+        /**
+         * @brief Appends raw data to the output.
+         *
+         * @param data The data to append.
+         */
+        void append(string_view data) {
+            m_buffer.append(data);
+            if (m_buffer.size() >= m_bufferSize) { flush(); }
+        }
+
+        /**
+         * @brief Writes all buffered data to the file descriptor (or passes it to the sink).
+         *
+         * @throws std::system_error If writing fails.
+         */
+        void flush() { flushPrefix(m_buffer.size(), m_bufferedRows); }
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets the amount of rows written so far (excluding the header).
+         */
+        size_t rowsWritten() const { return m_rowsWritten; }
+
+        /**
+         * @brief Gets the amount of bytes passed to write(2) (or the sink) so far.
+         */
+        size_t bytesWritten() const { return m_bytesWritten; }
+
+    private: // +++ Member functions +++
+        /**
+         * @brief Accounts for the row starting at rowStart and flushes as the limits require.
+         */
+        void commitRow(size_t rowStart) {
+            m_rowsWritten++;
+
+            if (m_buffer.size() > m_maxBatchBytes && m_bufferedRows > 0) {
+                // the new row doesn't fit into the current batch anymore; it starts the next one
+                flushPrefix(rowStart, m_bufferedRows);
+            }
+
+            m_bufferedRows++;
+            if (m_buffer.size() >= m_bufferSize || m_bufferedRows >= m_maxBatchRows) { flush(); }
+        }
+
+        void flushPrefix(size_t byteCount, size_t rowCount);
+
+    private: // +++ Members +++
+        BatchSink           m_sink; //!< Receives the flushed data
+        size_t              m_bufferSize; //!< The flush threshold
+        size_t              m_maxBatchRows = std::numeric_limits<size_t>::max(); //!< The maximum amount of rows per flush
+        size_t              m_maxBatchBytes = std::numeric_limits<size_t>::max(); //!< The maximum amount of bytes per flush
+        size_t              m_bufferedRows = 0; //!< The amount of rows in the buffer
+        size_t              m_rowsWritten = 0; //!< The amount of rows written
+        size_t              m_bytesWritten = 0; //!< The amount of bytes flushed
+        fmt::memory_buffer  m_buffer; //!< The reusable write buffer
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_CSV_WRITER_HPP
@@ -0,0 +1,97 @@
+/**
+ * @file f2b_database.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the reader for fail2ban's SQLite database.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_F2B_DATABASE_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_F2B_DATABASE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+struct sqlite3;
+
+/**
+ * @brief Reads bans straight from fail2ban's database, without fail2ban-client and without elevated privileges (as long
+ * as the database is readable).
+ *
+ * fail2ban records every ban in the `bans` table (jail, ip, timeofban, bantime, bancount, data), indexed by jail and time
+ * of ban. Bans are read jail by jail with a range query on that index, so a run only touches the bans in its window, no
+ * matter how long fail2ban's history is. Unlike fail2ban-client's output, the rows carry the time of the ban and (in
+ * `data`) the amount of failures which led to it.
+ *
+ * @remarks The database is opened read-only; fail2ban may keep writing to it meanwhile.
+ */
+class Fail2BanDatabase {
+    public: // +++ Types and constants +++
+        /**
+         * @brief Callback invoked for each ban.
+         *
+         * @remarks The views passed to the callback are only valid for the duration of the call!
+         *
+         * @param jail The jail the IP was banned in.
+         * @param ip The banned IP.
+         * @param banTime When the IP was banned (UNIX time).
+         * @param failures The amount of failures which led to the ban (-1 if the database doesn't say).
+         */
+        using BanCallback = std::function<void(string_view jail, string_view ip, int64_t banTime, int32_t failures)>;
+
+        static constexpr string_view DEFAULT_DATABASE_PATH = "/var/lib/fail2ban/fail2ban.sqlite3"; //!< fail2ban's default dbfile
+        static constexpr int32_t BUSY_TIMEOUT_MS = 5000; //!< How long to wait for fail2ban to finish writing
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Opens fail2ban's database.
+         *
+         * @param path The path to the database.
+         *
+         * @throws std::runtime_error If the database can't be opened or doesn't contain fail2ban's tables.
+         */
+        explicit Fail2BanDatabase(const string& path);
+
+        Fail2BanDatabase(const Fail2BanDatabase&) = delete;
+        Fail2BanDatabase& operator=(const Fail2BanDatabase&) = delete;
+
+        ~Fail2BanDatabase();
+
+    public: // +++ Reading +++
+        /**
+         * @brief Gets the names of the jails known to fail2ban.
+         *
+         * @throws std::runtime_error If the query fails.
+         */
+        std::vector<string> jails() const;
+
+        /**
+         * @brief Reads the bans of a jail within a time window, oldest first.
+         *
+         * @param jail The jail to read the bans of.
+         * @param after Only bans after this point in time (exclusive) are read.
+         * @param before Only bans before this point in time (exclusive) are read.
+         * @param activeOnly Whether to skip bans which expired before @p before (only with fail2ban 0.11+, which records
+         * the ban time; older databases return all bans in the window).
+         * @param callback The callback to invoke for every ban.
+         *
+         * @return size_t The amount of bans read.
+         *
+         * @throws std::runtime_error If the query fails.
+         */
+        size_t readBans(string_view jail, int64_t after, int64_t before, bool activeOnly, const BanCallback& callback) const;
+
+    private: // +++ Members +++
+        sqlite3*    m_database = nullptr; //!< The database connection
+        bool        m_hasBanTime = false; //!< Whether the bans table has a bantime column (fail2ban 0.11+)
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_F2B_DATABASE_HPP
@@ -0,0 +1,55 @@
+/**
+ * @file f2b_log.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declarations for parsing ban/unban events from fail2ban's log.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_F2B_LOG_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_F2B_LOG_HPP
+
+#include <string_view>
+
+using std::string_view;
+
+/**
+ * @brief A ban or unban event read from fail2ban's log.
+ *
+ * @remarks All views reference the parsed line.
+ */
+struct LogEvent {
+    /**
+     * @brief The kind of event.
+     */
+    enum class Action {
+        Ban, //!< "[jail] Ban <ip>" or "[jail] Restore Ban <ip>"
+        Unban //!< "[jail] Unban <ip>"
+    };
+
+    Action      action; //!< The kind of event
+    string_view timestamp; //!< The timestamp at the start of the line ("YYYY-MM-DD HH:MM:SS,mmm"); may be empty
+    string_view jail; //!< The name of the jail
+    string_view ip; //!< The banned/unbanned IP
+};
+
+/**
+ * @brief Parses a single line of fail2ban.log.
+ *
+ * Recognised lines look like this:
+ * @code
+ * 2022-10-14 12:34:56,789 fail2ban.actions        [1234]: NOTICE  [sshd] Ban 192.0.2.1
+ * 2022-10-14 13:34:56,789 fail2ban.actions        [1234]: NOTICE  [sshd] Unban 192.0.2.1
+ * @endcode
+ *
+ * @param line The line to parse (without the line terminator).
+ * @param out The parsed event.
+ *
+ * @return true If the line is a ban or unban event.
+ * @return false Otherwise.
+ */
+bool parseLogLine(string_view line, LogEvent& out);
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_F2B_LOG_HPP
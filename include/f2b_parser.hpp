@@ -0,0 +1,138 @@
+/**
+ * @file f2b_parser.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of an incremental tokenizer for fail2ban's Python-repr (quasi-JSON) output.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_F2B_PARSER_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_F2B_PARSER_HPP
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief Exception thrown by @see Fail2BanParser when the input is malformed.
+ */
+struct Fail2BanParseError: std::runtime_error {
+    /**
+     * @brief Constructs a new parse error.
+     *
+     * @param what A description of the error.
+     * @param offset The offset (in bytes, from the start of the input) at which the error occurred.
+     */
+    Fail2BanParseError(const string& what, size_t offset): std::runtime_error(what + " (at offset " + std::to_string(offset) + ")"), m_offset(offset) {}
+
+    /**
+     * @brief Gets the offset at which the error occurred.
+     */
+    size_t offset() const { return m_offset; }
+
+    private:
+        size_t m_offset; //!< The offset of the offending byte
+};
+
+/**
+ * @brief Incremental, single-pass tokenizer for the output of `fail2ban-client banned` and `fail2ban-client get <jail> banned`.
+ *
+ * The tokenizer understands Python's repr format directly (single- or double-quoted strings), so no quote-rewrite pass
+ * and no intermediate document are required.
+ * Input may be fed in arbitrarily sized chunks; each (jail, ip) pair is passed to the callback as soon as it has been read.
+ * Tokens are handed out as views into the fed chunk; only tokens spanning two chunks, and jail names which outlive their chunk,
+ * are copied. Feeding the complete input (e.g. a memory-mapped file) in one go is therefore entirely zero-copy.
+ *
+ * Supported inputs:
+ *  - `[{'sshd': ['1.2.3.4', '5.6.7.8']}, {'postfix': []}]` (complete output; jail names are taken from the keys)
+ *  - `['1.2.3.4', '5.6.7.8']` (single jail; the default jail name is used)
+ *
+ * @remarks Memory usage is bounded by @see MAX_DEPTH and @see MAX_TOKEN_LENGTH, regardless of the size of the input.
+ */
+class Fail2BanParser {
+    public: // +++ Types and constants +++
+        /**
+         * @brief Callback invoked for each banned IP.
+         *
+         * @remarks The views passed to the callback are only valid for the duration of the call!
+         */
+        using BanCallback = std::function<void(string_view jail, string_view ip)>;
+
+        static constexpr size_t MAX_DEPTH = 16; //!< The maximum nesting depth of containers
+        static constexpr size_t MAX_TOKEN_LENGTH = 4096; //!< The maximum length of a single string token
+
+    public: // +++ Constructor +++
+        /**
+         * @brief Constructs a new parser.
+         *
+         * @param callback The callback to invoke for every banned IP.
+         * @param defaultJail The jail name to use when the input does not contain jail names.
+         */
+        Fail2BanParser(BanCallback callback, string_view defaultJail);
+
+    public: // +++ Parsing +++
+        /**
+         * @brief Feeds the next chunk of input into the parser.
+         *
+         * @param chunk The next chunk of input. Does not need to end on a token boundary.
+         *
+         * @throws Fail2BanParseError If the input is malformed.
+         */
+        void feed(string_view chunk);
+
+        /**
+         * @brief Signals the end of the input.
+         *
+         * @throws Fail2BanParseError If the input ended prematurely.
+         */
+        void finish();
+
+        /**
+         * @brief Gets the amount of bytes consumed so far.
+         */
+        size_t bytesConsumed() const { return m_offset; }
+
+    private: // +++ Types +++
+        /**
+         * @brief A single level of container nesting.
+         */
+        struct Frame {
+            bool isDict; //!< Whether this frame is a dictionary (true) or a list/tuple (false)
+            bool expectKey; //!< (dict) Whether the next string is a key
+        };
+
+    private: // +++ Member functions +++
+        void onToken(string_view token);
+        void keepAlive(string_view source);
+        void openContainer(bool isDict, size_t chunkOffset);
+        void closeContainer(char c, size_t chunkOffset);
+        [[noreturn]] void fail(const string& what, size_t chunkOffset) const;
+
+    private: // +++ Members +++
+        BanCallback m_callback; //!< The callback for banned IPs
+        string m_defaultJail; //!< The jail name to use for unnamed lists
+        string_view m_key; //!< The last dictionary key read
+        string_view m_jail; //!< The name of the current jail
+        string m_keyStorage; //!< Backing storage for @see m_key if it outlives its chunk
+        string m_jailStorage; //!< Backing storage for @see m_jail if it outlives its chunk
+        string m_carry; //!< Holds a string token which spans multiple chunks (prefixed by a marker byte)
+
+        std::array<Frame, MAX_DEPTH> m_stack{}; //!< The container stack
+        size_t m_depth = 0; //!< The current nesting depth
+        size_t m_offset = 0; //!< The amount of bytes consumed before the current chunk
+        size_t m_namedJailDepth = 0; //!< The depth of the innermost named jail list (0 if none)
+        bool m_seenContainer = false; //!< Whether at least one container was opened
+        bool m_inString = false; //!< Whether the parser is currently inside a string token
+        bool m_escaped = false; //!< Whether the previous character was a backslash
+        char m_quote = 0; //!< The quote character which opened the current string
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_F2B_PARSER_HPP
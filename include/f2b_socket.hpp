@@ -0,0 +1,109 @@
+/**
+ * @file f2b_socket.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of a client for fail2ban's control socket.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_F2B_SOCKET_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_F2B_SOCKET_HPP
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief Thrown if fail2ban answers a command with an error, or its answer can't be decoded.
+ */
+class Fail2BanSocketError: public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Talks to fail2ban-server through its control socket, the same way fail2ban-client does.
+ *
+ * Commands are sent as pickled lists of strings, terminated by "<F2B_END_COMMAND>"; the server answers with a pickled
+ * (return code, result) tuple using the same terminator. Answers are decoded as they arrive. Results are either rendered
+ * as the Python literal fail2ban-client would print (e.g. `[{'sshd': ['192.0.2.1']}]`), so they can be fed to the
+ * @see Fail2BanParser as-is, or, for ban lists, passed on address by address without ever being held as a whole.
+ */
+class Fail2BanSocket {
+    public: // +++ Types / Constants +++
+        /**
+         * @brief Callback receiving the rendered result in chunks.
+         */
+        using ChunkCallback = std::function<void(string_view chunk)>;
+
+        /**
+         * @brief Callback receiving each banned address, along with its jail.
+         */
+        using BanCallback = std::function<void(string_view jail, string_view address)>;
+
+        static constexpr const char* DEFAULT_SOCKET_PATH = "/var/run/fail2ban/fail2ban.sock"; //!< fail2ban's default socket
+        static constexpr int32_t     TIMEOUT_SECONDS = 30; //!< The maximum time to wait for the server
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Connects to fail2ban's control socket.
+         *
+         * @param path The path to the socket.
+         *
+         * @throws std::system_error If the socket can't be connected to.
+         */
+        explicit Fail2BanSocket(const string& path);
+
+        Fail2BanSocket(const Fail2BanSocket&) = delete;
+        Fail2BanSocket& operator=(const Fail2BanSocket&) = delete;
+
+        /**
+         * @brief Tells the server the connection is being closed and closes it.
+         */
+        ~Fail2BanSocket();
+
+    public: // +++ Commands +++
+        /**
+         * @brief Sends a command and passes the rendered result to the callback.
+         *
+         * @param command The command and its arguments (e.g. { "banned" }).
+         * @param callback The callback receiving the rendered result.
+         *
+         * @throws std::system_error If sending or receiving fails.
+         * @throws Fail2BanSocketError If the server reports an error or the answer can't be decoded.
+         */
+        void send(const std::vector<string>& command, const ChunkCallback& callback);
+
+        /**
+         * @brief Sends a command answered with a ban list and passes each address to the callback while the answer is
+         * still being received.
+         *
+         * @param command The command and its arguments (e.g. { "banned" } or { "get", "sshd", "banned" }).
+         * @param defaultJail The jail of addresses which aren't listed under a jail's name (e.g. for "get <jail> banned").
+         * @param callback The callback receiving the addresses.
+         *
+         * @throws std::system_error If sending or receiving fails.
+         * @throws Fail2BanSocketError If the server reports an error or the answer isn't a ban list.
+         */
+        void queryBans(const std::vector<string>& command, string_view defaultJail, const BanCallback& callback);
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets the amount of bytes received from the server so far.
+         */
+        uint64_t bytesReceived() const { return m_bytesReceived; }
+
+    private: // +++ Members +++
+        int32_t  m_fd = -1; //!< The connected socket
+        uint64_t m_bytesReceived = 0; //!< The amount of bytes received so far
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_F2B_SOCKET_HPP
@@ -0,0 +1,145 @@
+/**
+ * @file host_aggregator.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the aggregator merging the ban lists of many hosts.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_HOST_AGGREGATOR_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_HOST_AGGREGATOR_HPP
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ip_address.hpp"
+
+using std::string;
+using std::string_view;
+
+class ThreadPool;
+
+/**
+ * @brief Merges the `banned` exports of many hosts into one list of unique IPs, which remembers the jails each IP is
+ * banned in and how many hosts banned it.
+ *
+ * Each host's export is parsed on a thread pool into a list of (IP, jail) pairs sorted by IP. The sorted lists of a batch
+ * of hosts are then k-way merged with the IPs aggregated so far (sorted as well), so memory is bounded by the unique IPs
+ * plus one batch of hosts, however many hosts there are. The merge itself runs in parallel: the address space is split
+ * into ranges at quantiles of the largest list, and each range is merged on its own.
+ *
+ * Jail sets are interned as in @see IpDeduplicator; the IDs used in the results are the aggregator's own. Partitions
+ * only read the interned sets; sets they create are interned once all partitions are merged.
+ */
+class HostAggregator {
+    public: // +++ Types and constants +++
+        /**
+         * @brief A unique IP.
+         */
+        struct Entry {
+            IpAddress   address; //!< The IP
+            uint32_t    jailSet; //!< The ID of the set of jails the IP is banned in (on any host)
+            uint32_t    hostCount; //!< The amount of hosts which banned the IP
+        };
+
+        /**
+         * @brief Callback invoked for each host which couldn't be read or parsed (completely).
+         *
+         * @param path The host's export.
+         * @param error A description of the error.
+         */
+        using ErrorCallback = std::function<void(const string& path, const string& error)>;
+
+        static constexpr size_t MIN_BATCH_SIZE = 16; //!< The minimum amount of hosts parsed before they're merged
+        static constexpr size_t MIN_PARTITION_SIZE = 64 * 1024; //!< The minimum amount of IPs worth merging on another thread
+
+    public: // +++ Constructor +++
+        /**
+         * @brief Creates an empty aggregator.
+         *
+         * @param defaultJail The jail name for exports which contain a single jail's IPs (as with -j).
+         */
+        explicit HostAggregator(string_view defaultJail);
+
+    public: // +++ Aggregating +++
+        /**
+         * @brief Expands directories to the files they contain (in lexical order; not recursively).
+         *
+         * @param paths The files and directories to expand.
+         *
+         * @return std::vector<string> The files.
+         *
+         * @throws std::filesystem::filesystem_error If a path doesn't exist or a directory can't be read.
+         */
+        static std::vector<string> expandInputs(const std::vector<string>& paths);
+
+        /**
+         * @brief Parses the exports of hosts (plain or compressed, like -f) and merges their IPs into the results.
+         *
+         * @remarks The IPs a host's export contains up to a parse error are kept.
+         *
+         * @param files The hosts' exports, one file per host.
+         * @param threadPool The pool to parse and merge on.
+         * @param onError The callback to invoke for each host which failed (on the calling thread).
+         */
+        void aggregate(const std::vector<string>& files, ThreadPool& threadPool, const ErrorCallback& onError);
+
+    public: // +++ Results +++
+        /**
+         * @brief Gets the unique IPs, sorted by address.
+         */
+        const std::vector<Entry>& entries() const { return m_entries; }
+
+        /**
+         * @brief Gets the IDs of the jails in a set, in ascending order.
+         */
+        const std::vector<uint32_t>& jailSet(uint32_t jailSet) const { return m_jailSets[jailSet]; }
+
+        /**
+         * @brief Gets the name of a jail.
+         */
+        const string& jailName(uint32_t jailId) const { return m_jailNames[jailId]; }
+
+        /**
+         * @brief Gets the amount of IPs which were skipped because they aren't valid addresses.
+         */
+        uint64_t invalidCount() const { return m_invalidCount; }
+
+    private: // +++ Types +++
+        /**
+         * @brief An IP banned on a host, in one of its jails.
+         */
+        struct HostBan {
+            IpAddress   address; //!< The IP
+            uint32_t    jailId; //!< The jail (the host's own ID while parsing, the aggregator's ID when merging)
+        };
+
+        struct Host;
+
+    private: // +++ Member functions +++
+        void parseHost(const string& path, Host& host) const;
+        void mergeBatch(std::vector<Host>& hosts, ThreadPool& threadPool);
+        void mergePartition(const Entry* entriesBegin, const Entry* entriesEnd, const std::vector<std::pair<const HostBan*, const HostBan*>>& hostRanges,
+                            std::vector<Entry>& out, std::vector<std::vector<uint32_t>>& newJailSets) const;
+        uint32_t internJailSet(std::vector<uint32_t>& jails);
+        uint32_t globalJailId(const string& jail);
+
+    private: // +++ Members +++
+        string                                      m_defaultJail; //!< The jail name for single-jail exports
+        std::vector<Entry>                          m_entries; //!< The unique IPs aggregated so far, sorted by address
+        std::vector<string>                         m_jailNames; //!< The jail names by ID
+        std::unordered_map<string, uint32_t>        m_jailIds; //!< Maps jail names to IDs
+        std::vector<std::vector<uint32_t>>          m_jailSets; //!< The jail sets by ID
+        std::map<std::vector<uint32_t>, uint32_t>   m_jailSetIds; //!< Maps jail sets to IDs
+        std::vector<uint32_t>                       m_singleJailSets; //!< The IDs of the sets containing a single jail, by jail ID
+        uint64_t                                    m_invalidCount = 0; //!< The amount of invalid IPs skipped
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_HOST_AGGREGATOR_HPP
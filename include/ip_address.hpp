@@ -0,0 +1,111 @@
+/**
+ * @file ip_address.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of a packed, binary IPv4/IPv6 address.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_IP_ADDRESS_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_IP_ADDRESS_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief A 128-bit, network byte order IP address.
+ *
+ * IPv4 addresses are stored as IPv4-mapped IPv6 addresses (::ffff:a.b.c.d), so both families share one key space.
+ */
+struct IpAddress {
+    std::array<uint8_t, 16> bytes{}; //!< The address in network byte order
+
+    /**
+     * @brief Parses an IPv4 or IPv6 address in textual form.
+     *
+     * Dotted quads are validated and converted with SSE2 where available (a scalar loop otherwise); leading zeros are
+     * read as decimal, so zero-padded addresses map to their canonical form. IPv6 addresses are parsed by inet_pton.
+     * @see toString() gives the canonical form of the result.
+     *
+     * @param text The textual representation of the address.
+     * @param out The parsed address.
+     *
+     * @return true If the text was a valid address.
+     * @return false Otherwise.
+     */
+    static bool parse(string_view text, IpAddress& out);
+
+    /**
+     * @brief Creates an address from an IPv4 address in host byte order.
+     */
+    static IpAddress fromV4(uint32_t address);
+
+    /**
+     * @brief Whether or not this is an (IPv4-mapped) IPv4 address.
+     */
+    bool isV4() const {
+        static constexpr uint8_t V4_PREFIX[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+        return std::memcmp(bytes.data(), V4_PREFIX, sizeof(V4_PREFIX)) == 0;
+    }
+
+    /**
+     * @brief Gets the upper 64 bits of the address in host byte order.
+     */
+    uint64_t high() const { return loadBigEndian(0); }
+
+    /**
+     * @brief Gets the lower 64 bits of the address in host byte order.
+     */
+    uint64_t low() const { return loadBigEndian(8); }
+
+    /**
+     * @brief Gets a well-mixed 64-bit hash of the address.
+     */
+    uint64_t hash() const {
+        uint64_t lo = 0, hi = 0;
+        std::memcpy(&hi, bytes.data(), sizeof(hi));
+        std::memcpy(&lo, bytes.data() + 8, sizeof(lo));
+        return mix(hi ^ mix(lo + 0x9e3779b97f4a7c15ull));
+    }
+
+    /**
+     * @brief Gets the canonical textual representation of the address (dotted quad for IPv4, RFC 5952 for IPv6).
+     */
+    string toString() const;
+
+    bool operator==(const IpAddress& other) const { return bytes == other.bytes; }
+    bool operator!=(const IpAddress& other) const { return bytes != other.bytes; }
+    bool operator<(const IpAddress& other) const { return bytes < other.bytes; }
+
+    private:
+        uint64_t loadBigEndian(size_t offset) const {
+            uint64_t value = 0;
+            for (size_t i = 0; i < 8; i++) { value = (value << 8) | bytes[offset + i]; }
+            return value;
+        }
+
+        static uint64_t mix(uint64_t x) {
+            // splitmix64 finaliser
+            x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27; x *= 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            return x;
+        }
+};
+
+/**
+ * @brief Hash functor for use in unordered containers.
+ */
+struct IpAddressHash {
+    size_t operator()(const IpAddress& address) const { return static_cast<size_t>(address.hash()); }
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_IP_ADDRESS_HPP
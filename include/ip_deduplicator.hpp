@@ -0,0 +1,168 @@
+/**
+ * @file ip_deduplicator.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the cross-jail IP deduplicator.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_IP_DEDUPLICATOR_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_IP_DEDUPLICATOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ip_address.hpp"
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief Details of a ban which only some inputs (fail2ban's database and logs, aggregated hosts) provide.
+ */
+struct BanDetails {
+    int64_t     banTime = 0; //!< When the IP was banned (UNIX time; 0 if unknown)
+    int32_t     failures = -1; //!< The amount of failures which led to the ban (-1 if unknown)
+    uint32_t    hostCount = 0; //!< The amount of hosts which banned the IP (0 if unknown)
+};
+
+/**
+ * @brief Collapses the banned IPs of all jails into one entry per IP, which remembers every jail the IP is banned in.
+ *
+ * The IPs are kept in a vector in order of first appearance; an open-addressing table of indices into that vector finds
+ * them again. Each slot also holds the upper half of its entry's hash, so probing past other IPs doesn't touch their
+ * entries, and a lookup usually costs one slot and, for IPs seen before, one entry.
+ *
+ * Rather than a list per IP, each entry holds the ID of an interned, sorted set of jails. IPs banned in the same jails
+ * share a set, and adding a jail to a set is a memoised transition, so an IP seen in a second jail costs one small hash
+ * lookup, however many IPs are banned there.
+ *
+ * With millions of IPs, the table is far larger than the CPU's caches and nearly every lookup misses. IPs are therefore
+ * inserted a few calls after they were added, once their slot has been prefetched; @see finish() inserts the rest.
+ *
+ * If the input provides @see BanDetails, they are kept alongside the entries; an IP banned several times keeps those
+ * of its most recent ban.
+ */
+class IpDeduplicator {
+    public: // +++ Types +++
+        /**
+         * @brief A unique IP.
+         */
+        struct Entry {
+            IpAddress   address; //!< The IP
+            uint32_t    jailSet; //!< The ID of the set of jails the IP is banned in
+        };
+
+    public: // +++ Constructor +++
+        /**
+         * @brief Constructs a new deduplicator.
+         *
+         * @param keepDetails Whether or not to keep the details passed to @see add() (@see details()).
+         */
+        explicit IpDeduplicator(bool keepDetails = false);
+
+    public: // +++ Collecting +++
+        /**
+         * @brief Gets the ID of a jail, assigning the next one if the jail is new.
+         *
+         * @param jail The name of the jail.
+         *
+         * @return uint32_t The jail's ID (IDs are assigned in order of first appearance).
+         */
+        uint32_t jailId(string_view jail);
+
+        /**
+         * @brief Records an IP as banned in a jail.
+         *
+         * @param address The banned IP.
+         * @param jailId The ID of the jail (@see jailId()).
+         * @param details The details of the ban (ignored unless details are kept).
+         */
+        void add(const IpAddress& address, uint32_t jailId, const BanDetails& details = {});
+
+        /**
+         * @brief Inserts the IPs still pending; must be called before reading the results.
+         */
+        void finish();
+
+    public: // +++ Results +++
+        /**
+         * @brief Gets the unique IPs, in order of first appearance.
+         */
+        const std::vector<Entry>& entries() const { return m_entries; }
+
+        /**
+         * @brief Gets the details of the unique IPs' most recent bans, by entry index (empty unless details are kept).
+         */
+        const std::vector<BanDetails>& details() const { return m_details; }
+
+        /**
+         * @brief Gets the amount of jail sets (valid IDs are 1 to jailSetCount() - 1; 0 is the empty set).
+         */
+        size_t jailSetCount() const { return m_jailSets.size(); }
+
+        /**
+         * @brief Gets the IDs of the jails in a set, in ascending order.
+         */
+        const std::vector<uint32_t>& jailSet(uint32_t jailSet) const { return m_jailSets[jailSet]; }
+
+        /**
+         * @brief Gets the name of a jail.
+         */
+        const string& jailName(uint32_t jailId) const { return m_jailNames[jailId]; }
+
+        /**
+         * @brief Gets the amount of jails.
+         */
+        size_t jailCount() const { return m_jailNames.size(); }
+
+        /**
+         * @brief Gets the amount of IPs added to a jail which had already been added before (to any jail).
+         */
+        uint64_t duplicateCount(uint32_t jailId) const { return m_duplicateCounts[jailId]; }
+
+    private: // +++ Types +++
+        /**
+         * @brief An IP waiting for its slot to be prefetched.
+         */
+        struct Pending {
+            IpAddress   address; //!< The IP
+            uint64_t    hash; //!< The IP's hash
+            uint32_t    jailId; //!< The jail the IP is banned in
+            BanDetails  details; //!< The details of the ban
+        };
+
+        static constexpr size_t PREFETCH_DISTANCE = 16; //!< The amount of IPs added before their slots are accessed
+
+    private: // +++ Member functions +++
+        void insert(const Pending& pending);
+        uint32_t withJail(uint32_t jailSet, uint32_t jailId);
+        void grow();
+
+    private: // +++ Members +++
+        std::vector<uint64_t>                       m_slots; //!< The upper half of an entry's hash and its index plus one (0 = empty)
+        size_t                                      m_slotMask = 0; //!< Mask selecting a slot from a hash
+        std::vector<Entry>                          m_entries; //!< The unique IPs in order of first appearance
+        std::vector<BanDetails>                     m_details; //!< The details of the entries' most recent bans (if kept)
+        bool                                        m_keepDetails = false; //!< Whether or not details are kept
+        std::vector<string>                         m_jailNames; //!< The jail names by ID
+        std::unordered_map<string, uint32_t>        m_jailIds; //!< Maps jail names to IDs
+        std::vector<std::vector<uint32_t>>          m_jailSets; //!< The jail sets by ID
+        std::map<std::vector<uint32_t>, uint32_t>   m_jailSetIds; //!< Maps jail sets to IDs
+        std::vector<uint32_t>                       m_singleJailSets; //!< The IDs of the sets containing a single jail, by jail ID (0 = none yet)
+        std::unordered_map<uint64_t, uint32_t>      m_transitions; //!< Maps (set ID, jail ID) to the ID of the set with the jail added
+        uint32_t                                    m_lastJailId = 0; //!< The ID returned by the last call to jailId()
+        std::vector<uint64_t>                       m_duplicateCounts; //!< The amount of duplicates per jail ID
+        std::array<Pending, PREFETCH_DISTANCE>      m_pending{}; //!< The IPs not inserted yet (a ring buffer)
+        size_t                                      m_pendingCount = 0; //!< The amount of pending IPs
+        size_t                                      m_nextPending = 0; //!< The position in m_pending the next IP goes to
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_IP_DEDUPLICATOR_HPP
@@ -0,0 +1,88 @@
+/**
+ * @file log_follower.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of a `tail -F`-like log file follower.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_LOG_FOLLOWER_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_LOG_FOLLOWER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/types.h>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief Follows a log file as it grows, similar to `tail -F`.
+ *
+ * New data is detected through inotify, or by polling at a fixed interval if requested (e.g. for network filesystems).
+ * Rotation (the file being renamed or deleted and re-created) and truncation are detected, in which case the remainder of
+ * the old file is read before the new file is followed from its start.
+ */
+class LogFollower {
+    public: // +++ Types +++
+        /**
+         * @brief Callback invoked for each complete line (without the line terminator).
+         */
+        using LineCallback = std::function<void(string_view line)>;
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Starts following a log file. Data already in the file is skipped.
+         *
+         * @param path The path to the log file. The file doesn't need to exist yet.
+         * @param pollIntervalMs The polling interval in milliseconds, or 0 to use inotify.
+         *
+         * @throws std::system_error If inotify can't be initialised.
+         */
+        LogFollower(const string& path, uint32_t pollIntervalMs);
+
+        LogFollower(const LogFollower&) = delete;
+        LogFollower& operator=(const LogFollower&) = delete;
+
+        ~LogFollower();
+
+    public: // +++ Following +++
+        /**
+         * @brief Waits for new data (at most one polling interval or, with inotify, at most timeoutMs) and passes
+         * every new, complete line to the callback.
+         *
+         * @param callback The callback to invoke for each line.
+         * @param timeoutMs The maximum time to wait for new data when using inotify.
+         *
+         * @return size_t The amount of lines read.
+         *
+         * @throws std::system_error If reading fails.
+         */
+        size_t poll(const LineCallback& callback, int32_t timeoutMs);
+
+    private: // +++ Member functions +++
+        bool openLog(bool skipExisting);
+        void closeLog();
+        size_t readAvailable(const LineCallback& callback);
+        bool isRotated() const;
+
+    private: // +++ Members +++
+        string              m_path; //!< The path to the log file
+        uint32_t            m_pollIntervalMs; //!< The polling interval (0 = inotify)
+        int32_t             m_fd = -1; //!< The log file currently being followed
+        int32_t             m_inotifyFd = -1; //!< The inotify instance (if used)
+        int32_t             m_fileWatch = -1; //!< The inotify watch of the log file
+        int32_t             m_dirWatch = -1; //!< The inotify watch of the log file's directory
+        ino_t               m_inode = 0; //!< The inode of the followed file
+        off_t               m_offset = 0; //!< The amount of bytes of the followed file processed
+        std::vector<char>   m_readBuffer; //!< The buffer read(2) reads into
+        string              m_partialLine; //!< An incomplete line waiting for the rest of its data
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_LOG_FOLLOWER_HPP
@@ -0,0 +1,120 @@
+/**
+ * @file log_scanner.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the scanner reading past bans from fail2ban's (rotated) logs.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_LOG_SCANNER_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_LOG_SCANNER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+class ThreadPool;
+
+/**
+ * @brief Reads the bans recorded in fail2ban's log files, e.g. to backfill reports or where fail2ban can't be asked.
+ *
+ * Log files are memory-mapped and searched for "Ban " with memmem(), so only the lines around a match are looked at;
+ * everything else is skipped at memory speed. Compressed rotations (.gz, .zst; detected by their magic bytes) are
+ * decompressed on the fly. Large files are split into segments at line boundaries, and all segments are scanned in
+ * parallel; the bans of all segments are then merged by their timestamp, so they're reported oldest first, no matter
+ * which file they were found in.
+ *
+ * @remarks Only bans ("Ban", "Restore Ban") are read; unbans are ignored, as every ban in the window is reported.
+ */
+class LogScanner {
+    public: // +++ Types and constants +++
+        /**
+         * @brief Callback invoked for each ban, oldest first.
+         *
+         * @remarks The views passed to the callback are only valid for the duration of the call!
+         *
+         * @param jail The jail the IP was banned in.
+         * @param ip The banned IP.
+         * @param banTime When the IP was banned (UNIX time; 0 if the line has no timestamp).
+         */
+        using BanCallback = std::function<void(string_view jail, string_view ip, int64_t banTime)>;
+
+        static constexpr string_view DEFAULT_LOG_PATTERN = "/var/log/fail2ban.log*"; //!< fail2ban's default log and its rotations
+        static constexpr size_t SEGMENT_SIZE = 8 * 1024 * 1024; //!< The amount of (uncompressed) log scanned per job
+
+    public: // +++ Constructor +++
+        /**
+         * @brief Creates a scanner for the bans within a time window.
+         *
+         * @param since Only bans at or after this point in time (UNIX time) are read.
+         * @param until Only bans before this point in time (UNIX time) are read.
+         */
+        explicit LogScanner(int64_t since = std::numeric_limits<int64_t>::min(), int64_t until = std::numeric_limits<int64_t>::max());
+
+    public: // +++ Scanning +++
+        /**
+         * @brief Expands shell patterns (e.g. "/var/log/fail2ban.log*") to the files they match.
+         *
+         * @param patterns The patterns (or plain paths) to expand.
+         *
+         * @return std::vector<string> The matching files, without duplicates.
+         *
+         * @throws std::runtime_error If a pattern matches no file.
+         */
+        static std::vector<string> expandPatterns(const std::vector<string>& patterns);
+
+        /**
+         * @brief Scans log files and passes the bans within the window on, ordered by their timestamp.
+         *
+         * @remarks Files last modified before the start of the window are skipped without being read.
+         *
+         * @param paths The log files to scan.
+         * @param threadPool The pool to scan the segments on.
+         * @param callback The callback to invoke for every ban (on the calling thread).
+         *
+         * @return size_t The amount of bans passed on.
+         *
+         * @throws std::system_error If a file can't be opened or mapped.
+         * @throws std::runtime_error If a compressed file is damaged.
+         */
+        size_t scan(const std::vector<string>& paths, ThreadPool& threadPool, const BanCallback& callback);
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets the amount of (uncompressed) bytes scanned so far.
+         */
+        uint64_t bytesScanned() const { return m_bytesScanned; }
+
+    private: // +++ Types +++
+        /**
+         * @brief A ban found in a log file.
+         */
+        struct LoggedBan {
+            int64_t timeMs; //!< The timestamp of the ban, in milliseconds (0 if unknown)
+            string  jail; //!< The jail
+            string  ip; //!< The banned IP
+        };
+
+        struct Segment;
+
+    private: // +++ Member functions +++
+        static void planSegments(string_view data, std::vector<Segment>& segments);
+        void scanCompressed(string_view data, Segment& segment);
+        void scanText(string_view text, Segment& segment) const;
+
+    private: // +++ Members +++
+        int64_t                 m_sinceMs; //!< The start of the window (inclusive), in milliseconds
+        int64_t                 m_untilMs; //!< The end of the window (exclusive), in milliseconds
+        std::atomic<uint64_t>   m_bytesScanned{0}; //!< The amount of bytes scanned
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_LOG_SCANNER_HPP
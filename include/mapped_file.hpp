@@ -0,0 +1,85 @@
+/**
+ * @file mapped_file.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of a read-only, memory-mapped file.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_MAPPED_FILE_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief RAII wrapper around a read-only, private memory mapping of a complete file.
+ *
+ * The mapping is advised for sequential access, so the kernel reads ahead aggressively and drops pages behind the reader.
+ * Views handed out by @see MappedFile::view() reference the mapped pages directly and remain valid for the lifetime of the object.
+ */
+class MappedFile {
+    public: // +++ Constructors / Destructor +++
+        /**
+         * @brief Maps the file at the given path.
+         *
+         * @param path The path to the file to map.
+         *
+         * @throws std::system_error If the file could not be opened or mapped.
+         */
+        explicit MappedFile(const string& path);
+
+        /**
+         * @brief Maps the file referred to by an already opened file descriptor.
+         *
+         * @param fd The file descriptor to map. The descriptor is not closed by this object.
+         *
+         * @throws std::system_error If the file could not be mapped.
+         */
+        explicit MappedFile(int32_t fd);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        ~MappedFile();
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets a view of the complete file contents.
+         */
+        string_view view() const { return string_view(static_cast<const char*>(m_data), m_size); }
+
+        /**
+         * @brief Gets the size of the mapped file in bytes.
+         */
+        size_t size() const { return m_size; }
+
+        /**
+         * @brief Determines whether the given file descriptor refers to a regular (and thus mappable) file.
+         *
+         * @param fd The file descriptor to check.
+         *
+         * @return true If the descriptor refers to a regular file.
+         * @return false Otherwise (pipes, sockets, terminals, ...).
+         */
+        static bool isMappable(int32_t fd);
+
+    private: // +++ Member functions +++
+        void mapFd(int32_t fd);
+        void unmap();
+
+    private: // +++ Members +++
+        void*   m_data = nullptr; //!< The start of the mapping
+        size_t  m_size = 0; //!< The size of the mapping
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_MAPPED_FILE_HPP
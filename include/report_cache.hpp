@@ -0,0 +1,128 @@
+/**
+ * @file report_cache.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the persistent, memory-mapped cache of reported IPs.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_REPORT_CACHE_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_REPORT_CACHE_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "ip_address.hpp"
+
+using std::string;
+
+/**
+ * @brief On-disk, open-addressing hash table of previously reported IPs and the time they were last reported.
+ *
+ * The file consists of a fixed 64 byte header followed by a power-of-two amount of fixed-size slots, each holding a packed
+ * 128-bit address and its last-reported timestamp. The file is mapped shared, so lookups and updates are O(1) and touch
+ * only the slots they probe, no matter how many entries the cache holds.
+ *
+ * Entries older than the TTL are treated as absent and are dropped when the table is compacted. Compaction (and growth)
+ * rewrites the live entries into a new file which atomically replaces the old one via rename(2).
+ * The cache file is locked exclusively (flock(2)) for the lifetime of the object, so overlapping cron runs are serialised.
+ *
+ * An optional in-memory Bloom filter can be built on open, which answers most negative lookups without touching the mapping.
+ */
+class ReportCache {
+    public: // +++ Constants +++
+        static constexpr uint64_t MIN_CAPACITY = 1u << 16; //!< The capacity (in slots) of a newly created cache
+        static constexpr double   MAX_LOAD_FACTOR = 0.7; //!< The load factor at which the table is grown
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Opens (or creates) the cache file at the given path.
+         *
+         * @param path The path to the cache file.
+         * @param ttl The time (in seconds) for which a reported IP is considered "already reported".
+         * @param useBloomFilter Whether or not to build an in-memory Bloom prefilter.
+         *
+         * @throws std::system_error If the file could not be opened, locked or mapped.
+         * @throws std::runtime_error If the file is not a valid cache file.
+         */
+        ReportCache(const string& path, time_t ttl, bool useBloomFilter);
+
+        ReportCache(const ReportCache&) = delete;
+        ReportCache& operator=(const ReportCache&) = delete;
+
+        ~ReportCache();
+
+    public: // +++ Lookup / Update +++
+        /**
+         * @brief Determines whether an address was reported within the TTL.
+         *
+         * @param address The address to look up.
+         * @param now The current time.
+         *
+         * @return true If the address was reported less than TTL seconds ago.
+         * @return false Otherwise.
+         */
+        bool contains(const IpAddress& address, time_t now) const;
+
+        /**
+         * @brief Records that an address has been reported.
+         *
+         * @param address The reported address.
+         * @param now The time of the report.
+         */
+        void markReported(const IpAddress& address, time_t now);
+
+        /**
+         * @brief Rewrites the cache without expired entries, resizing it to fit the remaining entries.
+         *
+         * @param now The current time.
+         */
+        void compact(time_t now);
+
+        /**
+         * @brief Flushes all modified pages to disk.
+         */
+        void sync();
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets the amount of occupied slots (including expired entries which were not yet compacted).
+         */
+        uint64_t size() const;
+
+        /**
+         * @brief Gets the amount of slots in the table.
+         */
+        uint64_t capacity() const;
+
+    public: // +++ On-disk layout +++
+        struct Header;
+        struct Slot;
+
+    private: // +++ Member functions +++
+        void openAndLock();
+        void mapFile();
+        void unmapFile();
+        void rebuild(uint64_t capacity, time_t now);
+        void buildBloomFilter();
+        void addToBloomFilter(uint64_t hash);
+        bool mayContain(uint64_t hash) const;
+        bool isExpired(int64_t lastReported, time_t now) const;
+        Slot* slots() const;
+
+    private: // +++ Members +++
+        string                  m_path; //!< The path to the cache file
+        time_t                  m_ttl; //!< The TTL of entries
+        bool                    m_useBloomFilter; //!< Whether the Bloom filter is in use
+        int32_t                 m_fd = -1; //!< The (locked) cache file
+        void*                   m_mapping = nullptr; //!< The shared mapping of the cache file
+        size_t                  m_mappingSize = 0; //!< The size of the mapping
+        std::vector<uint64_t>   m_bloomBits; //!< The Bloom filter's bit array
+        uint64_t                m_bloomMask = 0; //!< The mask applied to Bloom filter bit indices
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_REPORT_CACHE_HPP
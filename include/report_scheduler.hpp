@@ -0,0 +1,201 @@
+/**
+ * @file report_scheduler.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the persistent queue which paces reports to abuseipdb's limits.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_REPORT_SCHEDULER_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_REPORT_SCHEDULER_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "ip_address.hpp"
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief Queues rendered reports on disk and releases them as abuseipdb's limits allow: an IP isn't reported again
+ * within 15 minutes, and no more than the daily quota is reported per (UTC) day.
+ *
+ * The queue file is a write-ahead log: a header followed by checksummed records, each of which either queues a report
+ * or records that one was reported. The log is replayed on open; a torn record at the end (from a crash mid-write) is
+ * cut off. Pending reports are kept in a priority queue keyed by the earliest time they may be reported, so queueing
+ * and taking a report are O(log n), no matter how many are pending.
+ *
+ * Reports are only recorded as reported once they were delivered, and reports which failed to be delivered go back to
+ * the queue, so nothing is lost. Once the log is mostly made of reported entries, it's compacted: the pending reports
+ * and the reports which still count towards the limits are written to a new file, which atomically replaces the log
+ * via rename(2). The queue file is locked exclusively (flock(2)) for the lifetime of the object, like @see ReportCache.
+ *
+ * @remarks A report is delivered at least once: if the process dies after the upload, but before the report was
+ * recorded, it's sent again by the next run (and rejected by abuseipdb if that's within 15 minutes).
+ */
+class ReportScheduler {
+    public: // +++ Types and constants +++
+        /**
+         * @brief A report taken from the queue.
+         */
+        struct Report {
+            IpAddress   address; //!< The reported IP
+            string      jail; //!< The jail the IP was banned in (the first of them, if deduplicated)
+            string      row; //!< The rendered CSV row (including the categories and the comment)
+        };
+
+        static constexpr time_t     REPORT_INTERVAL = 15 * 60; //!< The time abuseipdb requires between two reports of an IP
+        static constexpr uint32_t   DEFAULT_DAILY_QUOTA = 1000; //!< The amount of reports per day abuseipdb's free tier accepts
+        static constexpr uint64_t   MIN_COMPACT_SIZE = 1024 * 1024; //!< Logs smaller than this aren't compacted
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Opens (or creates) the queue file at the given path and replays it.
+         *
+         * @param path The path to the queue file.
+         * @param dailyQuota The maximum amount of reports per UTC day (0 for no limit).
+         *
+         * @throws std::system_error If the file can't be opened, locked or read.
+         * @throws std::runtime_error If the file is not a queue file.
+         */
+        ReportScheduler(const string& path, uint32_t dailyQuota);
+
+        ReportScheduler(const ReportScheduler&) = delete;
+        ReportScheduler& operator=(const ReportScheduler&) = delete;
+
+        ~ReportScheduler();
+
+    public: // +++ Scheduling +++
+        /**
+         * @brief Queues a report of an IP, due straight away or once 15 minutes have passed since it was last reported.
+         *
+         * @remarks The report is only durable once @see sync() returned.
+         *
+         * @param address The IP to report.
+         * @param jail The jail the IP was banned in.
+         * @param row The rendered CSV row.
+         * @param now The current time.
+         *
+         * @return true If the report was queued.
+         * @return false If a report of the IP is already pending.
+         */
+        bool enqueue(const IpAddress& address, string_view jail, string_view row, time_t now);
+
+        /**
+         * @brief Takes the reports which are due, in order, as far as the day's remaining quota allows.
+         *
+         * @remarks Taken reports count towards the quota and stay pending until they're passed to @see markReported()
+         * or @see requeue().
+         *
+         * @param now The current time.
+         *
+         * @return std::vector<Report> The reports to deliver.
+         */
+        std::vector<Report> take(time_t now);
+
+        /**
+         * @brief Records that a taken report was delivered.
+         *
+         * @param address The reported IP.
+         * @param now The time of the report.
+         */
+        void markReported(const IpAddress& address, time_t now);
+
+        /**
+         * @brief Returns a taken report which couldn't be delivered to the queue, so it's taken again later.
+         *
+         * @param address The IP whose report failed.
+         */
+        void requeue(const IpAddress& address);
+
+        /**
+         * @brief Writes the records of the queued and reported entries to disk and compacts the log if it's grown large.
+         *
+         * @param now The current time.
+         *
+         * @throws std::system_error If the log can't be written.
+         */
+        void sync(time_t now);
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets the amount of reports which are pending (including those taken, but not yet delivered).
+         */
+        size_t pendingCount() const { return m_pending.size(); }
+
+        /**
+         * @brief Gets the point in time at which the next report is due (0 if none is pending).
+         */
+        time_t nextDue();
+
+    public: // +++ On-disk layout +++
+        struct Header;
+
+    private: // +++ Types +++
+        /**
+         * @brief A pending report.
+         */
+        struct Entry {
+            uint64_t    sequence; //!< Orders reports which are due at the same time, and tells current heap items from stale ones
+            time_t      notBefore; //!< The earliest time the report may be sent
+            string      jail; //!< The jail
+            string      row; //!< The rendered CSV row
+            bool        isTaken = false; //!< Whether the report was taken and awaits the outcome of its delivery
+        };
+
+        /**
+         * @brief An item of the priority queue; items whose entry was taken, reported or requeued since are skipped.
+         */
+        struct DueItem {
+            time_t      notBefore; //!< The earliest time the report may be sent
+            uint64_t    sequence; //!< The entry's sequence number at the time the item was pushed
+            IpAddress   address; //!< The IP (the key of the entry)
+
+            bool operator>(const DueItem& other) const { return notBefore != other.notBefore ? notBefore > other.notBefore : sequence > other.sequence; }
+        };
+
+        /**
+         * @brief A delivered report, which counts towards the limits.
+         */
+        struct Reported {
+            time_t      time; //!< When the IP was reported
+            IpAddress   address; //!< The reported IP
+        };
+
+    private: // +++ Member functions +++
+        void openAndLock();
+        void replay();
+        void compact(time_t now);
+        void expireReports(time_t now);
+        void appendQueued(std::string& log, const IpAddress& address, const Entry& entry) const;
+        void appendReported(std::string& log, const Reported& report) const;
+        void pushDue(const IpAddress& address, const Entry& entry);
+        static uint64_t queuedRecordSize(const Entry& entry);
+        size_t reportedToday(time_t now) const;
+
+    private: // +++ Members +++
+        string                                                  m_path; //!< The path to the queue file
+        uint32_t                                                m_dailyQuota; //!< The maximum amount of reports per UTC day (0 = unlimited)
+        int32_t                                                 m_fd = -1; //!< The (locked) queue file
+        uint64_t                                                m_fileSize = 0; //!< The size of the log on disk
+        uint64_t                                                m_nextSequence = 1; //!< The sequence number of the next queued report
+        std::unordered_map<IpAddress, Entry, IpAddressHash>     m_pending; //!< The pending reports, by IP
+        std::priority_queue<DueItem, std::vector<DueItem>, std::greater<>>
+                                                                m_due; //!< The pending reports, by the time they're due
+        std::deque<Reported>                                    m_reported; //!< The delivered reports which count towards the limits, oldest first
+        std::unordered_map<IpAddress, time_t, IpAddressHash>    m_lastReported; //!< When the IPs in m_reported were last reported
+        uint64_t                                                m_pendingSize = 0; //!< The size of the pending reports' records
+        size_t                                                  m_takenCount = 0; //!< The amount of reports taken, but not yet delivered
+        string                                                  m_unwritten; //!< Records not yet written to the log
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_REPORT_SCHEDULER_HPP
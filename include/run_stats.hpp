@@ -0,0 +1,159 @@
+/**
+ * @file run_stats.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the per-run timing, memory and counting instrumentation.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_RUN_STATS_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_RUN_STATS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief Collects what a run spent its time on and what it did with the IPs it saw.
+ *
+ * Stage times are exclusive: when a stage is entered from within another (e.g. merging rows while parsing), the outer
+ * stage is paused meanwhile, so the stage times add up to the main thread's total. Only stage transitions are timed,
+ * never individual IPs, so the overhead is a few clock reads per input chunk and per rendered task.
+ *
+ * Apart from @see addRender() (whose values are measured on the workers, but handed over on the main thread), all member
+ * functions must be called from the main thread.
+ */
+class RunStats {
+    public: // +++ Types +++
+        /**
+         * @brief The stages of a run.
+         */
+        enum class Stage {
+            Setup, //!< Loading categories, exclusions, the cache and the uploader
+            Input, //!< Waiting for and reading fail2ban's output (fail2ban-client, socket, file or stdin)
+            Parse, //!< Parsing the output and collecting the IPs into tasks
+            Render, //!< Rendering CSV rows on the thread pool (summed over all workers)
+            Merge, //!< Waiting for rendered tasks, checking the cache and writing (or submitting) the rows in order
+            Watch, //!< Following fail2ban's log
+            Upload, //!< Waiting for outstanding uploads
+            Teardown, //!< Compacting and syncing the cache
+            COUNT
+        };
+
+        /**
+         * @brief What happened to the IPs of a single jail.
+         */
+        struct JailCounters {
+            uint64_t seen = 0; //!< The IPs read from the input
+            uint64_t invalid = 0; //!< The IPs skipped because they aren't valid addresses
+            uint64_t emitted = 0; //!< The IPs reported
+            uint64_t excluded = 0; //!< The IPs skipped because of the exclusion list
+            uint64_t cached = 0; //!< The IPs skipped because they were reported recently (or earlier in this run)
+            uint64_t duplicates = 0; //!< The IPs skipped because they were already banned in this or an earlier jail
+            uint64_t unchanged = 0; //!< The IPs skipped because they were already banned at the time of the snapshot
+        };
+
+        /**
+         * @brief Enters a stage for the lifetime of the object; a no-op if no stats are collected.
+         */
+        class Scope {
+            public:
+                Scope(RunStats* stats, Stage stage): m_stats(stats) { if (m_stats != nullptr) { m_stats->enter(stage); } }
+                ~Scope() { if (m_stats != nullptr) { m_stats->leave(); } }
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+            private:
+                RunStats* m_stats; //!< The stats to account to (may be null)
+        };
+
+        /**
+         * @brief A point in time, as seen by the wall clock and the calling thread's CPU clock.
+         */
+        struct Sample {
+            std::chrono::steady_clock::time_point   wall; //!< The wall clock time
+            double                                  cpuSeconds; //!< The CPU time used by the calling thread
+        };
+
+    public: // +++ Constructor +++
+        /**
+         * @brief Starts collecting; the run's start time is now.
+         */
+        RunStats();
+
+    public: // +++ Collecting +++
+        /**
+         * @brief Takes a sample of the wall clock and the calling thread's CPU clock.
+         */
+        static Sample sample();
+
+        /**
+         * @brief Enters a stage, pausing the current one.
+         */
+        void enter(Stage stage);
+
+        /**
+         * @brief Leaves the current stage, resuming the one it was entered from.
+         */
+        void leave();
+
+        /**
+         * @brief Adds time measured on a worker thread to the @see Stage::Render stage.
+         */
+        void addRender(double wallSeconds, double cpuSeconds);
+
+        /**
+         * @brief Gets the counters of a jail, creating them if necessary.
+         */
+        JailCounters& jail(string_view name);
+
+        /**
+         * @brief Adds to the amount of input bytes read.
+         */
+        void addBytesRead(uint64_t bytes) { m_bytesRead += bytes; }
+
+        /**
+         * @brief Sets the amount of threads rendering rows.
+         */
+        void setThreadCount(size_t threadCount) { m_threadCount = threadCount; }
+
+    public: // +++ Reporting +++
+        /**
+         * @brief Renders the collected stats as a single line of JSON.
+         *
+         * @param exitCode The exit code of the run.
+         */
+        string toJson(int32_t exitCode) const;
+
+    private: // +++ Types +++
+        struct StageTotals {
+            double wallSeconds = 0; //!< The wall time spent in the stage
+            double cpuSeconds = 0; //!< The CPU time spent in the stage
+        };
+
+    private: // +++ Member functions +++
+        void credit(const Sample& now);
+
+    private: // +++ Members +++
+        Sample                                          m_start; //!< When the run started
+        Sample                                          m_lastSample; //!< When the current stage was last credited
+        std::vector<Stage>                              m_stageStack; //!< The stages entered (innermost last)
+        std::array<StageTotals, static_cast<size_t>(Stage::COUNT)>
+                                                        m_stages{}; //!< The totals per stage
+        std::vector<std::pair<string, JailCounters>>    m_jails; //!< The jail counters in order of appearance
+        std::unordered_map<string, size_t>              m_jailIndices; //!< Maps jail names to m_jails
+        uint64_t                                        m_bytesRead = 0; //!< The amount of input bytes read
+        size_t                                          m_threadCount = 1; //!< The amount of rendering threads
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_RUN_STATS_HPP
@@ -0,0 +1,97 @@
+/**
+ * @file shard_writer.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of the writer splitting the CSV output into separate, size-bounded files.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_SHARD_WRITER_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_SHARD_WRITER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <string>
+#include <string_view>
+
+#include "thread_pool.hpp"
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief Writes batches of CSV rows to a directory, one file (shard) per batch, each with its own header.
+ *
+ * Shards are written by a pool of writer threads, while the caller goes on producing rows. Each shard is written to a
+ * hidden temporary file in the same directory, synced, and then renamed to its final name, so a shard only ever appears
+ * complete: a consumer may pick up (and remove) the *.csv files in the directory while later shards are still being
+ * written. Shards are numbered in the order their batches were passed in.
+ *
+ * @remarks The size of the batches is up to the caller; @see CsvWriter with a batch sink bounds them by rows and bytes.
+ */
+class ShardWriter {
+    public: // +++ Constants +++
+        static constexpr size_t         DEFAULT_WRITER_COUNT = 4; //!< The default amount of writer threads
+        static constexpr size_t         MAX_SHARD_SIZE = 1024 * 1024 * 1024; //!< The largest shard size accepted (shards are held in memory until written)
+        static constexpr size_t         SHARDS_PER_WRITER = 2; //!< The amount of shards queued per writer before the caller waits for the oldest one
+        static constexpr string_view    SHARD_EXTENSION = ".csv"; //!< The extension of complete shards
+
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Creates the directory (if needed) and starts the writer threads.
+         *
+         * @param directory The directory to write the shards to.
+         * @param prefix The start of the shards' names, which are followed by a six-digit sequence number.
+         * @param writerCount The amount of writer threads.
+         *
+         * @throws std::filesystem::filesystem_error If the directory can't be created.
+         */
+        ShardWriter(const string& directory, string_view prefix, size_t writerCount = DEFAULT_WRITER_COUNT);
+
+        ShardWriter(const ShardWriter&) = delete;
+        ShardWriter& operator=(const ShardWriter&) = delete;
+
+        /**
+         * @brief Waits for the shards which are still being written. Errors are ignored; call @see sync() beforehand to
+         * handle them.
+         */
+        ~ShardWriter();
+
+    public: // +++ Writing +++
+        /**
+         * @brief Queues a shard holding the CSV header and the given rows.
+         *
+         * @param rows Complete CSV rows (without the header); the data is copied.
+         *
+         * @throws std::system_error If one of the earlier shards couldn't be written.
+         */
+        void write(string_view rows);
+
+        /**
+         * @brief Waits until all queued shards are complete.
+         *
+         * @throws std::system_error If a shard couldn't be written.
+         */
+        void sync();
+
+    public: // +++ Getters +++
+        /**
+         * @brief Gets the amount of shards queued so far.
+         */
+        uint64_t shardCount() const { return m_nextShard - 1; }
+
+    private: // +++ Member functions +++
+        void writeShard(const string& name, const string& data) const;
+
+    private: // +++ Members +++
+        string                          m_directory; //!< The directory the shards are written to
+        string                          m_prefix; //!< The start of the shards' names
+        uint64_t                        m_nextShard = 1; //!< The sequence number of the next shard
+        std::deque<std::future<void>>   m_pending; //!< The shards being written, oldest first
+        ThreadPool                      m_writers; //!< The writer threads (declared last, so they're stopped first)
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_SHARD_WRITER_HPP
@@ -1,116 +1,176 @@
 /**
  * @file string_splitter.hpp
  * @author Simon Cahill (simon@simonc.eu)
- * @brief Contains the full implementation of an iterator-based string splitter based on an answer provided by StackOverflow user Calmarius.
+ * @brief Contains the full implementation of a zero-copy, iterator-based string splitter.
  * @version 0.1
  * @date 2022-10-14
- * 
+ *
  * @copyright Copyright (c) 2022 Simon Cahill and Contributors
  */
 
 #ifndef FAIL2ABUSEIPDB_INCLUDE_STRING_SPLITTER_HPP
 #define FAIL2ABUSEIPDB_INCLUDE_STRING_SPLITTER_HPP
 
-#include <string>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <string_view>
 
-using std::string;
 using std::string_view;
 
 /**
  * @brief Splits a string into tokens, usable in an iterator loop, based on a delimiter.
+ *
+ * The splitter and its iterators only hold views of the input (and of the delimiter, unless it's a single character), so
+ * splitting neither copies nor allocates, and works in constant expressions. At run time, single-character delimiters
+ * are searched with memchr(), which libc vectorises.
+ *
+ * @remarks An empty input has no tokens; otherwise, n delimiters separate n + 1 (possibly empty) tokens. An empty
+ * delimiter doesn't split the input at all. The input must outlive the loop.
  */
-struct StringSplit {
-
-    /**
-     * @brief Simple implementation of an iterator usable in a iterative for-loop.
-     */
-    struct Iterator {
-        private:
-            size_t m_tokenStart = 0;
-            size_t m_tokenEnd = 0;
-            string m_input;
-            string_view m_inputView;
-            string m_delimiter;
-            bool m_done = false;
-
-        public:
-            /**
-             * @brief Constructs an empty iterator which indicates the end of an iterator.
-             */
-            Iterator() { m_done = true; }
-
-            /**
-             * @brief Constructs a new instance of this iterator.
-             * 
-             * @param input The input string.
-             * @param delimiter The delimiter to split the string by.
-             */
-            Iterator(const string& input, const string& delimiter):
-            m_input(std::move(input)), m_inputView(m_input), m_delimiter(std::move(delimiter)) {
-                m_tokenEnd = m_inputView.find(m_delimiter, m_tokenStart);
-            }
-
-            /**
-             * @brief Dereference operator overload.
-             * 
-             * @return string_view Returns a substring of the input marked by the current iterator position.
-             */
-            string_view operator*() { return m_inputView.substr(m_tokenStart, m_tokenEnd - m_tokenStart); }
-
-            /**
-             * @brief Increments the iterator's position by 1.
-             * 
-             * @return Iterator& A reference to the current instance.
-             */
-            Iterator& operator++() {
-                if (m_tokenEnd == string::npos) {
-                    m_done = true;
+class StringSplit {
+    public: // +++ Iterator +++
+        /**
+         * @brief Forward iterator over the tokens.
+         */
+        class Iterator {
+            public: // +++ Types +++
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = string_view;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const string_view*;
+                using reference = string_view;
+
+            public: // +++ Constructors +++
+                /**
+                 * @brief Constructs the end iterator.
+                 */
+                constexpr Iterator() = default;
+
+                /**
+                 * @brief Constructs an iterator pointing to the first token.
+                 *
+                 * @param input The input string.
+                 * @param delimiter The delimiter to split the string by (ignored if delimiterChar is used).
+                 * @param delimiterChar The single-character delimiter.
+                 * @param isCharDelimiter Whether the delimiter is delimiterChar.
+                 */
+                constexpr Iterator(string_view input, string_view delimiter, char delimiterChar, bool isCharDelimiter):
+                m_delimiter(delimiter), m_delimiterChar(delimiterChar), m_isCharDelimiter(isCharDelimiter), m_isEnd(input.empty()) {
+                    if (!m_isEnd) { findToken(input); }
+                }
+
+            public: // +++ Operators +++
+                /**
+                 * @brief Gets the current token.
+                 */
+                constexpr string_view operator*() const { return m_token; }
+
+                constexpr const string_view* operator->() const { return &m_token; }
+
+                /**
+                 * @brief Moves on to the next token.
+                 *
+                 * @return Iterator& A reference to the current instance.
+                 */
+                constexpr Iterator& operator++() {
+                    if (m_isLast) {
+                        m_isEnd = true;
+                        m_token = string_view{};
+                    } else {
+                        findToken(m_rest);
+                    }
+
                     return *this;
                 }
 
-                m_tokenStart = m_tokenEnd + m_delimiter.size();
-                m_tokenEnd = m_inputView.find(m_delimiter, m_tokenStart);
-                return *this;
-            }
-
-            /**
-             * @brief Not-equal operator overload. Determines whether two @see Iterator instances are inequal.
-             * 
-             * @param other A const reference to a different @see Iterator.
-             * 
-             * @return true If the two instances are inequal.
-             * @return false Otherwise.
-             * 
-             * @remarks This only checks if both iterators point to the end of the iterator!
-             */
-            bool operator!=(const Iterator& other) { return m_done && other.m_done; }
-    };
-
-    private:
-        Iterator m_iteratorBeginning; //!< The beginning iterator
-
-    public:
+                constexpr Iterator operator++(int) {
+                    auto previous = *this;
+                    ++*this;
+                    return previous;
+                }
+
+                /**
+                 * @brief Determines whether two iterators point to the same token (or are both at the end).
+                 */
+                constexpr bool operator==(const Iterator& other) const {
+                    return m_isEnd == other.m_isEnd && (m_isEnd || (m_token.data() == other.m_token.data() && m_isLast == other.m_isLast));
+                }
+
+                constexpr bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+            private: // +++ Member functions +++
+                /**
+                 * @brief Makes the token at the start of rest the current one.
+                 */
+                constexpr void findToken(string_view rest) {
+                    const auto tokenEnd = find(rest);
+                    m_isLast = tokenEnd == string_view::npos;
+                    m_token = rest.substr(0, tokenEnd);
+                    m_rest = m_isLast ? string_view{} : rest.substr(tokenEnd + (m_isCharDelimiter ? 1 : m_delimiter.size()));
+                }
+
+                /**
+                 * @brief Finds the next delimiter.
+                 */
+                constexpr size_t find(string_view rest) const {
+                    if (!m_isCharDelimiter) { return m_delimiter.empty() ? string_view::npos : rest.find(m_delimiter); }
+                    if (__builtin_is_constant_evaluated()) { return rest.find(m_delimiterChar); }
+
+                    const auto* position = static_cast<const char*>(std::memchr(rest.data(), m_delimiterChar, rest.size()));
+                    return position == nullptr ? string_view::npos : static_cast<size_t>(position - rest.data());
+                }
+
+            private: // +++ Members +++
+                string_view m_token; //!< The current token
+                string_view m_rest; //!< The input after the delimiter which ends the current token
+                string_view m_delimiter; //!< The delimiter (unless it's a single character)
+                char        m_delimiterChar = 0; //!< The delimiter, if it's a single character
+                bool        m_isCharDelimiter = false; //!< Whether the delimiter is m_delimiterChar
+                bool        m_isLast = true; //!< Whether the current token is the last one
+                bool        m_isEnd = true; //!< Whether the iterator is past the last token
+        };
+
+    public: // +++ Constructors +++
+        /**
+         * @brief Constructs a new instance of @see StringSplit
+         *
+         * @param input The input string to be split into tokens.
+         * @param delimiter The delimiter by which to split the string; single characters take the memchr() path.
+         */
+        constexpr StringSplit(string_view input, string_view delimiter):
+        m_input(input), m_delimiter(delimiter), m_delimiterChar(delimiter.size() == 1 ? delimiter.front() : '\0'), m_isCharDelimiter(delimiter.size() == 1) { }
+
         /**
          * @brief Constructs a new instance of @see StringSplit
-         * 
+         *
          * @param input The input string to be split into tokens.
-         * @param delim The delimiter by which to split the strings.
+         * @param delimiter The character by which to split the string.
          */
-        StringSplit(const string& input, const string& delim): m_iteratorBeginning{std::move(input), std::move(delim)} { }
+        constexpr StringSplit(string_view input, char delimiter): m_input(input), m_delimiterChar(delimiter), m_isCharDelimiter(true) { }
 
+    public: // +++ Iteration +++
         /**
-         * @brief Gets the beginning of the iterator.
-         * 
-         * @return Iterator The beginning iterator (position)
+         * @brief Gets an iterator pointing to the first token.
          */
-        Iterator begin() { return m_iteratorBeginning; }
+        constexpr Iterator begin() const { return Iterator(m_input, m_delimiter, m_delimiterChar, m_isCharDelimiter); }
 
         /**
-         * @brief Returns the end of the iterator.
-         * 
-         * @return Iterator The end iterator.
+         * @brief Gets the end iterator.
          */
-        Iterator end() { return Iterator{}; }
+        constexpr Iterator end() const { return Iterator{}; }
+
+    private: // +++ Members +++
+        string_view m_input; //!< The input
+        string_view m_delimiter; //!< The delimiter (unless it's a single character)
+        char        m_delimiterChar = 0; //!< The delimiter, if it's a single character
+        bool        m_isCharDelimiter = false; //!< Whether the delimiter is m_delimiterChar
 };
 
-#endif // FAIL2ABUSEIPDB_INCLUDE_STRING_SPLITTER_HPP
\ No newline at end of file
+// the tokenisation rules, checked at compile time
+static_assert([] { size_t count = 0; for (const auto token : StringSplit("", ',')) { count += token.size() + 1; } return count; }() == 0, "An empty input has no tokens");
+static_assert([] { size_t count = 0; for (const auto token : StringSplit("a,,bc,", ',')) { count = count * 10 + token.size(); } return count; }() == 1020, "Empty tokens are kept");
+static_assert([] { size_t count = 0; for (const auto token : StringSplit("a::b:c", "::")) { count = count * 10 + token.size(); } return count; }() == 13, "Delimiters may be strings");
+static_assert(*++StringSplit("/usr/bin:/bin", ':').begin() == "/bin", "Iterators point into the input");
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_STRING_SPLITTER_HPP
@@ -0,0 +1,72 @@
+/**
+ * @file thread_pool.hpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the declaration of a simple fixed-size thread pool.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#ifndef FAIL2ABUSEIPDB_INCLUDE_THREAD_POOL_HPP
+#define FAIL2ABUSEIPDB_INCLUDE_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs jobs on a fixed set of worker threads, in the order they were submitted.
+ *
+ * A pool of a single thread runs every job inline, on the submitting thread, so single-threaded runs pay no
+ * synchronisation overhead.
+ */
+class ThreadPool {
+    public: // +++ Constructor / Destructor +++
+        /**
+         * @brief Starts the worker threads.
+         *
+         * @param threadCount The amount of threads to run jobs on (including the submitting thread if 1).
+         */
+        explicit ThreadPool(size_t threadCount);
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief Discards all jobs which haven't started yet and waits for the running ones.
+         */
+        ~ThreadPool();
+
+    public: // +++ Jobs +++
+        /**
+         * @brief Submits a job.
+         *
+         * @param job The job to run.
+         *
+         * @return std::future<void> Becomes ready when the job has run; rethrows anything the job threw.
+         */
+        std::future<void> submit(std::function<void()> job);
+
+        /**
+         * @brief Gets the amount of threads jobs run on.
+         */
+        size_t threadCount() const { return m_workers.empty() ? 1 : m_workers.size(); }
+
+    private: // +++ Member functions +++
+        void work();
+
+    private: // +++ Members +++
+        std::vector<std::thread>                m_workers; //!< The worker threads (none if jobs run inline)
+        std::deque<std::packaged_task<void()>>  m_jobs; //!< The jobs waiting for a worker
+        std::mutex                              m_mutex; //!< Protects the queue
+        std::condition_variable                 m_jobAvailable; //!< Signalled when a job was queued or the pool is stopping
+        bool                                    m_isStopping = false; //!< Whether the workers should exit
+};
+
+#endif // FAIL2ABUSEIPDB_INCLUDE_THREAD_POOL_HPP
@@ -0,0 +1,174 @@
+/**
+ * @file ban_snapshot.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the snapshot of the IPs banned at the end of the previous run.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ban_snapshot.hpp"
+
+using std::error_code;
+using std::runtime_error;
+using std::system_error;
+using std::vector;
+
+static constexpr char       SNAPSHOT_MAGIC[8] = { 'F', '2', 'A', 'B', 'S', 'N', 'A', 'P' }; //!< Identifies a snapshot file
+static constexpr uint32_t   SNAPSHOT_VERSION = 1; //!< The current version of the snapshot format
+static constexpr size_t     ADDRESS_SIZE = sizeof(IpAddress::bytes); //!< The size of a packed address
+
+/**
+ * @brief The header at the start of a snapshot file.
+ */
+struct SnapshotHeader {
+    char        magic[8]; //!< @see SNAPSHOT_MAGIC
+    uint32_t    version; //!< @see SNAPSHOT_VERSION
+    uint32_t    addressSize; //!< The size of a packed address
+    uint64_t    addressCount; //!< The amount of addresses following the header
+    uint64_t    reserved; //!< Pads the header to 32 bytes
+};
+
+static_assert(sizeof(SnapshotHeader) == 32, "Snapshot header must be 32 bytes");
+static_assert(sizeof(IpAddress) == ADDRESS_SIZE, "Addresses must be packed into 16 bytes");
+
+/**
+ * @brief An IP of the current run and its position in the input.
+ */
+struct SortItem {
+    IpAddress   address; //!< The IP
+    uint32_t    index; //!< The index of the IP in the input
+};
+
+/**
+ * @brief Sorts the items by address with an LSD radix sort over the address bytes.
+ *
+ * @remarks Bytes which are the same in all addresses (the first 12 bytes of IPv4-mapped addresses, the first two or so
+ * of most IPv6 prefixes) are skipped, so IPv4-only input takes four passes.
+ */
+static void radixSort(vector<SortItem>& items) {
+    std::vector<std::array<size_t, 256>> histograms(ADDRESS_SIZE, std::array<size_t, 256>{});
+    for (const auto& item : items) {
+        for (size_t byte = 0; byte < ADDRESS_SIZE; byte++) { histograms[byte][item.address.bytes[byte]]++; }
+    }
+
+    vector<SortItem> buffer(items.size());
+    for (size_t pass = 0; pass < ADDRESS_SIZE; pass++) {
+        const auto byte = ADDRESS_SIZE - 1 - pass;
+        auto& histogram = histograms[byte];
+        if (histogram[items.front().address.bytes[byte]] == items.size()) { continue; }
+
+        size_t offset = 0;
+        for (auto& count : histogram) {
+            const auto bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+
+        for (const auto& item : items) { buffer[histogram[item.address.bytes[byte]]++] = item; }
+        items.swap(buffer);
+    }
+}
+
+BanSnapshot::BanSnapshot(const string& path): m_path(path) {
+    if (access(path.c_str(), F_OK) != 0 && errno == ENOENT) { return; }
+
+    auto file = std::make_unique<MappedFile>(path);
+    const auto contents = file->view();
+
+    SnapshotHeader header{};
+    if (contents.size() >= sizeof(header)) { std::memcpy(&header, contents.data(), sizeof(header)); }
+    if (contents.size() < sizeof(header) || std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        throw runtime_error(path + " is not a snapshot");
+    }
+    if (header.version != SNAPSHOT_VERSION || header.addressSize != ADDRESS_SIZE ||
+        contents.size() != sizeof(header) + header.addressCount * ADDRESS_SIZE) {
+        throw runtime_error(path + " is a damaged or incompatible snapshot");
+    }
+
+    const auto* addresses = reinterpret_cast<const uint8_t*>(contents.data() + sizeof(header));
+    for (size_t i = 1; i < header.addressCount; i++) {
+        if (std::memcmp(addresses + (i - 1) * ADDRESS_SIZE, addresses + i * ADDRESS_SIZE, ADDRESS_SIZE) >= 0) {
+            throw runtime_error(path + " is a damaged snapshot");
+        }
+    }
+
+    m_previousFile = std::move(file);
+    m_previous = addresses;
+    m_previousCount = header.addressCount;
+}
+
+vector<bool> BanSnapshot::diff(const vector<IpAddress>& addresses) {
+    vector<bool> isNew(addresses.size(), false);
+    m_current.clear();
+    m_current.reserve(addresses.size());
+    m_isDiffed = true;
+    if (addresses.empty()) { return isNew; }
+
+    vector<SortItem> items(addresses.size());
+    for (size_t i = 0; i < addresses.size(); i++) { items[i] = { addresses[i], static_cast<uint32_t>(i) }; }
+    radixSort(items);
+
+    size_t previous = 0;
+    for (const auto& item : items) {
+        if (!m_current.empty() && m_current.back() == item.address) {
+            // banned in several jails; the first occurrence decides
+            continue;
+        }
+        m_current.push_back(item.address);
+
+        int32_t order = 1;
+        while (previous < m_previousCount && (order = std::memcmp(m_previous + previous * ADDRESS_SIZE, item.address.bytes.data(), ADDRESS_SIZE)) < 0) {
+            previous++;
+        }
+        isNew[item.index] = previous == m_previousCount || order != 0;
+    }
+
+    return isNew;
+}
+
+void BanSnapshot::commit() const {
+    if (!m_isDiffed) { return; }
+
+    const auto tmpPath = m_path + ".tmp";
+    const int32_t fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to create " + tmpPath); }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.addressSize = ADDRESS_SIZE;
+    header.addressCount = m_current.size();
+
+    const auto writeAll = [&](const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            const auto written = write(fd, bytes, size);
+            if (written < 0 && errno == EINTR) { continue; }
+            if (written < 0) { return false; }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    };
+
+    bool isWritten = writeAll(&header, sizeof(header)) && writeAll(m_current.data(), m_current.size() * ADDRESS_SIZE) && fsync(fd) == 0;
+    const error_code writeError(errno, std::generic_category());
+    isWritten = close(fd) == 0 && isWritten;
+
+    if (!isWritten || rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+        const error_code error = isWritten ? error_code(errno, std::generic_category()) : writeError;
+        unlink(tmpPath.c_str());
+        throw system_error(error, "Failed to write snapshot " + m_path);
+    }
+}
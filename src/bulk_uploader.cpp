@@ -0,0 +1,285 @@
+/**
+ * @file bulk_uploader.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the abuseipdb bulk-report uploader.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "bulk_uploader.hpp"
+#include "csv_writer.hpp"
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::runtime_error;
+using std::unique_ptr;
+
+static constexpr seconds MIN_BACKOFF{ 1 }; //!< The delay before the first retry, unless the server asks for another
+static constexpr seconds MAX_DELAY{ 300 }; //!< The longest the uploader waits for a retry or a rate limit reset
+static constexpr int32_t MAX_POLL_MS = 1000; //!< The longest a single wait for network activity may take
+
+/**
+ * @brief A CSV file waiting to be uploaded.
+ */
+struct BulkUploader::Batch {
+    string              csv; //!< The complete CSV file, including the header
+    size_t              rowCount = 0; //!< The amount of rows (excluding the header)
+    uint32_t            attempts = 0; //!< The amount of requests made so far
+    clock::time_point   notBefore{}; //!< The batch isn't sent before this point in time
+    CompletionCallback  onComplete; //!< Invoked once the batch was accepted or given up on (may be empty)
+};
+
+/**
+ * @brief A request in flight.
+ */
+struct BulkUploader::Transfer {
+    CURL*               easy = nullptr; //!< The request's easy handle
+    curl_mime*          mime = nullptr; //!< The multipart body
+    unique_ptr<Batch>   batch; //!< The batch being uploaded
+    string              response; //!< The response body
+    int64_t             retryAfter = -1; //!< The value of Retry-After (in seconds), if sent
+    int64_t             rateLimitRemaining = -1; //!< The value of X-RateLimit-Remaining, if sent
+    int64_t             rateLimitReset = -1; //!< The value of X-RateLimit-Reset (a UNIX timestamp), if sent
+
+    ~Transfer() {
+        if (easy != nullptr) { curl_easy_cleanup(easy); }
+        if (mime != nullptr) { curl_mime_free(mime); }
+    }
+};
+
+static size_t onBodyData(char* data, size_t size, size_t count, void* userData) {
+    static_cast<string*>(userData)->append(data, size * count);
+    return size * count;
+}
+
+/**
+ * @brief Picks the rate limiting headers out of the response.
+ */
+template<typename TransferType>
+static size_t onHeaderLine(char* data, size_t size, size_t count, void* userData) {
+    auto& transfer = *static_cast<TransferType*>(userData);
+    const string_view line(data, size * count);
+
+    const auto colonPos = line.find(':');
+    if (colonPos == string_view::npos) { return size * count; }
+
+    string name(line.substr(0, colonPos));
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+
+    const auto value = line.substr(colonPos + 1);
+    const auto parseNumber = [&]() -> int64_t {
+        int64_t number = 0;
+        bool hasDigits = false;
+        for (const auto c : value) {
+            if (c == ' ' && !hasDigits) { continue; }
+            if (c < '0' || c > '9') { break; }
+            number = number * 10 + (c - '0');
+            hasDigits = true;
+        }
+        return hasDigits ? number : -1;
+    };
+
+    if (name == "retry-after") {
+        transfer.retryAfter = parseNumber();
+    } else if (name == "x-ratelimit-remaining") {
+        transfer.rateLimitRemaining = parseNumber();
+    } else if (name == "x-ratelimit-reset") {
+        transfer.rateLimitReset = parseNumber();
+    }
+
+    return size * count;
+}
+
+BulkUploader::BulkUploader(const string& url, const string& apiKey, size_t maxInFlight):
+m_url(url), m_maxInFlight(std::max<size_t>(1, maxInFlight)) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    m_multi = curl_multi_init();
+    if (m_multi == nullptr) { throw runtime_error("Failed to initialise libcurl"); }
+
+    // several requests share one connection where the server supports it; otherwise connections are pooled and reused
+    curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(m_maxInFlight));
+
+    m_headers = curl_slist_append(m_headers, "Accept: application/json");
+    m_headers = curl_slist_append(m_headers, ("Key: " + apiKey).c_str());
+}
+
+BulkUploader::~BulkUploader() {
+    for (auto& transfer : m_transfers) { curl_multi_remove_handle(m_multi, transfer->easy); }
+    m_transfers.clear();
+
+    curl_slist_free_all(m_headers);
+    curl_multi_cleanup(m_multi);
+    curl_global_cleanup();
+}
+
+void BulkUploader::submit(string_view rows, size_t rowCount, CompletionCallback onComplete) {
+    auto batch = std::make_unique<Batch>();
+    batch->csv.reserve(CsvWriter::CSV_HEADER.size() + rows.size());
+    batch->csv.append(CsvWriter::CSV_HEADER).append(rows);
+    batch->rowCount = rowCount;
+    batch->onComplete = std::move(onComplete);
+    m_pending.push_back(std::move(batch));
+
+    while (m_transfers.size() + m_pending.size() > m_maxInFlight) { drive(true); }
+    drive(false);
+}
+
+bool BulkUploader::finish() {
+    while (!m_transfers.empty() || !m_pending.empty()) { drive(true); }
+
+    return m_batchesFailed == 0;
+}
+
+/**
+ * @brief Starts whatever may be started, performs pending network I/O and handles finished requests.
+ *
+ * @param wait Whether to wait for network activity (or the next retry) first.
+ */
+void BulkUploader::drive(bool wait) {
+    if (wait) {
+        auto timeoutMs = MAX_POLL_MS;
+        if (m_transfers.empty() && !m_pending.empty()) {
+            // nothing in flight; sleep until the next batch may be sent
+            auto nextStart = std::max(m_pausedUntil, m_pending.front()->notBefore);
+            for (const auto& batch : m_pending) { nextStart = std::min(nextStart, std::max(m_pausedUntil, batch->notBefore)); }
+            timeoutMs = static_cast<int32_t>(std::clamp<int64_t>(duration_cast<milliseconds>(nextStart - clock::now()).count(), 0, MAX_POLL_MS));
+        }
+        curl_multi_poll(m_multi, nullptr, 0, timeoutMs, nullptr);
+    }
+
+    startReady();
+
+    int32_t runningHandles = 0;
+    curl_multi_perform(m_multi, &runningHandles);
+
+    int32_t queuedMessages = 0;
+    while (const auto* message = curl_multi_info_read(m_multi, &queuedMessages)) {
+        if (message->msg != CURLMSG_DONE) { continue; }
+
+        const auto transfer = std::find_if(m_transfers.begin(), m_transfers.end(), [&](const auto& t) { return t->easy == message->easy_handle; });
+        if (transfer == m_transfers.end()) { continue; }
+
+        const auto curlResult = message->data.result;
+        auto finished = std::move(*transfer);
+        m_transfers.erase(transfer);
+        curl_multi_remove_handle(m_multi, finished->easy);
+        completeTransfer(*finished, curlResult);
+    }
+
+    startReady();
+}
+
+/**
+ * @brief Starts requests for pending batches, as long as there's room and no pause is in effect.
+ */
+void BulkUploader::startReady() {
+    const auto now = clock::now();
+    if (now < m_pausedUntil) { return; }
+
+    for (auto batch = m_pending.begin(); batch != m_pending.end() && m_transfers.size() < m_maxInFlight;) {
+        if ((*batch)->notBefore > now) {
+            ++batch;
+            continue;
+        }
+
+        auto transfer = std::make_unique<Transfer>();
+        transfer->batch = std::move(*batch);
+        batch = m_pending.erase(batch);
+        transfer->batch->attempts++;
+
+        transfer->easy = curl_easy_init();
+        if (transfer->easy == nullptr) { throw runtime_error("Failed to initialise libcurl"); }
+
+        transfer->mime = curl_mime_init(transfer->easy);
+        auto* part = curl_mime_addpart(transfer->mime);
+        curl_mime_name(part, "csv");
+        curl_mime_filename(part, "report.csv");
+        curl_mime_type(part, "text/csv");
+        curl_mime_data(part, transfer->batch->csv.data(), transfer->batch->csv.size());
+
+        curl_easy_setopt(transfer->easy, CURLOPT_URL, m_url.c_str());
+        curl_easy_setopt(transfer->easy, CURLOPT_HTTPHEADER, m_headers);
+        curl_easy_setopt(transfer->easy, CURLOPT_MIMEPOST, transfer->mime);
+        curl_easy_setopt(transfer->easy, CURLOPT_PIPEWAIT, 1L);
+        curl_easy_setopt(transfer->easy, CURLOPT_WRITEFUNCTION, onBodyData);
+        curl_easy_setopt(transfer->easy, CURLOPT_WRITEDATA, &transfer->response);
+        curl_easy_setopt(transfer->easy, CURLOPT_HEADERFUNCTION, onHeaderLine<Transfer>);
+        curl_easy_setopt(transfer->easy, CURLOPT_HEADERDATA, transfer.get());
+        curl_easy_setopt(transfer->easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(transfer->easy, CURLOPT_CONNECTTIMEOUT, 30L);
+        curl_easy_setopt(transfer->easy, CURLOPT_TIMEOUT, 300L);
+
+        curl_multi_add_handle(m_multi, transfer->easy);
+        m_transfers.push_back(std::move(transfer));
+    }
+}
+
+/**
+ * @brief Books a finished request as accepted, schedules a retry or gives up on the batch.
+ */
+void BulkUploader::completeTransfer(Transfer& transfer, CURLcode curlResult) {
+    long statusCode = 0;
+    curl_easy_getinfo(transfer.easy, CURLINFO_RESPONSE_CODE, &statusCode);
+
+    if (transfer.rateLimitRemaining == 0 && transfer.rateLimitReset > 0) {
+        const auto resetIn = std::clamp<int64_t>(transfer.rateLimitReset - time(nullptr), 0, MAX_DELAY.count());
+        m_pausedUntil = std::max(m_pausedUntil, clock::now() + seconds(resetIn));
+    }
+
+    if (curlResult == CURLE_OK && statusCode >= 200 && statusCode < 300) {
+        m_batchesUploaded++;
+        m_rowsUploaded += transfer.batch->rowCount;
+
+        // {"data":{"savedReports":123,"invalidReports":[...]}}
+        static constexpr string_view SAVED_REPORTS = "\"savedReports\":";
+        if (const auto savedPos = transfer.response.find(SAVED_REPORTS); savedPos != string::npos) {
+            m_reportsSaved += std::strtoull(transfer.response.c_str() + savedPos + SAVED_REPORTS.size(), nullptr, 10);
+        }
+        if (transfer.batch->onComplete) { transfer.batch->onComplete(true); }
+        return;
+    }
+
+    const bool isRetryable = curlResult != CURLE_OK || statusCode == 429 || statusCode >= 500;
+    const auto reason = curlResult != CURLE_OK
+        ? string(curl_easy_strerror(curlResult))
+        : fmt::format("HTTP {0:d}: {1:s}", statusCode, transfer.response.substr(0, 512));
+
+    if (!isRetryable || transfer.batch->attempts >= MAX_ATTEMPTS) {
+        giveUp(*transfer.batch, reason);
+        return;
+    }
+
+    clock::duration delay = std::min<clock::duration>(MIN_BACKOFF * (1 << (transfer.batch->attempts - 1)), MAX_DELAY);
+    if (transfer.retryAfter >= 0) {
+        delay = seconds(std::min<int64_t>(transfer.retryAfter, MAX_DELAY.count()));
+        // the server wants everyone to back off, not just this request
+        m_pausedUntil = std::max(m_pausedUntil, clock::now() + delay);
+    }
+
+    m_retries++;
+    schedule(std::move(transfer.batch), delay);
+}
+
+void BulkUploader::schedule(unique_ptr<Batch> batch, clock::duration delay) {
+    batch->notBefore = clock::now() + delay;
+    m_pending.push_front(std::move(batch));
+}
+
+void BulkUploader::giveUp(const Batch& batch, const string& reason) {
+    m_batchesFailed++;
+    m_lastError = fmt::format("Gave up on a batch of {0:d} rows after {1:d} attempt(s): {2:s}", batch.rowCount, batch.attempts, reason);
+    if (batch.onComplete) { batch.onComplete(false); }
+}
@@ -0,0 +1,188 @@
+/**
+ * @file category_table.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the jail to abuseipdb category lookup table.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <stdexcept>
+
+#include "category_table.hpp"
+#include "mapped_file.hpp"
+#include "string_splitter.hpp"
+
+using std::runtime_error;
+using std::vector;
+
+static constexpr int32_t    MIN_CATEGORY = 1; //!< The lowest category known to abuseipdb
+static constexpr int32_t    MAX_CATEGORY = 23; //!< The highest category known to abuseipdb
+static constexpr uint32_t   MAX_DISPLACEMENT = 1u << 16; //!< Attempts per bucket before the table is enlarged
+
+static string_view trim(string_view text) {
+    while (!text.empty() && isspace(static_cast<unsigned char>(text.front()))) { text.remove_prefix(1); }
+    while (!text.empty() && isspace(static_cast<unsigned char>(text.back()))) { text.remove_suffix(1); }
+    return text;
+}
+
+static size_t nextPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) { result <<= 1; }
+    return result;
+}
+
+CategoryTable::CategoryTable(): m_defaultCategories(std::begin(DEFAULT_CATEGORIES), std::end(DEFAULT_CATEGORIES)) {
+    for (const auto& mapping : DEFAULT_JAIL_CATEGORIES) {
+        m_jails.push_back({ string(mapping.jail), mapping.category == -1 ? vector<int32_t>{} : vector<int32_t>{ mapping.category } });
+    }
+
+    rebuild();
+}
+
+void CategoryTable::loadOverrides(const string& path) {
+    const MappedFile file(path);
+    const auto contents = file.view();
+
+    size_t lineNumber = 0;
+    for (auto line : StringSplit(contents, '\n')) {
+        lineNumber++;
+
+        if (const auto commentPos = line.find('#'); commentPos != string_view::npos) { line = line.substr(0, commentPos); }
+        line = trim(line);
+        if (line.empty()) { continue; }
+
+        const auto fail = [&](const string& what) {
+            throw runtime_error(path + ":" + std::to_string(lineNumber) + ": " + what);
+        };
+
+        const auto equalsPos = line.find('=');
+        if (equalsPos == string_view::npos) { fail("expected <jail> = <categories>"); }
+
+        const auto key = trim(line.substr(0, equalsPos));
+        if (key.empty()) { fail("missing jail name"); }
+
+        vector<int32_t> categories;
+        for (auto value : StringSplit(trim(line.substr(equalsPos + 1)), ',')) {
+            value = trim(value);
+            int32_t category = 0;
+            if (value.empty() || value.size() > 2 || !std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+                fail("invalid category '" + string(value) + "'");
+            }
+            for (const auto c : value) { category = category * 10 + (c - '0'); }
+            if (category < MIN_CATEGORY || category > MAX_CATEGORY) { fail("unknown category " + std::to_string(category)); }
+
+            categories.push_back(category);
+        }
+
+        if (key == "default") {
+            m_defaultCategories = std::move(categories);
+            continue;
+        }
+
+        const auto existing = std::find_if(m_jails.begin(), m_jails.end(), [&](const auto& entry) { return entry.jail == key; });
+        if (existing != m_jails.end()) {
+            existing->categories = std::move(categories);
+        } else {
+            m_jails.push_back({ string(key), std::move(categories) });
+        }
+    }
+
+    rebuild();
+}
+
+string CategoryTable::categoriesFor(const vector<string_view>& jails) const {
+    vector<string_view> categories;
+    for (const auto jail : jails) {
+        for (const auto category : StringSplit(categoriesFor(jail), ',')) {
+            if (std::find(categories.begin(), categories.end(), category) == categories.end()) { categories.push_back(category); }
+        }
+    }
+
+    string merged;
+    for (const auto category : categories) {
+        if (!merged.empty()) { merged.push_back(','); }
+        merged.append(category);
+    }
+
+    return merged;
+}
+
+/**
+ * @brief Renders all category strings and places the jails in a perfect hash table.
+ */
+void CategoryTable::rebuild() {
+    m_defaultRendered = render({});
+
+    const auto bucketCount = nextPowerOfTwo(std::max<size_t>(1, m_jails.size() / 2));
+    m_bucketMask = bucketCount - 1;
+
+    vector<vector<size_t>> buckets(bucketCount);
+    for (size_t i = 0; i < m_jails.size(); i++) { buckets[hashKey(m_jails[i].jail) & m_bucketMask].push_back(i); }
+
+    // place the largest buckets first, while there's still plenty of room
+    vector<size_t> bucketOrder(bucketCount);
+    for (size_t i = 0; i < bucketCount; i++) { bucketOrder[i] = i; }
+    std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    for (auto slotCount = nextPowerOfTwo(std::max<size_t>(1, m_jails.size()));; slotCount *= 2) {
+        m_slotMask = slotCount - 1;
+        m_slots.assign(slotCount, Slot{});
+        m_displacements.assign(bucketCount, 0);
+
+        bool isPlaced = true;
+        vector<size_t> candidateSlots;
+        for (const auto bucket : bucketOrder) {
+            if (buckets[bucket].empty()) { break; }
+
+            uint32_t displacement = 0;
+            for (; displacement < MAX_DISPLACEMENT; displacement++) {
+                candidateSlots.clear();
+                for (const auto jailIndex : buckets[bucket]) {
+                    const auto slot = slotFor(hashKey(m_jails[jailIndex].jail), displacement);
+                    if (m_slots[slot].isUsed || std::find(candidateSlots.begin(), candidateSlots.end(), slot) != candidateSlots.end()) { break; }
+                    candidateSlots.push_back(slot);
+                }
+
+                if (candidateSlots.size() == buckets[bucket].size()) { break; }
+            }
+
+            if (displacement == MAX_DISPLACEMENT) {
+                isPlaced = false;
+                break;
+            }
+
+            m_displacements[bucket] = displacement;
+            for (size_t i = 0; i < candidateSlots.size(); i++) {
+                const auto& jail = m_jails[buckets[bucket][i]];
+                m_slots[candidateSlots[i]] = Slot{ jail.jail, render(jail.categories), true };
+            }
+        }
+
+        if (isPlaced) { break; }
+    }
+}
+
+/**
+ * @brief Renders the default categories followed by the given extra categories, skipping duplicates.
+ */
+string CategoryTable::render(const vector<int32_t>& extraCategories) const {
+    vector<int32_t> categories;
+    for (const auto& list : { std::cref(m_defaultCategories), std::cref(extraCategories) }) {
+        for (const auto category : list.get()) {
+            if (std::find(categories.begin(), categories.end(), category) == categories.end()) { categories.push_back(category); }
+        }
+    }
+
+    string rendered;
+    for (const auto category : categories) {
+        if (!rendered.empty()) { rendered.push_back(','); }
+        rendered.append(std::to_string(category));
+    }
+
+    return rendered;
+}
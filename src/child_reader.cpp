@@ -0,0 +1,162 @@
+/**
+ * @file child_reader.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the pipelined child process reader.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "child_reader.hpp"
+
+using std::error_code;
+using std::system_error;
+
+extern char** environ;
+
+ChildReader::ChildReader(const std::vector<string>& argv, ReadyCallback onReady): m_onReady(std::move(onReady)) {
+    int32_t pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC) != 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to create pipe"); }
+
+    // a bigger pipe means fewer context switches between the child and the producer
+    fcntl(pipeFds[1], F_SETPIPE_SZ, static_cast<int32_t>(CHUNK_SIZE));
+
+    std::vector<char*> childArgv;
+    for (const auto& argument : argv) { childArgv.push_back(const_cast<char*>(argument.c_str())); }
+    childArgv.push_back(nullptr);
+
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_adddup2(&fileActions, pipeFds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&fileActions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    const auto spawnResult = posix_spawnp(&m_pid, childArgv[0], &fileActions, nullptr, childArgv.data(), environ);
+    posix_spawn_file_actions_destroy(&fileActions);
+    close(pipeFds[1]);
+
+    if (spawnResult != 0) {
+        close(pipeFds[0]);
+        m_pid = -1;
+        throw system_error(error_code(spawnResult, std::generic_category()), "Failed to start " + argv[0]);
+    }
+
+    m_pipeFd = pipeFds[0];
+    m_producer = std::thread(&ChildReader::produce, this);
+}
+
+ChildReader::~ChildReader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopRequested = true;
+        // the producer may be blocked in read(2); terminating the child ends that
+        if (!m_isFinished && m_pid > 0) { kill(m_pid, SIGTERM); }
+    }
+    m_spaceAvailable.notify_all();
+
+    wait();
+}
+
+bool ChildReader::next(string& chunk) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_chunkAvailable.wait(lock, [&]() { return !m_chunks.empty() || m_isFinished; });
+
+    if (m_chunks.empty()) {
+        if (m_error) { std::rethrow_exception(m_error); }
+        return false;
+    }
+
+    chunk = std::move(m_chunks.front());
+    m_chunks.pop_front();
+    lock.unlock();
+    m_spaceAvailable.notify_one();
+
+    return true;
+}
+
+bool ChildReader::tryNext(string& chunk) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_chunks.empty()) { return false; }
+
+    chunk = std::move(m_chunks.front());
+    m_chunks.pop_front();
+    lock.unlock();
+    m_spaceAvailable.notify_one();
+
+    return true;
+}
+
+bool ChildReader::isDrained() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_isFinished || !m_chunks.empty()) { return false; }
+    if (m_error) { std::rethrow_exception(m_error); }
+
+    return true;
+}
+
+int32_t ChildReader::wait() {
+    if (m_producer.joinable()) { m_producer.join(); }
+
+    if (m_pipeFd >= 0) {
+        close(m_pipeFd);
+        m_pipeFd = -1;
+    }
+
+    if (m_pid > 0) {
+        int32_t status = 0;
+        while (waitpid(m_pid, &status, 0) < 0 && errno == EINTR) { }
+        m_exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        m_pid = -1;
+    }
+
+    return m_exitCode;
+}
+
+/**
+ * @brief Reads the pipe until the child closes it, queueing every chunk read.
+ */
+void ChildReader::produce() {
+    try {
+        for (;;) {
+            string chunk(CHUNK_SIZE, '\0');
+            const auto bytesRead = read(m_pipeFd, &chunk[0], chunk.size());
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            } else if (bytesRead < 0) {
+                throw system_error(error_code(errno, std::generic_category()), "Failed to read child output");
+            } else if (bytesRead == 0) {
+                break;
+            }
+            chunk.resize(static_cast<size_t>(bytesRead));
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_spaceAvailable.wait(lock, [&]() { return m_chunks.size() < MAX_QUEUED_CHUNKS || m_isStopRequested; });
+            if (m_isStopRequested) { break; }
+
+            m_chunks.push_back(std::move(chunk));
+            lock.unlock();
+            m_chunkAvailable.notify_one();
+            if (m_onReady) { m_onReady(); }
+        }
+    } catch (const system_error&) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isFinished = true;
+    }
+    m_chunkAvailable.notify_all();
+    if (m_onReady) { m_onReady(); }
+}
@@ -0,0 +1,329 @@
+/**
+ * @file cidr_trie.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the compressed, popcount-indexed prefix trie.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "cidr_trie.hpp"
+#include "string_splitter.hpp"
+
+using std::error_code;
+using std::runtime_error;
+using std::system_error;
+using std::vector;
+
+static constexpr char       IMAGE_MAGIC[8] = { 'F', '2', 'A', 'B', 'C', 'I', 'D', 'R' }; //!< Identifies a compiled trie image
+static constexpr uint32_t   IMAGE_VERSION = 1; //!< The current version of the image format
+static constexpr uint8_t    MAX_STRIDE = 6; //!< The maximum amount of bits consumed per node (2^6 = 64 slots)
+static constexpr uint8_t    MAX_SKIP = 64; //!< The maximum amount of bits skipped by path compression
+
+/**
+ * @brief The header at the start of a compiled image.
+ */
+struct ImageHeader {
+    char        magic[8]; //!< @see IMAGE_MAGIC
+    uint32_t    version; //!< @see IMAGE_VERSION
+    uint32_t    nodeSize; //!< sizeof(CidrTrie::Node)
+    uint64_t    nodeCount; //!< The amount of nodes following the header
+    uint64_t    reserved; //!< Pads the header to 32 bytes
+};
+
+static_assert(sizeof(CidrTrie::Node) == 32, "Trie nodes must be 32 bytes");
+static_assert(sizeof(ImageHeader) == 32, "Image header must be 32 bytes");
+
+/**
+ * @brief Extracts len (1-64) bits, starting at bit pos (counted from the most significant bit), from a 128-bit address.
+ */
+static inline uint64_t extractBits(uint64_t high, uint64_t low, uint32_t pos, uint32_t len) {
+    if (pos >= 64) {
+        return (low << (pos - 64)) >> (64 - len);
+    } else if (pos + len <= 64) {
+        return (high << pos) >> (64 - len);
+    }
+
+    // spans both halves; pos is in (0, 64) here
+    return ((high << pos) | (low >> (64 - pos))) >> (64 - len);
+}
+
+namespace {
+
+    /**
+     * @brief The uncompressed binary trie the compressed trie is built from.
+     */
+    class BinaryTrie {
+        public:
+            struct Node {
+                int32_t child[2] = { -1, -1 };
+                bool    terminal = false;
+            };
+
+            BinaryTrie(): m_nodes(1) { }
+
+            void insert(const CidrTrie::Prefix& prefix) {
+                const auto high = prefix.address.high();
+                const auto low = prefix.address.low();
+
+                int32_t current = 0;
+                for (uint32_t depth = 0; depth < prefix.length; depth++) {
+                    if (m_nodes[current].terminal) { return; } // already covered by a shorter range
+
+                    const auto bit = extractBits(high, low, depth, 1);
+                    if (m_nodes[current].child[bit] < 0) {
+                        m_nodes[current].child[bit] = static_cast<int32_t>(m_nodes.size());
+                        m_nodes.emplace_back();
+                    }
+                    current = m_nodes[current].child[bit];
+                }
+
+                // everything below is covered now; the subtree becomes unreachable
+                m_nodes[current] = Node{};
+                m_nodes[current].terminal = true;
+            }
+
+            const Node& operator[](int32_t index) const { return m_nodes[index]; }
+
+        private:
+            vector<Node> m_nodes;
+    };
+
+}
+
+CidrTrie::CidrTrie(const vector<Prefix>& prefixes) {
+    BinaryTrie binaryTrie;
+    for (const auto& prefix : prefixes) { binaryTrie.insert(prefix); }
+
+    struct PendingNode {
+        int32_t     binaryNode; //!< The (non-terminal) binary node the compressed node starts at
+        uint32_t    depth; //!< The depth of the binary node
+        size_t      index; //!< The index of the compressed node
+    };
+
+    // build breadth first, so that all children of a node are contiguous
+    m_ownedNodes.emplace_back();
+    std::deque<PendingNode> pending{ { 0, 0, 0 } };
+
+    if (binaryTrie[0].terminal) {
+        // a /0 range covers everything
+        m_ownedNodes[0] = Node{ 0, 0b11, 0, 0, 0, 1, 0 };
+        pending.clear();
+    }
+
+    while (!pending.empty()) {
+        const auto item = pending.front();
+        pending.pop_front();
+
+        Node node{};
+        auto current = item.binaryNode;
+
+        // path compression: follow chains of non-terminal, single-child nodes
+        while (node.skipLength < MAX_SKIP && item.depth + node.skipLength + 1 < 128) {
+            const auto& binaryNode = binaryTrie[current];
+            if ((binaryNode.child[0] >= 0) == (binaryNode.child[1] >= 0)) { break; }
+
+            const uint64_t bit = binaryNode.child[0] >= 0 ? 0 : 1;
+            if (binaryTrie[binaryNode.child[bit]].terminal) { break; }
+
+            node.skipValue = (node.skipValue << 1) | bit;
+            node.skipLength++;
+            current = binaryNode.child[bit];
+        }
+
+        const uint32_t strideStart = item.depth + node.skipLength;
+        node.stride = static_cast<uint8_t>(std::min<uint32_t>(MAX_STRIDE, 128 - strideStart));
+
+        vector<int32_t> childNodes;
+        for (uint64_t slot = 0; slot < (1ull << node.stride); slot++) {
+            auto walker = current;
+            bool isLeaf = false;
+
+            for (int32_t bitIndex = node.stride - 1; bitIndex >= 0 && walker >= 0; bitIndex--) {
+                walker = binaryTrie[walker].child[(slot >> bitIndex) & 1];
+                if (walker >= 0 && binaryTrie[walker].terminal) {
+                    isLeaf = true;
+                    break;
+                }
+            }
+
+            if (isLeaf) {
+                node.leaves |= 1ull << slot;
+            } else if (walker >= 0) {
+                node.children |= 1ull << slot;
+                childNodes.push_back(walker);
+            }
+        }
+
+        node.childBase = static_cast<uint32_t>(m_ownedNodes.size());
+        for (const auto child : childNodes) {
+            pending.push_back({ child, strideStart + node.stride, m_ownedNodes.size() });
+            m_ownedNodes.emplace_back();
+        }
+
+        m_ownedNodes[item.index] = node;
+    }
+
+    m_nodes = m_ownedNodes.data();
+    m_nodeCount = m_ownedNodes.size();
+}
+
+CidrTrie::CidrTrie(MappedFile&& image, const Node* nodes, size_t nodeCount):
+m_image(std::make_unique<MappedFile>(std::move(image))), m_nodes(nodes), m_nodeCount(nodeCount) { }
+
+CidrTrie CidrTrie::load(const string& path) {
+    MappedFile file(path);
+    const auto contents = file.view();
+
+    if (contents.size() >= sizeof(ImageHeader) && std::memcmp(contents.data(), IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) == 0) {
+        ImageHeader header;
+        std::memcpy(&header, contents.data(), sizeof(header));
+
+        if (header.version != IMAGE_VERSION || header.nodeSize != sizeof(Node) || header.nodeCount == 0 ||
+            contents.size() != sizeof(ImageHeader) + header.nodeCount * sizeof(Node)) {
+            throw runtime_error(path + " is a damaged or incompatible exclusion image");
+        }
+
+        // the mapping is page-aligned, so the nodes are suitably aligned, too
+        const auto* nodes = reinterpret_cast<const Node*>(contents.data() + sizeof(ImageHeader));
+
+        // contains() trusts the image: children must come after their parent (so lookups can't loop), and no path may
+        // consume more than the 128 bits of an address. As children only point forward, a single pass sees every
+        // parent before its children, and each node's depth is the deepest path leading to it.
+        vector<uint8_t> depths(header.nodeCount, 0);
+        for (size_t i = 0; i < header.nodeCount; i++) {
+            const auto& node = nodes[i];
+            const uint32_t childDepth = depths[i] + node.skipLength + node.stride;
+            if (node.stride == 0 || node.stride > MAX_STRIDE || node.skipLength > MAX_SKIP || childDepth > 128) {
+                throw runtime_error(path + " is a damaged exclusion image");
+            }
+            if (node.children == 0) { continue; }
+
+            const uint64_t childEnd = static_cast<uint64_t>(node.childBase) + __builtin_popcountll(node.children);
+            if (node.childBase <= i || childEnd > header.nodeCount) { throw runtime_error(path + " is a damaged exclusion image"); }
+            for (auto child = node.childBase; child < childEnd; child++) { depths[child] = std::max(depths[child], static_cast<uint8_t>(childDepth)); }
+        }
+
+        return CidrTrie(std::move(file), nodes, header.nodeCount);
+    }
+
+    vector<Prefix> prefixes;
+    size_t lineNumber = 0;
+    for (auto line : StringSplit(contents, '\n')) {
+        lineNumber++;
+
+        if (const auto commentPos = line.find('#'); commentPos != string_view::npos) { line = line.substr(0, commentPos); }
+        while (!line.empty() && isspace(static_cast<unsigned char>(line.front()))) { line.remove_prefix(1); }
+        while (!line.empty() && isspace(static_cast<unsigned char>(line.back()))) { line.remove_suffix(1); }
+        if (line.empty()) { continue; }
+
+        Prefix prefix;
+        if (!parsePrefix(line, prefix)) {
+            throw runtime_error(path + ":" + std::to_string(lineNumber) + ": invalid CIDR range '" + string(line) + "'");
+        }
+        prefixes.push_back(prefix);
+    }
+
+    return CidrTrie(prefixes);
+}
+
+bool CidrTrie::contains(const IpAddress& address) const {
+    const auto high = address.high();
+    const auto low = address.low();
+
+    const Node* node = m_nodes;
+    uint32_t depth = 0;
+    for (;;) {
+        if (node->skipLength > 0) {
+            if (extractBits(high, low, depth, node->skipLength) != node->skipValue) { return false; }
+            depth += node->skipLength;
+        }
+
+        const auto slot = extractBits(high, low, depth, node->stride);
+        depth += node->stride;
+
+        const auto slotBit = 1ull << slot;
+        if (node->leaves & slotBit) {
+            return true;
+        } else if ((node->children & slotBit) == 0) {
+            return false;
+        }
+
+        node = m_nodes + node->childBase + __builtin_popcountll(node->children & (slotBit - 1));
+    }
+}
+
+void CidrTrie::writeImage(const string& path) const {
+    const auto tmpPath = path + ".tmp";
+    const int32_t fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to create " + tmpPath); }
+
+    ImageHeader header{};
+    std::memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+    header.version = IMAGE_VERSION;
+    header.nodeSize = sizeof(Node);
+    header.nodeCount = m_nodeCount;
+
+    const auto writeAll = [&](const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            const auto written = write(fd, bytes, size);
+            if (written < 0 && errno == EINTR) { continue; }
+            if (written < 0) { return false; }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    };
+
+    bool isWritten = writeAll(&header, sizeof(header)) && writeAll(m_nodes, m_nodeCount * sizeof(Node)) && fsync(fd) == 0;
+    const error_code writeError(errno, std::generic_category());
+    isWritten = close(fd) == 0 && isWritten;
+
+    if (!isWritten || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        const error_code error = isWritten ? error_code(errno, std::generic_category()) : writeError;
+        unlink(tmpPath.c_str());
+        throw system_error(error, "Failed to write exclusion image " + path);
+    }
+}
+
+bool CidrTrie::parsePrefix(string_view text, Prefix& out) {
+    const auto slashPos = text.find('/');
+    if (!IpAddress::parse(text.substr(0, slashPos), out.address)) { return false; }
+
+    const uint32_t offset = out.address.isV4() ? 96 : 0;
+    uint32_t length = 128 - offset;
+
+    if (slashPos != string_view::npos) {
+        const auto lengthText = text.substr(slashPos + 1);
+        if (lengthText.empty() || lengthText.size() > 3) { return false; }
+
+        length = 0;
+        for (const auto c : lengthText) {
+            if (c < '0' || c > '9') { return false; }
+            length = length * 10 + static_cast<uint32_t>(c - '0');
+        }
+        if (length > 128 - offset) { return false; }
+    }
+
+    out.length = static_cast<uint8_t>(length + offset);
+
+    // clear host bits
+    for (uint32_t bit = out.length; bit < 128; bit++) {
+        out.address.bytes[bit / 8] &= static_cast<uint8_t>(~(0x80u >> (bit % 8)));
+    }
+
+    return true;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file comment_template.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the precompiled report comment.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <stdexcept>
+
+#include "comment_template.hpp"
+
+using std::runtime_error;
+
+/**
+ * @brief Appends text to a buffer, doubling any double quotes (the comment is a quoted CSV field).
+ */
+static void appendEscaped(fmt::memory_buffer& buffer, string_view text) {
+    for (auto quote = text.find('"'); quote != string_view::npos; quote = text.find('"')) {
+        buffer.append(text.substr(0, quote + 1));
+        buffer.push_back('"');
+        text.remove_prefix(quote + 1);
+    }
+    buffer.append(text);
+}
+
+CommentTemplate::CommentTemplate(string_view format) {
+    size_t nextIndex = 0;
+
+    while (!format.empty()) {
+        const auto brace = format.find_first_of("{}");
+        appendLiteral(format.substr(0, brace));
+        if (brace == string_view::npos) { break; }
+
+        const auto isOpening = format[brace] == '{';
+        if (brace + 1 < format.size() && format[brace + 1] == format[brace]) {
+            // "{{" or "}}"
+            appendLiteral(format.substr(brace, 1));
+            format.remove_prefix(brace + 2);
+            continue;
+        }
+        if (!isOpening) { throw runtime_error("Unmatched '}' in comment"); }
+
+        const auto closing = format.find('}', brace);
+        if (closing == string_view::npos) { throw runtime_error("Unterminated variable in comment"); }
+
+        const auto variable = format.substr(brace + 1, closing - brace - 1);
+        const auto colon = variable.find(':');
+        const auto id = variable.substr(0, colon);
+
+        size_t index = 0;
+        if (id.empty()) {
+            index = nextIndex++;
+        } else if (id.find_first_not_of("0123456789") == string_view::npos && id.size() <= 2) {
+            for (const auto digit : id) { index = index * 10 + static_cast<size_t>(digit - '0'); }
+        } else {
+            throw runtime_error("Unknown variable {" + string(id) + "} in comment");
+        }
+        if (index >= static_cast<size_t>(Field::COUNT)) { throw runtime_error("Unknown variable {" + std::to_string(index) + "} in comment"); }
+
+        Segment segment{ true, static_cast<Field>(index), "" };
+        if (colon != string_view::npos) {
+            segment.text = "{" + string(variable.substr(colon)) + "}";
+            try {
+                const string_view sample = "sample";
+                static_cast<void>(fmt::vformat(segment.text, fmt::make_format_args(sample)));
+            } catch (const fmt::format_error& ex) {
+                throw runtime_error("Invalid format for variable {" + string(variable) + "} in comment: " + ex.what());
+            }
+        }
+
+        m_segments.push_back(std::move(segment));
+        format.remove_prefix(closing + 1);
+    }
+}
+
+CommentTemplate CommentTemplate::bind(Field field, string_view value) const {
+    CommentTemplate bound;
+
+    for (const auto& segment : m_segments) {
+        if (!segment.isVariable) {
+            bound.appendEscapedText(segment.text);
+        } else if (segment.field == field) {
+            fmt::memory_buffer buffer;
+            appendValue(buffer, segment, value);
+            bound.appendEscapedText(string_view(buffer.data(), buffer.size()));
+        } else {
+            bound.m_segments.push_back(segment);
+        }
+    }
+
+    return bound;
+}
+
+bool CommentTemplate::uses(Field field) const {
+    for (const auto& segment : m_segments) {
+        if (segment.isVariable && segment.field == field) { return true; }
+    }
+
+    return false;
+}
+
+void CommentTemplate::render(fmt::memory_buffer& buffer, const Values& values) const {
+    for (const auto& segment : m_segments) {
+        if (segment.isVariable) {
+            appendValue(buffer, segment, values[static_cast<size_t>(segment.field)]);
+        } else {
+            buffer.append(segment.text);
+        }
+    }
+}
+
+/**
+ * @brief Appends literal text to the template.
+ */
+void CommentTemplate::appendLiteral(string_view text) {
+    fmt::memory_buffer buffer;
+    appendEscaped(buffer, text);
+    appendEscapedText(string_view(buffer.data(), buffer.size()));
+}
+
+/**
+ * @brief Appends already escaped text to the template, merging it into the previous segment if that is text too.
+ */
+void CommentTemplate::appendEscapedText(string_view text) {
+    if (text.empty()) { return; }
+    if (m_segments.empty() || m_segments.back().isVariable) { m_segments.push_back({ false, Field::Jails, "" }); }
+
+    m_segments.back().text.append(text);
+}
+
+/**
+ * @brief Appends a variable's value to a buffer, applying the variable's format (if any).
+ */
+void CommentTemplate::appendValue(fmt::memory_buffer& buffer, const Segment& segment, string_view value) {
+    if (segment.text.empty()) {
+        appendEscaped(buffer, value);
+        return;
+    }
+
+    fmt::memory_buffer formatted;
+    fmt::vformat_to(std::back_inserter(formatted), segment.text, fmt::make_format_args(value));
+    appendEscaped(buffer, string_view(formatted.data(), formatted.size()));
+}
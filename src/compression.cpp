@@ -0,0 +1,389 @@
+/**
+ * @file compression.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the streaming (de)compression used for archived output.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#if defined(FAIL2ABUSEIPDB_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+#include "compression.hpp"
+
+using std::error_code;
+using std::runtime_error;
+using std::system_error;
+
+static constexpr string_view GZIP_MAGIC = "\x1f\x8b"; //!< The first bytes of a gzip member
+static constexpr string_view ZSTD_MAGIC = "\x28\xb5\x2f\xfd"; //!< The first bytes of a zstd frame
+static constexpr size_t CHUNK_SIZE = 256 * 1024; //!< The amount of output produced per call into zlib
+static constexpr int32_t GZIP_LEVEL = 1; //!< zlib's fastest level; higher levels compress CSV only slightly better, at several times the cost
+
+static_assert(CompressedWriter::BLOCK_SIZE <= UINT_MAX, "Blocks must fit into zlib's 32-bit lengths");
+
+bool isCompressionSupported(Compression compression) {
+#if defined(FAIL2ABUSEIPDB_WITH_ZSTD)
+    return true;
+#else
+    return compression != Compression::Zstd;
+#endif
+}
+
+bool parseCompression(string_view name, Compression& out) {
+    if (name == "none") {
+        out = Compression::None;
+    } else if (name == "gzip" || name == "gz") {
+        out = Compression::Gzip;
+    } else if (name == "zstd" || name == "zst") {
+        out = Compression::Zstd;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+Compression compressionForPath(string_view path) {
+    const auto endsWith = [&](string_view suffix) { return path.size() >= suffix.size() && path.substr(path.size() - suffix.size()) == suffix; };
+
+    if (endsWith(".gz")) { return Compression::Gzip; }
+    if (endsWith(".zst")) { return Compression::Zstd; }
+    return Compression::None;
+}
+
+Compression detectCompression(string_view data) {
+    if (data.substr(0, GZIP_MAGIC.size()) == GZIP_MAGIC) { return Compression::Gzip; }
+    if (data.substr(0, ZSTD_MAGIC.size()) == ZSTD_MAGIC) { return Compression::Zstd; }
+    return Compression::None;
+}
+
+/**
+ * @brief Decompresses gzip data (possibly several concatenated members).
+ */
+static void decompressGzip(string_view data, const std::function<void(string_view)>& onChunk) {
+    z_stream stream{};
+    if (inflateInit2(&stream, 15 + 32) != Z_OK) { throw runtime_error("Failed to initialise zlib"); }
+    const std::unique_ptr<z_stream, decltype(&inflateEnd)> streamGuard(&stream, &inflateEnd);
+
+    std::vector<char> buffer(CHUNK_SIZE);
+    size_t offset = 0; // the start of the data not passed to zlib yet
+    for (;;) {
+        if (stream.avail_in == 0 && offset < data.size()) {
+            // mapped archives may exceed zlib's 32-bit lengths
+            const auto length = std::min<size_t>(data.size() - offset, UINT_MAX);
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + offset));
+            stream.avail_in = static_cast<uInt>(length);
+            offset += length;
+        }
+
+        stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+        stream.avail_out = static_cast<uInt>(buffer.size());
+        const auto result = inflate(&stream, Z_NO_FLUSH);
+
+        const auto produced = buffer.size() - stream.avail_out;
+        if (produced > 0) { onChunk(string_view(buffer.data(), produced)); }
+
+        if (result == Z_STREAM_END) {
+            if (stream.avail_in == 0 && offset == data.size()) { return; }
+            inflateReset(&stream);
+        } else if (result == Z_BUF_ERROR && stream.avail_in == 0 && offset == data.size()) {
+            throw runtime_error("The gzip data is truncated");
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+            throw runtime_error(string("The gzip data is damaged: ") + (stream.msg != nullptr ? stream.msg : "unknown error"));
+        }
+    }
+}
+
+/**
+ * @brief Decompresses zstd data (possibly several concatenated frames).
+ */
+static void decompressZstd(string_view data, const std::function<void(string_view)>& onChunk) {
+#if defined(FAIL2ABUSEIPDB_WITH_ZSTD)
+    const std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), &ZSTD_freeDCtx);
+    if (context == nullptr) { throw runtime_error("Failed to initialise zstd"); }
+
+    std::vector<char> buffer(ZSTD_DStreamOutSize());
+    ZSTD_inBuffer input{ data.data(), data.size(), 0 };
+    size_t result = 0;
+    for (;;) {
+        ZSTD_outBuffer output{ buffer.data(), buffer.size(), 0 };
+        result = ZSTD_decompressStream(context.get(), &output, &input);
+        if (ZSTD_isError(result)) { throw runtime_error(string("The zstd data is damaged: ") + ZSTD_getErrorName(result)); }
+
+        if (output.pos > 0) { onChunk(string_view(buffer.data(), output.pos)); }
+        // a full output buffer may mean there's more to flush
+        if (input.pos == input.size && output.pos < output.size) { break; }
+    }
+
+    if (result != 0) { throw runtime_error("The zstd data is truncated"); }
+#else
+    static_cast<void>(data);
+    static_cast<void>(onChunk);
+    throw runtime_error("This build doesn't support zstd");
+#endif
+}
+
+void decompress(string_view data, const std::function<void(string_view)>& onChunk) {
+    switch (detectCompression(data)) {
+        case Compression::Gzip:
+            decompressGzip(data, onChunk);
+            break;
+        case Compression::Zstd:
+            decompressZstd(data, onChunk);
+            break;
+        default:
+            onChunk(data);
+            break;
+    }
+}
+
+/**
+ * @brief Compresses the blocks of a stream, keeping the state carried from block to block.
+ */
+struct CompressedWriter::Encoder {
+    virtual ~Encoder() = default;
+
+    /**
+     * @brief Compresses a block.
+     *
+     * @param input The block.
+     * @param blockEnd How the block ends the stream.
+     * @param output A buffer the encoder may use for the compressed data.
+     *
+     * @return string_view The compressed data (in output, or the input itself).
+     */
+    virtual string_view encode(string_view input, BlockEnd blockEnd, std::vector<char>& output) = 0;
+};
+
+/**
+ * @brief Passes the blocks on as they are.
+ */
+struct PlainEncoder: CompressedWriter::Encoder {
+    string_view encode(string_view input, CompressedWriter::BlockEnd, std::vector<char>&) override { return input; }
+};
+
+/**
+ * @brief Compresses the blocks into a single gzip member.
+ */
+struct GzipEncoder: CompressedWriter::Encoder {
+    z_stream stream{}; //!< zlib's state
+
+    GzipEncoder() {
+        if (deflateInit2(&stream, GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw runtime_error("Failed to initialise zlib");
+        }
+    }
+
+    ~GzipEncoder() override { deflateEnd(&stream); }
+
+    string_view encode(string_view input, CompressedWriter::BlockEnd blockEnd, std::vector<char>& output) override {
+        const auto flush = blockEnd == CompressedWriter::BlockEnd::Finish ? Z_FINISH :
+                           blockEnd == CompressedWriter::BlockEnd::Flush ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = static_cast<uInt>(input.size());
+
+        size_t used = 0;
+        for (;;) {
+            output.resize(used + CHUNK_SIZE);
+            stream.next_out = reinterpret_cast<Bytef*>(output.data() + used);
+            stream.avail_out = static_cast<uInt>(CHUNK_SIZE);
+
+            const auto result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR) { throw runtime_error("Failed to compress the output"); }
+            used += CHUNK_SIZE - stream.avail_out;
+
+            // deflate() is done once it leaves room in the output (or, when finishing, once the stream has ended)
+            if (flush == Z_FINISH ? result == Z_STREAM_END : stream.avail_out != 0) { break; }
+        }
+
+        return string_view(output.data(), used);
+    }
+};
+
+#if defined(FAIL2ABUSEIPDB_WITH_ZSTD)
+/**
+ * @brief Compresses the blocks into a single zstd frame.
+ */
+struct ZstdEncoder: CompressedWriter::Encoder {
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context{ ZSTD_createCCtx(), &ZSTD_freeCCtx }; //!< zstd's state
+
+    ZstdEncoder() {
+        if (context == nullptr) { throw runtime_error("Failed to initialise zstd"); }
+        ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+    }
+
+    string_view encode(string_view input, CompressedWriter::BlockEnd blockEnd, std::vector<char>& output) override {
+        const auto mode = blockEnd == CompressedWriter::BlockEnd::Finish ? ZSTD_e_end :
+                          blockEnd == CompressedWriter::BlockEnd::Flush ? ZSTD_e_flush : ZSTD_e_continue;
+        ZSTD_inBuffer in{ input.data(), input.size(), 0 };
+        const auto chunkSize = ZSTD_CStreamOutSize();
+
+        size_t used = 0;
+        for (;;) {
+            output.resize(used + chunkSize);
+            ZSTD_outBuffer out{ output.data() + used, chunkSize, 0 };
+
+            const auto remaining = ZSTD_compressStream2(context.get(), &out, &in, mode);
+            if (ZSTD_isError(remaining)) { throw runtime_error(string("Failed to compress the output: ") + ZSTD_getErrorName(remaining)); }
+            used += out.pos;
+
+            if (mode == ZSTD_e_continue ? in.pos == in.size : remaining == 0) { break; }
+        }
+
+        return string_view(output.data(), used);
+    }
+};
+#endif
+
+CompressedWriter::CompressedWriter(const string& path, Compression compression) {
+    switch (compression) {
+        case Compression::Gzip:
+            m_encoder = std::make_unique<GzipEncoder>();
+            break;
+        case Compression::Zstd:
+#if defined(FAIL2ABUSEIPDB_WITH_ZSTD)
+            m_encoder = std::make_unique<ZstdEncoder>();
+            break;
+#else
+            throw runtime_error("This build doesn't support zstd");
+#endif
+        default:
+            m_encoder = std::make_unique<PlainEncoder>();
+            break;
+    }
+
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to create " + path); }
+
+    for (auto& block : m_blocks) { block.reserve(BLOCK_SIZE); }
+    m_worker = std::thread(&CompressedWriter::runWorker, this);
+}
+
+CompressedWriter::~CompressedWriter() {
+    try {
+        finish();
+    } catch (const std::exception&) {
+        // nothing sensible left to do
+    }
+}
+
+void CompressedWriter::write(string_view data) {
+    m_bytesIn += data.size();
+
+    while (!data.empty()) {
+        auto& block = m_blocks[m_fillingBlock];
+        const auto length = std::min(data.size(), BLOCK_SIZE - block.size());
+        block.insert(block.end(), data.data(), data.data() + length);
+        data.remove_prefix(length);
+
+        if (block.size() == BLOCK_SIZE) { submit(BlockEnd::Continue); }
+    }
+}
+
+void CompressedWriter::flush() {
+    submit(BlockEnd::Flush);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    waitForWorker(lock);
+}
+
+void CompressedWriter::finish() {
+    if (m_isFinished) { return; }
+    m_isFinished = true;
+
+    {
+        // even after an error, the worker must be told to stop
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&]() { return !m_hasPendingBlock; });
+        m_pendingBlockEnd = BlockEnd::Finish;
+        m_hasPendingBlock = true;
+    }
+    m_condition.notify_all();
+    m_worker.join();
+
+    const auto closeResult = close(m_fd);
+    const error_code closeError(errno, std::generic_category());
+    m_fd = -1;
+
+    if (m_error != nullptr) { std::rethrow_exception(m_error); }
+    if (closeResult != 0) { throw system_error(closeError, "Failed to write the output"); }
+}
+
+/**
+ * @brief Hands the block being filled to the worker (once it's done with the previous one) and switches to the other.
+ */
+void CompressedWriter::submit(BlockEnd blockEnd) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        waitForWorker(lock);
+
+        m_pendingBlockEnd = blockEnd;
+        m_hasPendingBlock = true;
+        m_fillingBlock ^= 1;
+        m_blocks[m_fillingBlock].clear();
+    }
+    m_condition.notify_all();
+}
+
+/**
+ * @brief Waits until the worker is done with the pending block, and rethrows its error (if any).
+ */
+void CompressedWriter::waitForWorker(std::unique_lock<std::mutex>& lock) {
+    m_condition.wait(lock, [&]() { return !m_hasPendingBlock; });
+    if (m_error != nullptr) { std::rethrow_exception(m_error); }
+}
+
+/**
+ * @brief Compresses and writes the submitted blocks until the stream is finished.
+ */
+void CompressedWriter::runWorker() {
+    std::vector<char> output;
+
+    for (;;) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&]() { return m_hasPendingBlock; });
+        const auto blockEnd = m_pendingBlockEnd;
+        // when finishing, the block being filled is the last one; otherwise it's the one filled before the switch
+        const auto& block = m_blocks[blockEnd == BlockEnd::Finish ? m_fillingBlock : m_fillingBlock ^ 1];
+        const bool hasFailed = m_error != nullptr;
+        lock.unlock();
+
+        std::exception_ptr error;
+        if (!hasFailed) {
+            try {
+                auto data = m_encoder->encode(string_view(block.data(), block.size()), blockEnd, output);
+                while (!data.empty()) {
+                    const auto bytesWritten = ::write(m_fd, data.data(), data.size());
+                    if (bytesWritten < 0 && errno == EINTR) { continue; }
+                    if (bytesWritten < 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to write the output"); }
+                    data.remove_prefix(static_cast<size_t>(bytesWritten));
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        lock.lock();
+        if (error != nullptr) { m_error = error; }
+        m_hasPendingBlock = false;
+        lock.unlock();
+        m_condition.notify_all();
+
+        if (blockEnd == BlockEnd::Finish) { return; }
+    }
+}
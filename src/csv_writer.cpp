@@ -0,0 +1,73 @@
+/**
+ * @file csv_writer.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the buffered, streaming CSV emitter.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#include <unistd.h>
+
+#include "csv_writer.hpp"
+
+using std::error_code;
+using std::system_error;
+
+CsvWriter::CsvWriter(int32_t fd, size_t bufferSize): m_bufferSize(bufferSize) {
+    m_sink = [fd](string_view data, size_t) {
+        while (!data.empty()) {
+            const auto bytesWritten = write(fd, data.data(), data.size());
+            if (bytesWritten < 0 && errno == EINTR) {
+                continue;
+            } else if (bytesWritten < 0) {
+                throw system_error(error_code(errno, std::generic_category()), "Failed to write CSV output");
+            }
+
+            data.remove_prefix(static_cast<size_t>(bytesWritten));
+        }
+    };
+
+    // leave some room so that the row which crosses the threshold doesn't cause a reallocation
+    m_buffer.reserve(m_bufferSize + 4096);
+}
+
+CsvWriter::CsvWriter(BatchSink sink, size_t maxBatchRows, size_t maxBatchBytes):
+m_sink(std::move(sink)), m_bufferSize(maxBatchBytes), m_maxBatchRows(maxBatchRows), m_maxBatchBytes(maxBatchBytes) {
+    // large batches grow the buffer as needed instead of reserving all of it up front
+    m_buffer.reserve(std::min(m_bufferSize, DEFAULT_BUFFER_SIZE) + 4096);
+}
+
+CsvWriter::~CsvWriter() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+        // nothing sensible left to do
+    }
+}
+
+/**
+ * @brief Passes the first byteCount bytes (holding rowCount rows) of the buffer on and removes them from it.
+ */
+void CsvWriter::flushPrefix(size_t byteCount, size_t rowCount) {
+    if (byteCount == 0) { return; }
+
+    try {
+        m_sink(string_view(m_buffer.data(), byteCount), rowCount);
+    } catch (...) {
+        m_buffer.clear();
+        m_bufferedRows = 0;
+        throw;
+    }
+
+    m_bytesWritten += byteCount;
+    const auto remaining = m_buffer.size() - byteCount;
+    if (remaining > 0) { std::copy(m_buffer.data() + byteCount, m_buffer.data() + m_buffer.size(), m_buffer.data()); }
+    m_buffer.resize(remaining);
+    m_bufferedRows -= rowCount;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file f2b_database.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the reader for fail2ban's SQLite database.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <memory>
+#include <stdexcept>
+
+#include <sqlite3.h>
+
+#include "f2b_database.hpp"
+
+using std::runtime_error;
+
+using statement_t = std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)>;
+
+static constexpr string_view FAILURES_KEY = "\"failures\":"; //!< Precedes the failure count in a ban's data
+
+/**
+ * @brief Prepares a statement, throwing if it can't be compiled.
+ */
+static statement_t prepare(sqlite3* database, string_view sql) {
+    sqlite3_stmt* statement = nullptr;
+    if (sqlite3_prepare_v2(database, sql.data(), static_cast<int32_t>(sql.size()), &statement, nullptr) != SQLITE_OK) {
+        throw runtime_error(string("Failed to query fail2ban's database: ") + sqlite3_errmsg(database));
+    }
+
+    return statement_t(statement, &sqlite3_finalize);
+}
+
+/**
+ * @brief Gets a text column as a view (valid until the statement is stepped again).
+ */
+static string_view columnText(sqlite3_stmt* statement, int32_t column) {
+    const auto* text = reinterpret_cast<const char*>(sqlite3_column_text(statement, column));
+    return text == nullptr ? string_view{} : string_view(text, static_cast<size_t>(sqlite3_column_bytes(statement, column)));
+}
+
+/**
+ * @brief Extracts the failure count from a ban's data, e.g. `{"matches": [...], "failures": 5}`.
+ *
+ * @remarks The data is JSON written by fail2ban; the matched log lines precede the count and may contain anything but an
+ * unescaped quote, so the last unescaped occurrence of the key is the count's.
+ *
+ * @return int32_t The failure count, or -1 if the data doesn't contain one.
+ */
+static int32_t parseFailures(string_view data) {
+    auto keyPos = data.rfind(FAILURES_KEY);
+    while (keyPos != string_view::npos && keyPos > 0 && data[keyPos - 1] == '\\') {
+        keyPos = keyPos > 1 ? data.rfind(FAILURES_KEY, keyPos - 1) : string_view::npos;
+    }
+    if (keyPos == string_view::npos) { return -1; }
+
+    auto value = data.substr(keyPos + FAILURES_KEY.size());
+    while (!value.empty() && value.front() == ' ') { value.remove_prefix(1); }
+
+    int64_t failures = 0;
+    size_t digits = 0;
+    for (; digits < value.size() && digits < 10 && value[digits] >= '0' && value[digits] <= '9'; digits++) {
+        failures = failures * 10 + (value[digits] - '0');
+    }
+
+    return digits == 0 || failures > INT32_MAX ? -1 : static_cast<int32_t>(failures);
+}
+
+Fail2BanDatabase::Fail2BanDatabase(const string& path) {
+    if (sqlite3_open_v2(path.c_str(), &m_database, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        const string error = m_database != nullptr ? sqlite3_errmsg(m_database) : "out of memory";
+        sqlite3_close(m_database);
+        throw runtime_error("Failed to open " + path + ": " + error);
+    }
+    sqlite3_busy_timeout(m_database, BUSY_TIMEOUT_MS);
+
+    try {
+        bool hasBans = false;
+        const auto columns = prepare(m_database, "PRAGMA table_info(bans)");
+        while (sqlite3_step(columns.get()) == SQLITE_ROW) {
+            hasBans = true;
+            if (columnText(columns.get(), 1) == "bantime") { m_hasBanTime = true; }
+        }
+        if (!hasBans) { throw runtime_error(path + " is not a fail2ban database (no bans table)"); }
+    } catch (...) {
+        sqlite3_close(m_database);
+        throw;
+    }
+}
+
+Fail2BanDatabase::~Fail2BanDatabase() {
+    sqlite3_close(m_database);
+}
+
+std::vector<string> Fail2BanDatabase::jails() const {
+    std::vector<string> jails;
+    const auto statement = prepare(m_database, "SELECT name FROM jails ORDER BY rowid");
+
+    int32_t result;
+    while ((result = sqlite3_step(statement.get())) == SQLITE_ROW) { jails.emplace_back(columnText(statement.get(), 0)); }
+    if (result != SQLITE_DONE) { throw runtime_error(string("Failed to read jails from fail2ban's database: ") + sqlite3_errmsg(m_database)); }
+
+    return jails;
+}
+
+size_t Fail2BanDatabase::readBans(string_view jail, int64_t after, int64_t before, bool activeOnly, const BanCallback& callback) const {
+    // (jail, timeofban) is covered by fail2ban's bans_jail_timeofban_ip index
+    const auto statement = prepare(m_database, activeOnly && m_hasBanTime ?
+        "SELECT ip, timeofban, data FROM bans WHERE jail = ?1 AND timeofban > ?2 AND timeofban < ?3 "
+            "AND (bantime < 0 OR timeofban + bantime > ?3) ORDER BY timeofban" :
+        "SELECT ip, timeofban, data FROM bans WHERE jail = ?1 AND timeofban > ?2 AND timeofban < ?3 ORDER BY timeofban");
+    sqlite3_bind_text(statement.get(), 1, jail.data(), static_cast<int32_t>(jail.size()), SQLITE_STATIC);
+    sqlite3_bind_int64(statement.get(), 2, after);
+    sqlite3_bind_int64(statement.get(), 3, before);
+
+    size_t banCount = 0;
+    int32_t result;
+    while ((result = sqlite3_step(statement.get())) == SQLITE_ROW) {
+        const auto ip = columnText(statement.get(), 0);
+        if (ip.empty()) { continue; }
+
+        callback(jail, ip, sqlite3_column_int64(statement.get(), 1), parseFailures(columnText(statement.get(), 2)));
+        banCount++;
+    }
+    if (result != SQLITE_DONE) { throw runtime_error(string("Failed to read bans from fail2ban's database: ") + sqlite3_errmsg(m_database)); }
+
+    return banCount;
+}
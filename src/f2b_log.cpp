@@ -0,0 +1,49 @@
+/**
+ * @file f2b_log.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the fail2ban log line parser.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include "f2b_log.hpp"
+
+static constexpr string_view BAN_KEYWORD = "] Ban "; //!< Precedes the IP of a ban
+static constexpr string_view RESTORE_BAN_KEYWORD = "] Restore Ban "; //!< Precedes the IP of a ban restored after a restart
+static constexpr string_view UNBAN_KEYWORD = "] Unban "; //!< Precedes the IP of an unban
+
+bool parseLogLine(string_view line, LogEvent& out) {
+    auto keywordPos = line.find(BAN_KEYWORD);
+    auto keyword = BAN_KEYWORD;
+    out.action = LogEvent::Action::Ban;
+
+    if (keywordPos == string_view::npos) {
+        keywordPos = line.find(RESTORE_BAN_KEYWORD);
+        keyword = RESTORE_BAN_KEYWORD;
+    }
+
+    if (keywordPos == string_view::npos) {
+        keywordPos = line.find(UNBAN_KEYWORD);
+        keyword = UNBAN_KEYWORD;
+        out.action = LogEvent::Action::Unban;
+    }
+
+    if (keywordPos == string_view::npos) { return false; }
+
+    const auto jailStart = line.rfind('[', keywordPos);
+    if (jailStart == string_view::npos) { return false; }
+    out.jail = line.substr(jailStart + 1, keywordPos - jailStart - 1);
+
+    auto ip = line.substr(keywordPos + keyword.size());
+    while (!ip.empty() && ip.front() == ' ') { ip.remove_prefix(1); }
+    ip = ip.substr(0, ip.find_first_of(" \t\r"));
+    if (ip.empty() || out.jail.empty()) { return false; }
+    out.ip = ip;
+
+    // "YYYY-MM-DD HH:MM:SS,mmm"
+    out.timestamp = line.size() >= 23 && line[4] == '-' && line[10] == ' ' ? line.substr(0, 23) : string_view{};
+
+    return true;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file f2b_parser.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the incremental fail2ban output tokenizer.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <utility>
+
+#include "f2b_parser.hpp"
+
+Fail2BanParser::Fail2BanParser(BanCallback callback, string_view defaultJail):
+m_callback(std::move(callback)), m_defaultJail(defaultJail) {
+    m_carry.reserve(64);
+}
+
+void Fail2BanParser::feed(string_view chunk) {
+    size_t tokenStart = 0;
+
+    for (size_t i = 0; i < chunk.size(); i++) {
+        const char c = chunk[i];
+
+        if (m_inString) {
+            if (m_escaped) {
+                m_escaped = false;
+                continue;
+            } else if (c == '\\') {
+                m_escaped = true;
+                continue;
+            } else if (c != m_quote) {
+                continue;
+            }
+
+            m_inString = false;
+            if (m_carry.empty()) {
+                if (i - tokenStart > MAX_TOKEN_LENGTH) { fail("String token too long", i); }
+                onToken(chunk.substr(tokenStart, i - tokenStart));
+            } else {
+                if (m_carry.size() + (i - tokenStart) > MAX_TOKEN_LENGTH) { fail("String token too long", i); }
+                m_carry.append(chunk.data() + tokenStart, i - tokenStart);
+                onToken(string_view(m_carry).substr(1)); // skip the marker
+                keepAlive(m_carry);
+                m_carry.clear();
+            }
+            continue;
+        }
+
+        switch (c) {
+            case '\'':
+            case '"':
+                if (m_depth == 0) { fail("Unexpected string outside of a list", i); }
+                m_inString = true;
+                m_quote = c;
+                tokenStart = i + 1;
+                break;
+            case '[':
+            case '(':
+                openContainer(false, i);
+                break;
+            case '{':
+                openContainer(true, i);
+                break;
+            case ']':
+            case ')':
+            case '}':
+                closeContainer(c, i);
+                break;
+            case ':':
+                if (m_depth > 0 && m_stack[m_depth - 1].isDict) { m_stack[m_depth - 1].expectKey = false; }
+                break;
+            case ',':
+                if (m_depth > 0 && m_stack[m_depth - 1].isDict) { m_stack[m_depth - 1].expectKey = true; }
+                break;
+            default:
+                // whitespace and non-string scalars (numbers, None, True, ...) carry no information for us
+                break;
+        }
+    }
+
+    if (m_inString) {
+        // the current token continues in the next chunk.
+        // A marker character is prepended so that an empty partial token still counts as "carrying"
+        if (m_carry.empty()) { m_carry.push_back('\0'); }
+        if (m_carry.size() + (chunk.size() - tokenStart) > MAX_TOKEN_LENGTH) { fail("String token too long", chunk.size()); }
+        m_carry.append(chunk.data() + tokenStart, chunk.size() - tokenStart);
+    }
+
+    keepAlive(chunk);
+    m_offset += chunk.size();
+}
+
+void Fail2BanParser::finish() {
+    if (m_inString) {
+        fail("Unterminated string", 0);
+    } else if (m_depth > 0) {
+        fail("Unexpected end of input; unbalanced brackets", 0);
+    } else if (!m_seenContainer) {
+        fail("Input contained no list", 0);
+    }
+}
+
+void Fail2BanParser::onToken(string_view token) {
+    const auto& frame = m_stack[m_depth - 1];
+
+    if (frame.isDict) {
+        if (frame.expectKey) { m_key = token; }
+        return; // string values are of no interest to us
+    }
+
+    m_callback(m_namedJailDepth > 0 ? m_jail : string_view(m_defaultJail), token);
+}
+
+/**
+ * @brief Copies the current key and jail name into their backing storage if they reference the given buffer, which is about to go away.
+ */
+void Fail2BanParser::keepAlive(string_view source) {
+    const auto isWithin = [&](string_view view) {
+        return !view.empty() && view.data() >= source.data() && view.data() < source.data() + source.size();
+    };
+
+    if (isWithin(m_key)) {
+        m_keyStorage.assign(m_key.data(), m_key.size());
+        m_key = m_keyStorage;
+    }
+
+    if (isWithin(m_jail)) {
+        m_jailStorage.assign(m_jail.data(), m_jail.size());
+        m_jail = m_jailStorage;
+    }
+}
+
+void Fail2BanParser::openContainer(bool isDict, size_t chunkOffset) {
+    if (m_depth == MAX_DEPTH) { fail("Maximum nesting depth exceeded", chunkOffset); }
+
+    if (!isDict && m_depth > 0 && m_stack[m_depth - 1].isDict && !m_stack[m_depth - 1].expectKey) {
+        // list is the value of a jail key
+        if (!m_key.empty() && m_key.data() == m_keyStorage.data()) {
+            // the key storage is reused for the next key
+            m_jailStorage = m_keyStorage;
+            m_jail = m_jailStorage;
+        } else {
+            m_jail = m_key;
+        }
+        m_namedJailDepth = m_depth + 1;
+    }
+
+    m_stack[m_depth++] = Frame{ isDict, isDict };
+    m_seenContainer = true;
+}
+
+void Fail2BanParser::closeContainer(char c, size_t chunkOffset) {
+    if (m_depth == 0) { fail("Unbalanced closing bracket", chunkOffset); }
+    if (m_stack[m_depth - 1].isDict != (c == '}')) { fail("Mismatched closing bracket", chunkOffset); }
+
+    if (m_depth == m_namedJailDepth) { m_namedJailDepth = 0; }
+    m_depth--;
+}
+
+void Fail2BanParser::fail(const string& what, size_t chunkOffset) const {
+    throw Fail2BanParseError(what, m_offset + chunkOffset);
+}
@@ -0,0 +1,654 @@
+/**
+ * @file f2b_socket.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the fail2ban control socket client, including the minimal (streaming) pickle codec it needs.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <system_error>
+#include <unordered_map>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "f2b_socket.hpp"
+
+using std::error_code;
+using std::shared_ptr;
+using std::system_error;
+using std::vector;
+
+static constexpr string_view END_MARKER = "<F2B_END_COMMAND>"; //!< Terminates every message in both directions
+static constexpr string_view CLOSE_MARKER = "<F2B_CLOSE_COMMAND>"; //!< Sent (unpickled) before closing the connection
+static constexpr size_t      RECEIVE_CHUNK_SIZE = 64 * 1024; //!< The amount of bytes received per call to recv(2)
+static constexpr size_t      RENDER_CHUNK_SIZE = 64 * 1024; //!< The amount of rendered bytes handed to the callback at once
+
+/**
+ * @brief A decoded Python object; only what fail2ban actually sends is distinguished.
+ */
+struct PickleValue {
+    enum class Type { None, Bool, Int, Float, String, List, Tuple, Dict, Set, Object };
+
+    Type                            type = Type::None;
+    int64_t                         intValue = 0; //!< Bool and Int
+    double                          floatValue = 0; //!< Float
+    string                          text; //!< String (also bytes), or the class name of an Object
+    vector<shared_ptr<PickleValue>> items; //!< Container items; alternating keys and values for Dict. For Object: args, then state
+    uint32_t                        memoIndex = std::numeric_limits<uint32_t>::max(); //!< The memo entry last holding the value, if any
+};
+
+using PickleValuePtr = shared_ptr<PickleValue>;
+
+static PickleValuePtr makeValue(PickleValue::Type type) {
+    auto value = std::make_shared<PickleValue>();
+    value->type = type;
+    return value;
+}
+
+static void sendAll(int32_t fd, string_view data) {
+    while (!data.empty()) {
+        const auto bytesSent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (bytesSent < 0 && errno == EINTR) { continue; }
+        if (bytesSent < 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to send to fail2ban"); }
+        data.remove_prefix(static_cast<size_t>(bytesSent));
+    }
+}
+
+/**
+ * @brief Pickles a list of strings (protocol 2).
+ */
+static string pickleCommand(const vector<string>& command) {
+    string pickled = "\x80\x02]("; // PROTO 2, EMPTY_LIST, MARK
+    for (const auto& argument : command) {
+        const auto length = static_cast<uint32_t>(argument.size());
+        pickled.push_back('X'); // BINUNICODE
+        for (int32_t shift = 0; shift < 32; shift += 8) { pickled.push_back(static_cast<char>((length >> shift) & 0xff)); }
+        pickled.append(argument);
+    }
+    pickled.append("e."); // APPENDS, STOP
+
+    return pickled;
+}
+
+/**
+ * @brief Finds the text which represents an object, e.g. the address of one of fail2ban's IPAddr objects.
+ *
+ * @remarks fail2ban-client prints such objects by their repr, which for the objects in ban lists is the quoted address.
+ * The first string in the object's arguments is used; failing that, the "_raw" entry of its state (either a dict, or
+ * the (dict, slots) pair of classes using __slots__).
+ */
+static const PickleValue* findObjectText(const PickleValue& object) {
+    for (const auto& item : object.items) {
+        if (item->type == PickleValue::Type::String) { return item.get(); }
+        if (item->type == PickleValue::Type::Tuple && !item->items.empty() && item->items.front()->type == PickleValue::Type::String) {
+            return item->items.front().get();
+        }
+    }
+
+    const auto findRaw = [](const PickleValue& state) -> const PickleValue* {
+        for (size_t i = 0; state.type == PickleValue::Type::Dict && i + 1 < state.items.size(); i += 2) {
+            if (state.items[i]->text == "_raw" && state.items[i + 1]->type == PickleValue::Type::String) { return state.items[i + 1].get(); }
+        }
+        return nullptr;
+    };
+
+    for (const auto& item : object.items) {
+        if (const auto* text = findRaw(*item); text != nullptr) { return text; }
+        for (size_t i = 0; item->type == PickleValue::Type::Tuple && i < item->items.size(); i++) {
+            if (const auto* text = findRaw(*item->items[i]); text != nullptr) { return text; }
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Decodes the subset of the pickle format (protocols 0-5, binary opcodes) produced for fail2ban's answers,
+ * incrementally, as the answer arrives.
+ *
+ * If a hook is set, strings and objects appended to lists (and sets) are passed to it instead of being stored, along
+ * with the dict key the list is the value of, so ban lists never exist in memory as a whole. The answer may refer back
+ * to any earlier value, so memoized strings (and objects passed to the hook) are kept as text; other memoized values
+ * are only referenced weakly, which suffices for the answers fail2ban sends.
+ */
+class PickleDecoder {
+    public:
+        /**
+         * @brief Receives the strings (or objects' texts) appended to a list, and the dict key the list belongs to (if any).
+         */
+        using ItemHook = std::function<void(string_view key, string_view text)>;
+
+        explicit PickleDecoder(ItemHook hook = nullptr): m_hook(std::move(hook)) { }
+
+        /**
+         * @brief Decodes as many complete opcodes as the data received so far contains.
+         *
+         * @param data The next chunk of the answer.
+         */
+        void feed(string_view data) {
+            m_buffer.append(data);
+            while (!m_isDone && step()) { }
+
+            m_offset += m_position;
+            m_buffer.erase(0, m_position);
+            m_position = 0;
+        }
+
+        bool isDone() const { return m_isDone; } //!< Whether STOP was decoded
+        string_view rest() const { return m_buffer; } //!< The data received after STOP
+        const PickleValuePtr& result() const { return m_stack.back(); } //!< The decoded value (once done)
+
+    private:
+        static constexpr uint32_t   VALUE_ENTRY = std::numeric_limits<uint32_t>::max(); //!< Marks memo entries held in m_memoValues
+        static constexpr uint32_t   DEAD_ENTRY = VALUE_ENTRY - 1; //!< Marks memo entries whose value is gone
+        static constexpr size_t     MAX_STRING_SIZE = 16 * 1024 * 1024; //!< The largest string accepted
+        static constexpr size_t     MAX_GLOBAL_SIZE = 4096; //!< The longest "module\nname\n" accepted
+
+        /**
+         * @brief A memoized value: a range of m_memoText, or (if length is VALUE_ENTRY) an entry of m_memoValues.
+         */
+        struct MemoEntry {
+            uint64_t offset;
+            uint32_t length;
+        };
+
+        [[noreturn]] void fail(const string& what) const {
+            throw Fail2BanSocketError("Malformed answer from fail2ban at offset " + std::to_string(m_offset + m_position) + ": " + what);
+        }
+
+        /**
+         * @brief Takes the next count bytes, if they were received already.
+         */
+        bool take(size_t count, string_view& out) {
+            if (m_buffer.size() - m_position < count) { return false; }
+            out = string_view(m_buffer).substr(m_position, count);
+            m_position += count;
+            return true;
+        }
+
+        bool readUnsigned(size_t byteCount, uint64_t& out) {
+            string_view bytes;
+            if (!take(byteCount, bytes)) { return false; }
+            out = 0;
+            for (size_t i = byteCount; i > 0; i--) { out = (out << 8) | static_cast<uint8_t>(bytes[i - 1]); }
+            return true;
+        }
+
+        PickleValuePtr pop() {
+            if (m_stack.empty()) { fail("stack underflow"); }
+            auto value = std::move(m_stack.back());
+            m_stack.pop_back();
+            return value;
+        }
+
+        vector<PickleValuePtr> popMark() {
+            if (m_marks.empty() || m_marks.back() > m_stack.size()) { fail("missing mark"); }
+            vector<PickleValuePtr> items(std::make_move_iterator(m_stack.begin() + static_cast<ptrdiff_t>(m_marks.back())), std::make_move_iterator(m_stack.end()));
+            m_stack.resize(m_marks.back());
+            m_marks.pop_back();
+            return items;
+        }
+
+        PickleValue& top() {
+            if (m_stack.empty()) { fail("stack underflow"); }
+            return *m_stack.back();
+        }
+
+        void push(PickleValue::Type type, vector<PickleValuePtr> items = {}) {
+            auto value = makeValue(type);
+            value->items = std::move(items);
+            if (type == PickleValue::Type::List || type == PickleValue::Type::Set) { value->text = dictKeyAbove(m_stack.size()); }
+            m_stack.push_back(std::move(value));
+        }
+
+        void pushInt(int64_t number) {
+            auto value = makeValue(PickleValue::Type::Int);
+            value->intValue = number;
+            m_stack.push_back(std::move(value));
+        }
+
+        void pushString(string_view text) {
+            auto value = makeValue(PickleValue::Type::String);
+            value->text = string(text);
+            m_stack.push_back(std::move(value));
+        }
+
+        void pushObject(const PickleValuePtr& callable, const PickleValuePtr& arguments) {
+            auto value = makeValue(PickleValue::Type::Object);
+            value->text = callable->text;
+            value->items = arguments->items;
+            m_stack.push_back(std::move(value));
+        }
+
+        /**
+         * @brief Gets the key of the dict item whose value is about to be pushed at the given stack index (a key is
+         * pushed right before its value, either directly above the dict or as part of a marked batch of items).
+         */
+        string dictKeyAbove(size_t index) const {
+            if (index < 2 || m_stack[index - 1]->type != PickleValue::Type::String) { return string(); }
+
+            const auto markStart = m_marks.empty() ? 0 : m_marks.back();
+            const bool isBatchedKey = markStart >= 1 && markStart <= index - 1 && m_stack[markStart - 1]->type == PickleValue::Type::Dict && (index - 1 - markStart) % 2 == 0;
+            const bool isSingleKey = markStart <= index - 2 && m_stack[index - 2]->type == PickleValue::Type::Dict;
+
+            return isBatchedKey || isSingleKey ? m_stack[index - 1]->text : string();
+        }
+
+        /**
+         * @brief Adds items to a container; strings and objects added to lists are passed to the hook instead, if set.
+         */
+        void addItems(PickleValue& container, vector<PickleValuePtr> items) {
+            if (m_hook == nullptr || (container.type != PickleValue::Type::List && container.type != PickleValue::Type::Set)) {
+                container.items.insert(container.items.end(), std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+                return;
+            }
+
+            for (auto& item : items) {
+                const auto* text = item->type == PickleValue::Type::String ? item.get() : item->type == PickleValue::Type::Object ? findObjectText(*item) : nullptr;
+                if (text == nullptr) {
+                    container.items.push_back(std::move(item));
+                    continue;
+                }
+
+                m_hook(container.text, text->text);
+                // the object itself is discarded, but the answer may still refer to it
+                if (item->type == PickleValue::Type::Object && item->memoIndex < m_memo.size() && m_memo[item->memoIndex].length == VALUE_ENTRY) {
+                    m_memo[item->memoIndex] = { m_memoText.size(), static_cast<uint32_t>(text->text.size()) };
+                    m_memoText.append(text->text);
+                    m_memoValues.erase(item->memoIndex);
+                }
+            }
+        }
+
+        void memoize(uint64_t index) {
+            if (index > m_memo.size()) { fail("memo index out of sequence"); }
+            if (m_stack.empty()) { fail("stack underflow"); }
+            if (index == m_memo.size()) { m_memo.push_back({ 0, DEAD_ENTRY }); }
+
+            const auto& value = m_stack.back();
+            if (m_memo[index].length == VALUE_ENTRY) { m_memoValues.erase(index); }
+            if (value->type == PickleValue::Type::String) {
+                // strings are immutable, so their text is all that needs to be remembered
+                m_memo[index] = { m_memoText.size(), static_cast<uint32_t>(value->text.size()) };
+                m_memoText.append(value->text);
+                return;
+            }
+
+            m_memo[index] = { 0, VALUE_ENTRY };
+            value->memoIndex = static_cast<uint32_t>(index);
+            m_memoValues[index] = value;
+
+            // drop the references to values which are gone, so the table only grows with the values still alive
+            if (m_memoValues.size() >= 2 * m_liveMemoValues) {
+                for (auto iter = m_memoValues.begin(); iter != m_memoValues.end();) {
+                    if (iter->second.expired()) {
+                        m_memo[iter->first] = { 0, DEAD_ENTRY };
+                        iter = m_memoValues.erase(iter);
+                    } else {
+                        ++iter;
+                    }
+                }
+                m_liveMemoValues = std::max<size_t>(m_memoValues.size(), 64);
+            }
+        }
+
+        void recall(uint64_t index) {
+            if (index >= m_memo.size() || m_memo[index].length == DEAD_ENTRY) { fail("unknown memo entry"); }
+            if (m_memo[index].length != VALUE_ENTRY) {
+                pushString(string_view(m_memoText).substr(m_memo[index].offset, m_memo[index].length));
+                return;
+            }
+
+            auto value = m_memoValues[index].lock();
+            if (value == nullptr) { fail("memo entry no longer available"); }
+            m_stack.push_back(std::move(value));
+        }
+
+        /**
+         * @brief Decodes the next opcode.
+         *
+         * @return false If the opcode (or its argument) wasn't received completely yet; nothing was consumed.
+         */
+        bool step() {
+            const auto start = m_position;
+            const auto needMore = [&]() {
+                m_position = start;
+                return false;
+            };
+
+            string_view bytes;
+            uint64_t number = 0;
+            if (!take(1, bytes)) { return false; }
+
+            const auto opcode = static_cast<uint8_t>(bytes[0]);
+            const auto takeString = [&](size_t lengthSize) {
+                if (!readUnsigned(lengthSize, number)) { return false; }
+                if (number > MAX_STRING_SIZE) { fail("string too long"); }
+                return take(static_cast<size_t>(number), bytes);
+            };
+
+            switch (opcode) {
+                case 0x80: if (!take(1, bytes)) { return needMore(); } break; // PROTO
+                case 0x95: if (!take(8, bytes)) { return needMore(); } break; // FRAME
+                case '.': // STOP
+                    if (m_stack.size() != 1) { fail("unbalanced stack"); }
+                    m_isDone = true;
+                    break;
+                case '(': m_marks.push_back(m_stack.size()); break; // MARK
+                case '0': pop(); break; // POP
+                case '1': popMark(); break; // POP_MARK
+                case '2': { // DUP
+                    auto value = pop();
+                    m_stack.push_back(value);
+                    m_stack.push_back(std::move(value));
+                    break;
+                }
+                case 'N': push(PickleValue::Type::None); break;
+                case 0x88: // NEWTRUE
+                case 0x89: // NEWFALSE
+                    pushInt(opcode == 0x88);
+                    m_stack.back()->type = PickleValue::Type::Bool;
+                    break;
+                case 'K': if (!readUnsigned(1, number)) { return needMore(); } pushInt(static_cast<int64_t>(number)); break; // BININT1
+                case 'M': if (!readUnsigned(2, number)) { return needMore(); } pushInt(static_cast<int64_t>(number)); break; // BININT2
+                case 'J': if (!readUnsigned(4, number)) { return needMore(); } pushInt(static_cast<int32_t>(number)); break; // BININT
+                case 0x8a: { // LONG1
+                    if (!readUnsigned(1, number)) { return needMore(); }
+                    const auto byteCount = static_cast<size_t>(number);
+                    if (byteCount > 8) { fail("integer too large"); }
+                    if (!readUnsigned(byteCount, number)) { return needMore(); }
+                    if (byteCount > 0 && byteCount < 8 && (number >> (byteCount * 8 - 1)) != 0) { number |= ~0ull << (byteCount * 8); }
+                    pushInt(static_cast<int64_t>(number));
+                    break;
+                }
+                case 'G': { // BINFLOAT (big-endian)
+                    if (!take(8, bytes)) { return needMore(); }
+                    uint64_t bits = 0;
+                    for (const auto byte : bytes) { bits = (bits << 8) | static_cast<uint8_t>(byte); }
+                    push(PickleValue::Type::Float);
+                    std::memcpy(&m_stack.back()->floatValue, &bits, sizeof(bits));
+                    break;
+                }
+                case 0x8c: case 'U': case 'C': if (!takeString(1)) { return needMore(); } pushString(bytes); break; // SHORT_BINUNICODE, SHORT_BINSTRING, SHORT_BINBYTES
+                case 'X': case 'T': case 'B': if (!takeString(4)) { return needMore(); } pushString(bytes); break; // BINUNICODE, BINSTRING, BINBYTES
+                case 0x8d: case 0x8e: if (!takeString(8)) { return needMore(); } pushString(bytes); break; // BINUNICODE8, BINBYTES8
+                case ']': push(PickleValue::Type::List); break; // EMPTY_LIST
+                case ')': push(PickleValue::Type::Tuple); break; // EMPTY_TUPLE
+                case '}': push(PickleValue::Type::Dict); break; // EMPTY_DICT
+                case 0x8f: push(PickleValue::Type::Set); break; // EMPTY_SET
+                case 'l': { // LIST
+                    auto items = popMark();
+                    push(PickleValue::Type::List);
+                    addItems(top(), std::move(items));
+                    break;
+                }
+                case 't': push(PickleValue::Type::Tuple, popMark()); break; // TUPLE
+                case 0x85: case 0x86: case 0x87: { // TUPLE1, TUPLE2, TUPLE3
+                    const size_t itemCount = opcode - 0x84u;
+                    if (m_stack.size() < itemCount) { fail("stack underflow"); }
+                    vector<PickleValuePtr> items(m_stack.end() - static_cast<ptrdiff_t>(itemCount), m_stack.end());
+                    m_stack.resize(m_stack.size() - itemCount);
+                    push(PickleValue::Type::Tuple, std::move(items));
+                    break;
+                }
+                case 'a': { // APPEND
+                    auto item = pop();
+                    vector<PickleValuePtr> items;
+                    items.push_back(std::move(item));
+                    addItems(top(), std::move(items));
+                    break;
+                }
+                case 'e': case 0x90: { // APPENDS, ADDITEMS
+                    auto items = popMark();
+                    addItems(top(), std::move(items));
+                    break;
+                }
+                case 'u': { // SETITEMS
+                    auto items = popMark();
+                    auto& container = top().items;
+                    container.insert(container.end(), std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+                    break;
+                }
+                case 's': { // SETITEM
+                    auto value = pop();
+                    auto key = pop();
+                    top().items.push_back(std::move(key));
+                    top().items.push_back(std::move(value));
+                    break;
+                }
+                case 0x91: { // FROZENSET
+                    auto items = popMark();
+                    push(PickleValue::Type::Set);
+                    addItems(top(), std::move(items));
+                    break;
+                }
+                case 'c': { // GLOBAL "module\nname\n"
+                    const auto moduleEnd = m_buffer.find('\n', m_position);
+                    const auto nameEnd = moduleEnd == string::npos ? moduleEnd : m_buffer.find('\n', moduleEnd + 1);
+                    if (nameEnd == string::npos) {
+                        if (m_buffer.size() - m_position > MAX_GLOBAL_SIZE) { fail("unterminated global"); }
+                        return needMore();
+                    }
+                    pushString(string_view(m_buffer).substr(moduleEnd + 1, nameEnd - moduleEnd - 1));
+                    m_position = nameEnd + 1;
+                    break;
+                }
+                case 0x93: { // STACK_GLOBAL
+                    auto name = pop();
+                    pop();
+                    m_stack.push_back(std::move(name));
+                    break;
+                }
+                case 'R': case 0x81: { // REDUCE, NEWOBJ
+                    auto arguments = pop();
+                    auto callable = pop();
+                    pushObject(callable, arguments);
+                    break;
+                }
+                case 0x92: { // NEWOBJ_EX
+                    pop();
+                    auto arguments = pop();
+                    auto callable = pop();
+                    pushObject(callable, arguments);
+                    break;
+                }
+                case 'b': { // BUILD
+                    auto state = pop();
+                    top().items.push_back(std::move(state));
+                    break;
+                }
+                case 0x94: memoize(m_memo.size()); break; // MEMOIZE
+                case 'q': if (!readUnsigned(1, number)) { return needMore(); } memoize(number); break; // BINPUT
+                case 'r': if (!readUnsigned(4, number)) { return needMore(); } memoize(number); break; // LONG_BINPUT
+                case 'h': if (!readUnsigned(1, number)) { return needMore(); } recall(number); break; // BINGET
+                case 'j': if (!readUnsigned(4, number)) { return needMore(); } recall(number); break; // LONG_BINGET
+                default:
+                    m_position = start;
+                    fail("unsupported opcode " + std::to_string(opcode));
+            }
+
+            return true;
+        }
+
+    private:
+        ItemHook                                            m_hook; //!< Receives the items of lists (if set)
+        string                                              m_buffer; //!< The data received, but not decoded yet
+        size_t                                              m_position = 0; //!< The position in m_buffer
+        uint64_t                                            m_offset = 0; //!< The offset of m_buffer in the answer
+        bool                                                m_isDone = false; //!< Whether STOP was decoded
+        vector<PickleValuePtr>                              m_stack; //!< The values being built
+        vector<size_t>                                      m_marks; //!< The stack sizes at each MARK
+        vector<MemoEntry>                                   m_memo; //!< The memo, by index
+        string                                              m_memoText; //!< The texts of memoized strings (and objects)
+        std::unordered_map<uint64_t, std::weak_ptr<PickleValue>>
+                                                            m_memoValues; //!< The other memoized values, by index
+        size_t                                              m_liveMemoValues = 64; //!< The amount of memoized values alive after the last sweep
+};
+
+/**
+ * @brief Renders a value as Python would print it, passing the output to the callback in chunks.
+ */
+class PythonRenderer {
+    public:
+        explicit PythonRenderer(Fail2BanSocket::ChunkCallback callback): m_callback(std::move(callback)) { m_buffer.reserve(RENDER_CHUNK_SIZE * 2); }
+
+        void render(const PickleValue& value) {
+            switch (value.type) {
+                case PickleValue::Type::None: m_buffer.append("None"); break;
+                case PickleValue::Type::Bool: m_buffer.append(value.intValue != 0 ? "True" : "False"); break;
+                case PickleValue::Type::Int: m_buffer.append(std::to_string(value.intValue)); break;
+                case PickleValue::Type::Float: m_buffer.append(std::to_string(value.floatValue)); break;
+                case PickleValue::Type::String: renderString(value.text); break;
+                case PickleValue::Type::List: renderItems(value, "[", "]", ", "); break;
+                case PickleValue::Type::Tuple: renderItems(value, "(", value.items.size() == 1 ? ",)" : ")", ", "); break;
+                case PickleValue::Type::Set: renderItems(value, "{", "}", ", "); break;
+                case PickleValue::Type::Dict: {
+                    m_buffer.push_back('{');
+                    for (size_t i = 0; i + 1 < value.items.size(); i += 2) {
+                        if (i > 0) { m_buffer.append(", "); }
+                        render(*value.items[i]);
+                        m_buffer.append(": ");
+                        render(*value.items[i + 1]);
+                    }
+                    m_buffer.push_back('}');
+                    break;
+                }
+                case PickleValue::Type::Object: {
+                    const auto* text = findObjectText(value);
+                    if (text != nullptr) {
+                        renderString(text->text);
+                    } else {
+                        renderString("<" + value.text + ">");
+                    }
+                    break;
+                }
+            }
+
+            if (m_buffer.size() >= RENDER_CHUNK_SIZE) { flush(); }
+        }
+
+        void flush() {
+            if (!m_buffer.empty()) { m_callback(m_buffer); }
+            m_buffer.clear();
+        }
+
+    private:
+        void renderItems(const PickleValue& value, string_view open, string_view close, string_view separator) {
+            m_buffer.append(open);
+            for (size_t i = 0; i < value.items.size(); i++) {
+                if (i > 0) { m_buffer.append(separator); }
+                render(*value.items[i]);
+            }
+            m_buffer.append(close);
+        }
+
+        void renderString(string_view text) {
+            // like repr(), prefer single quotes unless the text contains some and no double quotes
+            const char quote = text.find('\'') != string_view::npos && text.find('"') == string_view::npos ? '"' : '\'';
+            m_buffer.push_back(quote);
+            for (const auto c : text) {
+                if (c == quote || c == '\\') { m_buffer.push_back('\\'); }
+                m_buffer.push_back(c);
+            }
+            m_buffer.push_back(quote);
+        }
+
+    private:
+        Fail2BanSocket::ChunkCallback m_callback;
+        string m_buffer;
+};
+
+Fail2BanSocket::Fail2BanSocket(const string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) { throw system_error(error_code(ENAMETOOLONG, std::generic_category()), "Failed to connect to " + path); }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to create socket"); }
+
+    const timeval timeout{ TIMEOUT_SECONDS, 0 };
+    setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(m_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    if (connect(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        const auto error = errno;
+        close(m_fd);
+        m_fd = -1;
+        throw system_error(error_code(error, std::generic_category()), "Failed to connect to " + path);
+    }
+}
+
+Fail2BanSocket::~Fail2BanSocket() {
+    if (m_fd < 0) { return; }
+
+    try {
+        sendAll(m_fd, string(CLOSE_MARKER) + string(END_MARKER));
+    } catch (const system_error&) { }
+    close(m_fd);
+}
+
+/**
+ * @brief Sends a command and decodes the answer as it arrives, until its end marker.
+ *
+ * @return The (return code, result) pair; the items passed to the hook are missing from the result.
+ */
+static PickleValuePtr exchange(int32_t fd, const vector<string>& command, PickleDecoder::ItemHook hook, uint64_t& bytesReceived) {
+    sendAll(fd, pickleCommand(command) + string(END_MARKER));
+
+    PickleDecoder decoder(std::move(hook));
+    vector<char> chunk(RECEIVE_CHUNK_SIZE);
+    // after STOP, only the end marker may follow
+    while (!decoder.isDone() || decoder.rest().size() < END_MARKER.size()) {
+        const auto chunkSize = recv(fd, chunk.data(), chunk.size(), 0);
+        if (chunkSize < 0 && errno == EINTR) { continue; }
+        if (chunkSize < 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to receive from fail2ban"); }
+        if (chunkSize == 0) { throw Fail2BanSocketError("fail2ban closed the connection before answering"); }
+
+        bytesReceived += static_cast<uint64_t>(chunkSize);
+        decoder.feed(string_view(chunk.data(), static_cast<size_t>(chunkSize)));
+    }
+
+    if (decoder.rest() != END_MARKER) { throw Fail2BanSocketError("Unexpected data after fail2ban's answer"); }
+
+    const auto& result = decoder.result();
+    if (result->type != PickleValue::Type::Tuple && result->type != PickleValue::Type::List) { throw Fail2BanSocketError("Unexpected answer from fail2ban"); }
+    if (result->items.size() != 2 || result->items[0]->type != PickleValue::Type::Int) { throw Fail2BanSocketError("Unexpected answer from fail2ban"); }
+
+    if (result->items[0]->intValue != 0) {
+        string message;
+        PythonRenderer errorRenderer([&](string_view text) { message.append(text); });
+        errorRenderer.render(*result->items[1]);
+        errorRenderer.flush();
+        throw Fail2BanSocketError("fail2ban reported an error: " + message);
+    }
+
+    return result;
+}
+
+void Fail2BanSocket::send(const vector<string>& command, const ChunkCallback& callback) {
+    const auto result = exchange(m_fd, command, nullptr, m_bytesReceived);
+
+    PythonRenderer renderer(callback);
+    renderer.render(*result->items[1]);
+    renderer.flush();
+}
+
+void Fail2BanSocket::queryBans(const vector<string>& command, string_view defaultJail, const BanCallback& callback) {
+    const auto onItem = [&](string_view jail, string_view address) { callback(jail.empty() ? defaultJail : jail, address); };
+    const auto result = exchange(m_fd, command, onItem, m_bytesReceived);
+
+    const auto type = result->items[1]->type;
+    if (type != PickleValue::Type::List && type != PickleValue::Type::Tuple && type != PickleValue::Type::Set) {
+        throw Fail2BanSocketError("Unexpected answer from fail2ban: not a ban list");
+    }
+}
@@ -0,0 +1,280 @@
+/**
+ * @file host_aggregator.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the aggregator merging the ban lists of many hosts.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <queue>
+
+#include "compression.hpp"
+#include "f2b_parser.hpp"
+#include "host_aggregator.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+namespace fs = std::filesystem;
+
+using std::vector;
+
+static constexpr uint32_t NEW_JAIL_SET = 0x80000000u; //!< Marks a jail set created by a partition (the index into its new sets)
+
+/**
+ * @brief A host's export, parsed.
+ */
+struct HostAggregator::Host {
+    vector<string>  jails; //!< The host's jails, by its own ID
+    vector<HostBan> bans; //!< The host's bans, sorted by address (each IP once per jail)
+    uint64_t        invalidCount = 0; //!< The amount of invalid IPs skipped
+    string          error; //!< Why the export couldn't be parsed completely (empty if it could)
+};
+
+HostAggregator::HostAggregator(string_view defaultJail): m_defaultJail(defaultJail) {}
+
+vector<string> HostAggregator::expandInputs(const vector<string>& paths) {
+    vector<string> files;
+    for (const auto& path : paths) {
+        if (!fs::is_directory(path)) {
+            files.push_back(path);
+            continue;
+        }
+
+        vector<string> directoryFiles;
+        for (const auto& directoryEntry : fs::directory_iterator(path)) {
+            if (directoryEntry.is_regular_file()) { directoryFiles.push_back(directoryEntry.path().string()); }
+        }
+        std::sort(directoryFiles.begin(), directoryFiles.end());
+        files.insert(files.end(), directoryFiles.begin(), directoryFiles.end());
+    }
+
+    return files;
+}
+
+void HostAggregator::aggregate(const vector<string>& files, ThreadPool& threadPool, const ErrorCallback& onError) {
+    const auto batchSize = std::max(MIN_BATCH_SIZE, threadPool.threadCount());
+
+    for (size_t first = 0; first < files.size(); first += batchSize) {
+        vector<Host> hosts(std::min(batchSize, files.size() - first));
+        vector<std::future<void>> results;
+        results.reserve(hosts.size());
+        for (size_t i = 0; i < hosts.size(); i++) {
+            results.push_back(threadPool.submit([this, &files, &hosts, first, i]() { parseHost(files[first + i], hosts[i]); }));
+        }
+        for (auto& result : results) { result.get(); }
+
+        for (size_t i = 0; i < hosts.size(); i++) {
+            m_invalidCount += hosts[i].invalidCount;
+            if (!hosts[i].error.empty()) { onError(files[first + i], hosts[i].error); }
+        }
+
+        mergeBatch(hosts, threadPool);
+    }
+}
+
+/**
+ * @brief Parses a host's export (on a worker) into its sorted list of bans.
+ */
+void HostAggregator::parseHost(const string& path, Host& host) const {
+    uint32_t lastJailId = 0;
+    Fail2BanParser parser([&](string_view jail, string_view ip) {
+        IpAddress address;
+        if (!IpAddress::parse(ip, address)) {
+            host.invalidCount++;
+            return;
+        }
+
+        // IPs arrive jail by jail, and a host only has a handful of jails
+        if (host.jails.empty() || host.jails[lastJailId] != jail) {
+            const auto iter = std::find(host.jails.begin(), host.jails.end(), jail);
+            lastJailId = static_cast<uint32_t>(iter - host.jails.begin());
+            if (iter == host.jails.end()) { host.jails.emplace_back(jail); }
+        }
+
+        host.bans.push_back({ address, lastJailId });
+    }, m_defaultJail);
+
+    try {
+        const MappedFile file(path);
+        decompress(file.view(), [&](string_view chunk) { parser.feed(chunk); });
+        parser.finish();
+    } catch (const std::exception& ex) {
+        host.error = ex.what();
+    }
+
+    const auto isLess = [](const HostBan& a, const HostBan& b) { return a.address < b.address || (a.address == b.address && a.jailId < b.jailId); };
+    const auto isEqual = [](const HostBan& a, const HostBan& b) { return a.address == b.address && a.jailId == b.jailId; };
+    std::sort(host.bans.begin(), host.bans.end(), isLess);
+    host.bans.erase(std::unique(host.bans.begin(), host.bans.end(), isEqual), host.bans.end());
+}
+
+/**
+ * @brief Merges a batch of parsed hosts into the aggregated IPs, splitting the work into partitions by address.
+ */
+void HostAggregator::mergeBatch(vector<Host>& hosts, ThreadPool& threadPool) {
+    // switch to our jail IDs; every jail's single-jail set is interned up front, as partitions can't intern sets
+    size_t totalSize = m_entries.size();
+    for (auto& host : hosts) {
+        vector<uint32_t> jailIds;
+        for (const auto& jail : host.jails) { jailIds.push_back(globalJailId(jail)); }
+        for (auto& ban : host.bans) { ban.jailId = jailIds[ban.jailId]; }
+        totalSize += host.bans.size();
+    }
+
+    // split the address space at quantiles of the largest list
+    const auto partitionCount = std::clamp<size_t>(totalSize / MIN_PARTITION_SIZE, 1, threadPool.threadCount());
+    vector<IpAddress> splitters;
+    const auto* largestHost = hosts.empty() ? nullptr : &*std::max_element(hosts.begin(), hosts.end(), [](const auto& a, const auto& b) { return a.bans.size() < b.bans.size(); });
+    const bool splitAtEntries = largestHost == nullptr || m_entries.size() >= largestHost->bans.size();
+    const auto largestSize = splitAtEntries ? m_entries.size() : largestHost->bans.size();
+    for (size_t i = 1; i < partitionCount; i++) {
+        const auto index = i * largestSize / partitionCount;
+        const auto& address = splitAtEntries ? m_entries[index].address : largestHost->bans[index].address;
+        if (splitters.empty() || splitters.back() < address) { splitters.push_back(address); }
+    }
+
+    // each partition gets the [previous splitter, splitter) range of every list
+    const auto entryLess = [](const Entry& entry, const IpAddress& address) { return entry.address < address; };
+    const auto banLess = [](const HostBan& ban, const IpAddress& address) { return ban.address < address; };
+    vector<vector<Entry>> partitionEntries(splitters.size() + 1);
+    vector<vector<vector<uint32_t>>> partitionJailSets(splitters.size() + 1);
+    vector<std::future<void>> results;
+    for (size_t partition = 0; partition <= splitters.size(); partition++) {
+        const auto rangeOf = [&](const auto* begin, const auto* end, const auto& less) {
+            const auto* rangeBegin = partition == 0 ? begin : std::lower_bound(begin, end, splitters[partition - 1], less);
+            const auto* rangeEnd = partition == splitters.size() ? end : std::lower_bound(begin, end, splitters[partition], less);
+            return std::make_pair(rangeBegin, rangeEnd);
+        };
+
+        const auto entryRange = rangeOf(m_entries.data(), m_entries.data() + m_entries.size(), entryLess);
+        vector<std::pair<const HostBan*, const HostBan*>> hostRanges;
+        for (const auto& host : hosts) { hostRanges.push_back(rangeOf(host.bans.data(), host.bans.data() + host.bans.size(), banLess)); }
+
+        results.push_back(threadPool.submit([this, entryRange, hostRanges = std::move(hostRanges), &partitionEntries, &partitionJailSets, partition]() {
+            mergePartition(entryRange.first, entryRange.second, hostRanges, partitionEntries[partition], partitionJailSets[partition]);
+        }));
+    }
+    for (auto& result : results) { result.get(); }
+
+    // intern the partitions' new jail sets and stitch the partitions together
+    vector<Entry> merged;
+    size_t mergedSize = 0;
+    for (const auto& entries : partitionEntries) { mergedSize += entries.size(); }
+    merged.reserve(mergedSize);
+
+    for (size_t partition = 0; partition < partitionEntries.size(); partition++) {
+        vector<uint32_t> jailSetIds;
+        for (auto& jails : partitionJailSets[partition]) { jailSetIds.push_back(internJailSet(jails)); }
+
+        for (auto& entry : partitionEntries[partition]) {
+            if ((entry.jailSet & NEW_JAIL_SET) != 0) { entry.jailSet = jailSetIds[entry.jailSet & ~NEW_JAIL_SET]; }
+        }
+        merged.insert(merged.end(), partitionEntries[partition].begin(), partitionEntries[partition].end());
+        vector<Entry>().swap(partitionEntries[partition]);
+    }
+
+    m_entries.swap(merged);
+}
+
+/**
+ * @brief k-way merges a partition of the aggregated IPs and of each host's bans (runs on the thread pool).
+ *
+ * @remarks Only reads the interned jail sets. Sets which don't exist yet are collected in newJailSets, and entries refer
+ * to them by their index, marked with NEW_JAIL_SET.
+ */
+void HostAggregator::mergePartition(const Entry* entriesBegin, const Entry* entriesEnd, const vector<std::pair<const HostBan*, const HostBan*>>& hostRanges,
+                                    vector<Entry>& out, vector<vector<uint32_t>>& newJailSets) const {
+    std::map<vector<uint32_t>, uint32_t> newJailSetIds;
+    const auto findJailSet = [&](vector<uint32_t>& jails) {
+        std::sort(jails.begin(), jails.end());
+        jails.erase(std::unique(jails.begin(), jails.end()), jails.end());
+        if (jails.size() == 1) { return m_singleJailSets[jails.front()]; }
+
+        if (const auto iter = m_jailSetIds.find(jails); iter != m_jailSetIds.end()) { return iter->second; }
+        const auto [iter, isNew] = newJailSetIds.try_emplace(jails, static_cast<uint32_t>(newJailSets.size()) | NEW_JAIL_SET);
+        if (isNew) { newJailSets.push_back(jails); }
+
+        return iter->second;
+    };
+
+    // the next IP of each host's list; the aggregated IPs are merged in linearly, as most of them aren't in the batch
+    using head_t = std::pair<IpAddress, size_t>;
+    std::priority_queue<head_t, vector<head_t>, std::greater<>> heads;
+    vector<const HostBan*> cursors;
+    for (size_t i = 0; i < hostRanges.size(); i++) {
+        cursors.push_back(hostRanges[i].first);
+        if (hostRanges[i].first != hostRanges[i].second) { heads.emplace(hostRanges[i].first->address, i); }
+    }
+
+    out.reserve(static_cast<size_t>(entriesEnd - entriesBegin));
+    const auto* entry = entriesBegin;
+    vector<uint32_t> jails;
+    while (!heads.empty()) {
+        const auto address = heads.top().first;
+        for (; entry != entriesEnd && entry->address < address; entry++) { out.push_back(*entry); }
+
+        const Entry* aggregated = entry != entriesEnd && entry->address == address ? entry++ : nullptr;
+        uint32_t hostCount = aggregated != nullptr ? aggregated->hostCount : 0;
+        jails.clear();
+
+        while (!heads.empty() && heads.top().first == address) {
+            const auto host = heads.top().second;
+            heads.pop();
+
+            auto& cursor = cursors[host];
+            const auto* end = hostRanges[host].second;
+            hostCount++;
+            for (; cursor != end && cursor->address == address; cursor++) { jails.push_back(cursor->jailId); }
+            if (cursor != end) { heads.emplace(cursor->address, host); }
+        }
+
+        uint32_t jailSet;
+        if (aggregated == nullptr) {
+            jailSet = findJailSet(jails);
+        } else {
+            // most IPs seen again are seen in jails they're already known to be banned in
+            const auto& knownJails = m_jailSets[aggregated->jailSet];
+            const bool isKnown = std::all_of(jails.begin(), jails.end(), [&](uint32_t jailId) { return std::binary_search(knownJails.begin(), knownJails.end(), jailId); });
+            if (isKnown) {
+                jailSet = aggregated->jailSet;
+            } else {
+                jails.insert(jails.end(), knownJails.begin(), knownJails.end());
+                jailSet = findJailSet(jails);
+            }
+        }
+
+        out.push_back({ address, jailSet, hostCount });
+    }
+
+    out.insert(out.end(), entry, entriesEnd);
+}
+
+/**
+ * @brief Gets the ID of a (sorted) jail set, interning it if necessary.
+ */
+uint32_t HostAggregator::internJailSet(vector<uint32_t>& jails) {
+    const auto [iter, isNew] = m_jailSetIds.try_emplace(jails, static_cast<uint32_t>(m_jailSets.size()));
+    if (isNew) { m_jailSets.push_back(std::move(jails)); }
+
+    return iter->second;
+}
+
+/**
+ * @brief Gets our ID of a jail, assigning the next one (and interning its single-jail set) if the jail is new.
+ */
+uint32_t HostAggregator::globalJailId(const string& jail) {
+    const auto [iter, isNew] = m_jailIds.try_emplace(jail, static_cast<uint32_t>(m_jailNames.size()));
+    if (isNew) {
+        m_jailNames.push_back(jail);
+        vector<uint32_t> jails{ iter->second };
+        m_singleJailSets.push_back(internJailSet(jails));
+    }
+
+    return iter->second;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file ip_address.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the packed, binary IPv4/IPv6 address.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <cstddef>
+
+#include <arpa/inet.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "ip_address.hpp"
+
+static constexpr size_t MIN_V4_LENGTH = 7; //!< The length of the shortest dotted quad ("0.0.0.0")
+static constexpr size_t MAX_V4_LENGTH = 15; //!< The length of the longest (unpadded) dotted quad
+static constexpr size_t V4_PADDING = 3; //!< The bytes in front of a dotted quad, so that a field's last three digits can always be read
+
+/**
+ * @brief Finds the dots and digits in the first 16 characters of a buffer.
+ *
+ * @param buffer The characters (16 readable bytes).
+ * @param dotMask Receives a bit per character which is a '.'.
+ * @param digitMask Receives a bit per character which is a decimal digit.
+ */
+static inline void classifyV4(const char* buffer, uint32_t& dotMask, uint32_t& digitMask) {
+#if defined(__SSE2__)
+    const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer));
+    const auto dots = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('.'));
+    // bytes >= 0x80 are negative, so they fail the first comparison
+    const auto digits = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+
+    dotMask = static_cast<uint32_t>(_mm_movemask_epi8(dots));
+    digitMask = static_cast<uint32_t>(_mm_movemask_epi8(digits));
+#else
+    dotMask = digitMask = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        dotMask |= static_cast<uint32_t>(buffer[i] == '.') << i;
+        digitMask |= static_cast<uint32_t>(buffer[i] >= '0' && buffer[i] <= '9') << i;
+    }
+#endif
+}
+
+/**
+ * @brief Parses a dotted quad.
+ *
+ * @remarks Leading zeros are accepted and read as decimal ("010.001.002.003" is 10.1.2.3), so that zero-padded
+ * addresses map to the same address as their canonical form. Anything but four fields of digits is rejected.
+ *
+ * @param text The text to parse (7 to 15 characters; checked by the caller).
+ * @param buffer The text, preceded by @see V4_PADDING and followed by enough zeros to read 16 bytes.
+ * @param out Receives the address in network byte order.
+ *
+ * @return true If the text is a valid dotted quad.
+ * @return false Otherwise.
+ */
+static bool parseV4(string_view text, const char* buffer, uint8_t (&out)[4]) {
+    const auto* chars = buffer + V4_PADDING;
+
+    uint32_t dotMask, digitMask;
+    classifyV4(chars, dotMask, digitMask);
+
+    const uint32_t lengthMask = (1u << text.size()) - 1;
+    dotMask &= lengthMask;
+    digitMask &= lengthMask;
+    if ((dotMask | digitMask) != lengthMask || __builtin_popcount(dotMask) != 3) { return false; }
+
+    const auto digit = [&](std::ptrdiff_t position) { return static_cast<uint32_t>(static_cast<uint8_t>(chars[position]) - '0'); };
+
+    std::ptrdiff_t fieldStart = 0;
+    for (size_t field = 0; field < 4; field++) {
+        const auto fieldEnd = field < 3 ? static_cast<std::ptrdiff_t>(__builtin_ctz(dotMask)) : static_cast<std::ptrdiff_t>(text.size());
+        const auto fieldLength = fieldEnd - fieldStart;
+        dotMask &= dotMask - 1;
+
+        if (fieldLength == 0) { return false; }
+        if (fieldLength > 3) {
+            // zero-padded beyond three digits
+            for (auto i = fieldStart; i < fieldEnd - 3; i++) {
+                if (chars[i] != '0') { return false; }
+            }
+        }
+
+        // the field's last three characters, without branching on the field's length (which is unpredictable); the
+        // padding makes reading in front of the first field safe, and characters outside the field are multiplied by 0
+        const uint32_t value = digit(fieldEnd - 1) + (fieldLength >= 2) * 10 * digit(fieldEnd - 2) + (fieldLength >= 3) * 100 * digit(fieldEnd - 3);
+        if (value > 255) { return false; }
+
+        out[field] = static_cast<uint8_t>(value);
+        fieldStart = fieldEnd + 1;
+    }
+
+    return true;
+}
+
+bool IpAddress::parse(string_view text, IpAddress& out) {
+    if (text.size() >= MIN_V4_LENGTH && text.size() <= MAX_V4_LENGTH) {
+        char buffer[V4_PADDING + 16] = {0};
+        std::memcpy(buffer + V4_PADDING, text.data(), text.size());
+
+        uint8_t v4[4];
+        if (parseV4(text, buffer, v4)) {
+            out = IpAddress{};
+            out.bytes[10] = out.bytes[11] = 0xff;
+            std::memcpy(out.bytes.data() + 12, v4, sizeof(v4));
+            return true;
+        }
+    }
+
+    char buffer[INET6_ADDRSTRLEN + 1];
+    if (text.empty() || text.size() >= sizeof(buffer) || text.find(':') == string_view::npos) { return false; }
+    std::memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+
+    return inet_pton(AF_INET6, buffer, out.bytes.data()) == 1;
+}
+
+IpAddress IpAddress::fromV4(uint32_t address) {
+    IpAddress out{};
+    out.bytes[10] = out.bytes[11] = 0xff;
+    out.bytes[12] = static_cast<uint8_t>(address >> 24);
+    out.bytes[13] = static_cast<uint8_t>(address >> 16);
+    out.bytes[14] = static_cast<uint8_t>(address >> 8);
+    out.bytes[15] = static_cast<uint8_t>(address);
+    return out;
+}
+
+string IpAddress::toString() const {
+    char buffer[INET6_ADDRSTRLEN] = {0};
+
+    if (isV4()) {
+        // the bulk of all addresses; inet_ntop goes through snprintf
+        size_t length = 0;
+        for (size_t i = 12; i < 16; i++) {
+            const auto octet = bytes[i];
+            if (octet >= 100) { buffer[length++] = static_cast<char>('0' + octet / 100); }
+            if (octet >= 10) { buffer[length++] = static_cast<char>('0' + octet / 10 % 10); }
+            buffer[length++] = static_cast<char>('0' + octet % 10);
+            if (i < 15) { buffer[length++] = '.'; }
+        }
+        return string(buffer, length);
+    }
+
+    inet_ntop(AF_INET6, bytes.data(), buffer, sizeof(buffer));
+    return buffer;
+}
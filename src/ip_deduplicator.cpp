@@ -0,0 +1,131 @@
+/**
+ * @file ip_deduplicator.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the cross-jail IP deduplicator.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+
+#include "ip_deduplicator.hpp"
+
+using std::vector;
+
+static constexpr size_t INITIAL_SLOT_COUNT = 1024; //!< The initial size of the table (a power of two)
+static constexpr uint64_t TAG_MASK = 0xffffffff00000000ull; //!< The bits of a slot holding the upper half of the entry's hash
+
+IpDeduplicator::IpDeduplicator(bool keepDetails): m_slots(INITIAL_SLOT_COUNT, 0), m_slotMask(INITIAL_SLOT_COUNT - 1), m_keepDetails(keepDetails) {
+    // set 0 is the empty set every IP starts out with
+    m_jailSets.emplace_back();
+    m_jailSetIds.emplace(vector<uint32_t>{}, 0);
+}
+
+uint32_t IpDeduplicator::jailId(string_view jail) {
+    // IPs arrive jail by jail
+    if (!m_jailNames.empty() && m_jailNames[m_lastJailId] == jail) { return m_lastJailId; }
+
+    const auto [iter, isNew] = m_jailIds.try_emplace(string(jail), static_cast<uint32_t>(m_jailNames.size()));
+    if (isNew) {
+        m_jailNames.emplace_back(jail);
+        m_duplicateCounts.push_back(0);
+    }
+
+    return m_lastJailId = iter->second;
+}
+
+void IpDeduplicator::add(const IpAddress& address, uint32_t jailId, const BanDetails& details) {
+    const auto hash = address.hash();
+    __builtin_prefetch(&m_slots[static_cast<size_t>(hash) & m_slotMask]);
+
+    // the oldest pending IP's slot was prefetched PREFETCH_DISTANCE IPs ago
+    auto& pending = m_pending[m_nextPending];
+    if (m_pendingCount == PREFETCH_DISTANCE) {
+        insert(pending);
+    } else {
+        m_pendingCount++;
+    }
+
+    pending = { address, hash, jailId, details };
+    m_nextPending = (m_nextPending + 1) % PREFETCH_DISTANCE;
+}
+
+void IpDeduplicator::finish() {
+    for (auto i = (m_nextPending + PREFETCH_DISTANCE - m_pendingCount) % PREFETCH_DISTANCE; m_pendingCount > 0; i = (i + 1) % PREFETCH_DISTANCE) {
+        insert(m_pending[i]);
+        m_pendingCount--;
+    }
+}
+
+/**
+ * @brief Adds an IP to the table, or its jail to the IP's entry if it's already there.
+ */
+void IpDeduplicator::insert(const Pending& pending) {
+    const auto tag = pending.hash & TAG_MASK;
+    auto slot = static_cast<size_t>(pending.hash) & m_slotMask;
+    for (; m_slots[slot] != 0; slot = (slot + 1) & m_slotMask) {
+        // only entries whose hash matches in the upper bits are worth a (likely) cache miss
+        if ((m_slots[slot] & TAG_MASK) != tag) { continue; }
+
+        auto& entry = m_entries[(m_slots[slot] & ~TAG_MASK) - 1];
+        if (entry.address == pending.address) {
+            entry.jailSet = withJail(entry.jailSet, pending.jailId);
+            m_duplicateCounts[pending.jailId]++;
+
+            if (m_keepDetails) {
+                auto& details = m_details[(m_slots[slot] & ~TAG_MASK) - 1];
+                if (pending.details.banTime >= details.banTime) { details = pending.details; }
+            }
+            return;
+        }
+    }
+
+    m_entries.push_back({ pending.address, withJail(0, pending.jailId) });
+    if (m_keepDetails) { m_details.push_back(pending.details); }
+    m_slots[slot] = tag | m_entries.size();
+
+    // keep the load factor below 1/2, so that probe sequences stay short
+    if (m_entries.size() * 2 > m_slots.size()) { grow(); }
+}
+
+/**
+ * @brief Gets the ID of the set containing the jails of a set plus another jail, creating the set if necessary.
+ */
+uint32_t IpDeduplicator::withJail(uint32_t jailSet, uint32_t jailId) {
+    if (jailSet == 0 && jailId < m_singleJailSets.size() && m_singleJailSets[jailId] != 0) { return m_singleJailSets[jailId]; }
+
+    const auto key = (static_cast<uint64_t>(jailSet) << 32) | jailId;
+    if (const auto iter = m_transitions.find(key); iter != m_transitions.end()) { return iter->second; }
+
+    auto jails = m_jailSets[jailSet];
+    const auto position = std::lower_bound(jails.begin(), jails.end(), jailId);
+    if (position == jails.end() || *position != jailId) { jails.insert(position, jailId); }
+
+    const auto [iter, isNew] = m_jailSetIds.try_emplace(jails, static_cast<uint32_t>(m_jailSets.size()));
+    if (isNew) { m_jailSets.push_back(std::move(jails)); }
+
+    m_transitions.emplace(key, iter->second);
+    if (jailSet == 0) {
+        if (jailId >= m_singleJailSets.size()) { m_singleJailSets.resize(jailId + 1, 0); }
+        m_singleJailSets[jailId] = iter->second;
+    }
+
+    return iter->second;
+}
+
+/**
+ * @brief Doubles the size of the table and re-inserts all entries.
+ */
+void IpDeduplicator::grow() {
+    m_slots.assign(m_slots.size() * 2, 0);
+    m_slotMask = m_slots.size() - 1;
+
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        const auto hash = m_entries[i].address.hash();
+        auto slot = static_cast<size_t>(hash) & m_slotMask;
+        while (m_slots[slot] != 0) { slot = (slot + 1) & m_slotMask; }
+        m_slots[slot] = (hash & TAG_MASK) | (i + 1);
+    }
+}
@@ -0,0 +1,169 @@
+/**
+ * @file log_follower.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the log file follower.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "log_follower.hpp"
+
+using std::error_code;
+using std::system_error;
+
+static constexpr size_t READ_BUFFER_SIZE = 64 * 1024; //!< The amount of bytes read per call to read(2)
+
+LogFollower::LogFollower(const string& path, uint32_t pollIntervalMs):
+m_path(path), m_pollIntervalMs(pollIntervalMs), m_readBuffer(READ_BUFFER_SIZE) {
+    if (m_pollIntervalMs == 0) {
+        m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotifyFd < 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to initialise inotify"); }
+
+        // watching the directory catches the log file being re-created after rotation
+        auto directory = std::filesystem::path(m_path).parent_path();
+        if (directory.empty()) { directory = "."; }
+        m_dirWatch = inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CREATE | IN_MOVED_TO);
+    }
+
+    openLog(true);
+}
+
+LogFollower::~LogFollower() {
+    closeLog();
+    if (m_inotifyFd >= 0) { close(m_inotifyFd); }
+}
+
+size_t LogFollower::poll(const LineCallback& callback, int32_t timeoutMs) {
+    if (m_inotifyFd >= 0) {
+        pollfd pollFd{ m_inotifyFd, POLLIN, 0 };
+        const auto pollResult = ::poll(&pollFd, 1, timeoutMs);
+        if (pollResult < 0 && errno == EINTR) { return 0; }
+
+        if (pollResult > 0) {
+            // the events themselves don't matter; all we need to know is that something happened
+            alignas(inotify_event) char eventBuffer[4096];
+            while (read(m_inotifyFd, eventBuffer, sizeof(eventBuffer)) > 0) { }
+        }
+    } else if (::poll(nullptr, 0, static_cast<int32_t>(m_pollIntervalMs)) < 0 && errno == EINTR) {
+        return 0;
+    }
+
+    size_t linesRead = 0;
+    if (m_fd < 0) {
+        // the log didn't exist so far; everything in it is new
+        if (!openLog(false)) { return 0; }
+    }
+
+    struct stat fileStat{};
+    if (fstat(m_fd, &fileStat) == 0 && fileStat.st_size < m_offset) {
+        // truncated (copytruncate rotation)
+        lseek(m_fd, 0, SEEK_SET);
+        m_offset = 0;
+        m_partialLine.clear();
+    }
+
+    linesRead += readAvailable(callback);
+
+    if (isRotated()) {
+        // the old file may have received some final lines before it was rotated
+        linesRead += readAvailable(callback);
+        closeLog();
+        if (openLog(false)) { linesRead += readAvailable(callback); }
+    }
+
+    return linesRead;
+}
+
+bool LogFollower::openLog(bool skipExisting) {
+    m_fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) { return false; }
+
+    struct stat fileStat{};
+    fstat(m_fd, &fileStat);
+    m_inode = fileStat.st_ino;
+    m_offset = skipExisting ? lseek(m_fd, 0, SEEK_END) : 0;
+
+    if (m_inotifyFd >= 0) {
+        m_fileWatch = inotify_add_watch(m_inotifyFd, m_path.c_str(), IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF | IN_ATTRIB);
+    }
+
+    return true;
+}
+
+void LogFollower::closeLog() {
+    if (m_fileWatch >= 0) {
+        inotify_rm_watch(m_inotifyFd, m_fileWatch);
+        m_fileWatch = -1;
+    }
+
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+
+    m_partialLine.clear();
+}
+
+/**
+ * @brief Reads everything currently available and passes each complete line to the callback.
+ */
+size_t LogFollower::readAvailable(const LineCallback& callback) {
+    size_t linesRead = 0;
+
+    for (;;) {
+        const auto bytesRead = read(m_fd, m_readBuffer.data(), m_readBuffer.size());
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        } else if (bytesRead < 0) {
+            throw system_error(error_code(errno, std::generic_category()), "Failed to read " + m_path);
+        } else if (bytesRead == 0) {
+            break;
+        }
+
+        m_offset += bytesRead;
+
+        const char* position = m_readBuffer.data();
+        const char* const end = position + bytesRead;
+        while (position < end) {
+            const auto* newline = static_cast<const char*>(memchr(position, '\n', static_cast<size_t>(end - position)));
+            if (newline == nullptr) {
+                m_partialLine.append(position, end);
+                break;
+            }
+
+            if (m_partialLine.empty()) {
+                callback(string_view(position, static_cast<size_t>(newline - position)));
+            } else {
+                m_partialLine.append(position, newline);
+                callback(m_partialLine);
+                m_partialLine.clear();
+            }
+
+            linesRead++;
+            position = newline + 1;
+        }
+    }
+
+    return linesRead;
+}
+
+/**
+ * @brief Whether the path now refers to a different file (or no file at all).
+ */
+bool LogFollower::isRotated() const {
+    struct stat pathStat{};
+    return stat(m_path.c_str(), &pathStat) != 0 || pathStat.st_ino != m_inode;
+}
@@ -0,0 +1,277 @@
+/**
+ * @file log_scanner.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the scanner reading past bans from fail2ban's (rotated) logs.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <future>
+#include <memory>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+
+#include <glob.h>
+#include <sys/stat.h>
+
+#include "compression.hpp"
+#include "f2b_log.hpp"
+#include "log_scanner.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+using std::error_code;
+using std::runtime_error;
+using std::system_error;
+
+static constexpr string_view BAN_MARKER = "Ban "; //!< Contained in every ban line ("] Ban ", "] Restore Ban "), but not in unbans
+static constexpr size_t HOUR_LENGTH = 13; //!< The length of "YYYY-MM-DD HH"
+
+/**
+ * @brief A part of a log file, scanned as one job, and the bans found in it.
+ */
+struct LogScanner::Segment {
+    string_view             data; //!< The segment (mapped), or the complete compressed file
+    bool                    isCompressed = false; //!< Whether data is a compressed file
+    std::vector<LoggedBan>  bans; //!< The bans found, ordered by time once the segment is scanned
+
+    char                    hour[HOUR_LENGTH]{}; //!< The hour ("YYYY-MM-DD HH") of the last converted timestamp
+    int64_t                 hourStartMs = 0; //!< The start of that hour (0 if nothing was converted yet)
+};
+
+/**
+ * @brief Parses a run of decimal digits.
+ */
+static bool parseDigits(string_view text, size_t pos, size_t count, int32_t& out) {
+    out = 0;
+    for (size_t i = pos; i < pos + count; i++) {
+        if (text[i] < '0' || text[i] > '9') { return false; }
+        out = out * 10 + (text[i] - '0');
+    }
+
+    return true;
+}
+
+/**
+ * @brief Converts a log timestamp ("YYYY-MM-DD HH:MM:SS,mmm", local time) to milliseconds since the epoch.
+ *
+ * @remarks Bans are mostly clustered, so the start of the hour is cached per segment and mktime() only runs when the
+ * hour changes. DST transitions happen on full hours, so this is exact.
+ *
+ * @return int64_t The point in time, or 0 if the timestamp is malformed.
+ */
+static int64_t parseTimestamp(string_view timestamp, char (&hour)[HOUR_LENGTH], int64_t& hourStartMs) {
+    if (timestamp.size() < 23 || timestamp[13] != ':' || timestamp[16] != ':' || timestamp[19] != ',') { return 0; }
+
+    if (hourStartMs == 0 || std::memcmp(hour, timestamp.data(), HOUR_LENGTH) != 0) {
+        int32_t year, month, day, hours;
+        if (timestamp[4] != '-' || timestamp[7] != '-' || timestamp[10] != ' ' ||
+            !parseDigits(timestamp, 0, 4, year) || !parseDigits(timestamp, 5, 2, month) ||
+            !parseDigits(timestamp, 8, 2, day) || !parseDigits(timestamp, 11, 2, hours)) {
+            return 0;
+        }
+
+        struct tm tStruct{};
+        tStruct.tm_year = year - 1900;
+        tStruct.tm_mon = month - 1;
+        tStruct.tm_mday = day;
+        tStruct.tm_hour = hours;
+        tStruct.tm_isdst = -1;
+        const auto hourStart = mktime(&tStruct);
+        if (hourStart == static_cast<time_t>(-1)) { return 0; }
+
+        std::memcpy(hour, timestamp.data(), HOUR_LENGTH);
+        hourStartMs = static_cast<int64_t>(hourStart) * 1000;
+    }
+
+    int32_t minutes, seconds, millis;
+    if (!parseDigits(timestamp, 14, 2, minutes) || !parseDigits(timestamp, 17, 2, seconds) || !parseDigits(timestamp, 20, 3, millis)) {
+        return 0;
+    }
+
+    return hourStartMs + (minutes * 60 + seconds) * 1000 + millis;
+}
+
+LogScanner::LogScanner(int64_t since, int64_t until):
+    m_sinceMs(since <= std::numeric_limits<int64_t>::min() / 1000 ? std::numeric_limits<int64_t>::min() : since * 1000),
+    m_untilMs(until >= std::numeric_limits<int64_t>::max() / 1000 ? std::numeric_limits<int64_t>::max() : until * 1000) {}
+
+std::vector<string> LogScanner::expandPatterns(const std::vector<string>& patterns) {
+    std::vector<string> paths;
+    std::set<string, std::less<>> seenPaths;
+
+    for (const auto& pattern : patterns) {
+        glob_t globResult{};
+        const auto result = glob(pattern.c_str(), GLOB_ERR, nullptr, &globResult);
+        const std::unique_ptr<glob_t, decltype(&globfree)> globGuard(&globResult, &globfree);
+        if (result == GLOB_NOMATCH) {
+            throw runtime_error("No log files match " + pattern);
+        } else if (result != 0) {
+            throw runtime_error("Failed to expand " + pattern);
+        }
+
+        for (size_t i = 0; i < globResult.gl_pathc; i++) {
+            string path(globResult.gl_pathv[i]);
+            if (seenPaths.insert(path).second) { paths.push_back(std::move(path)); }
+        }
+    }
+
+    return paths;
+}
+
+size_t LogScanner::scan(const std::vector<string>& paths, ThreadPool& threadPool, const BanCallback& callback) {
+    // the mappings must outlive the jobs; moving a MappedFile doesn't move the mapped pages
+    std::vector<MappedFile> files;
+    std::vector<Segment> segments;
+    for (const auto& path : paths) {
+        struct stat fileStat{};
+        if (stat(path.c_str(), &fileStat) != 0) {
+            throw system_error(error_code(errno, std::generic_category()), "Failed to stat " + path);
+        }
+        // nothing was logged after the file's last modification (st_mtime is truncated to seconds)
+        if ((static_cast<int64_t>(fileStat.st_mtime) + 1) * 1000 <= m_sinceMs) { continue; }
+
+        files.emplace_back(path);
+        planSegments(files.back().view(), segments);
+    }
+
+    // segments are only referenced once all of them are planned, as the vector may still grow until then
+    std::vector<std::future<void>> results;
+    results.reserve(segments.size());
+    for (auto& segment : segments) {
+        results.push_back(threadPool.submit([this, &segment]() {
+            if (segment.isCompressed) {
+                scanCompressed(segment.data, segment);
+            } else {
+                scanText(segment.data, segment);
+                m_bytesScanned += segment.data.size();
+            }
+
+            // fail2ban logs in order, but several processes may write to the same log
+            if (!std::is_sorted(segment.bans.begin(), segment.bans.end(), [](const auto& a, const auto& b) { return a.timeMs < b.timeMs; })) {
+                std::stable_sort(segment.bans.begin(), segment.bans.end(), [](const auto& a, const auto& b) { return a.timeMs < b.timeMs; });
+            }
+        }));
+    }
+    for (auto& result : results) { result.get(); }
+
+    // k-way merge of the (sorted) segments; on equal timestamps, earlier segments go first
+    using head_t = std::pair<int64_t, size_t>; // time of the segment's next ban, segment
+    std::priority_queue<head_t, std::vector<head_t>, std::greater<>> heads;
+    std::vector<size_t> positions(segments.size(), 0);
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!segments[i].bans.empty()) { heads.emplace(segments[i].bans.front().timeMs, i); }
+    }
+
+    size_t banCount = 0;
+    while (!heads.empty()) {
+        const auto segmentIndex = heads.top().second;
+        heads.pop();
+
+        auto& bans = segments[segmentIndex].bans;
+        auto& position = positions[segmentIndex];
+        const auto& ban = bans[position];
+        callback(ban.jail, ban.ip, ban.timeMs / 1000);
+        banCount++;
+
+        if (++position < bans.size()) { heads.emplace(bans[position].timeMs, segmentIndex); }
+    }
+
+    return banCount;
+}
+
+/**
+ * @brief Plans the segments of a mapped log file: compressed files are a single segment, plain files are split at line
+ * boundaries.
+ */
+void LogScanner::planSegments(string_view data, std::vector<Segment>& segments) {
+    if (data.empty()) { return; }
+
+    if (detectCompression(data) != Compression::None) {
+        segments.emplace_back();
+        segments.back().data = data;
+        segments.back().isCompressed = true;
+        return;
+    }
+
+    while (!data.empty()) {
+        auto length = std::min(data.size(), SEGMENT_SIZE);
+        if (length < data.size()) {
+            const auto* lineEnd = static_cast<const char*>(std::memchr(data.data() + length, '\n', data.size() - length));
+            length = lineEnd == nullptr ? data.size() : static_cast<size_t>(lineEnd - data.data()) + 1;
+        }
+
+        segments.emplace_back();
+        segments.back().data = data.substr(0, length);
+        data.remove_prefix(length);
+    }
+}
+
+/**
+ * @brief Decompresses a file and scans it chunk by chunk, carrying incomplete lines over to the next chunk.
+ */
+void LogScanner::scanCompressed(string_view data, Segment& segment) {
+    string carry;
+    decompress(data, [&](string_view chunk) {
+        m_bytesScanned += chunk.size();
+
+        // only the incomplete line at the end is copied, unless a line spans several chunks
+        const auto* lastNewline = static_cast<const char*>(memrchr(chunk.data(), '\n', chunk.size()));
+        if (lastNewline == nullptr) {
+            carry.append(chunk);
+            return;
+        }
+
+        const auto completeLength = static_cast<size_t>(lastNewline - chunk.data()) + 1;
+        if (carry.empty()) {
+            scanText(chunk.substr(0, completeLength), segment);
+        } else {
+            carry.append(chunk.substr(0, completeLength));
+            scanText(carry, segment);
+            carry.clear();
+        }
+        carry.append(chunk.substr(completeLength));
+    });
+
+    scanText(carry, segment);
+}
+
+/**
+ * @brief Scans text for ban lines and adds the bans within the window to the segment.
+ *
+ * @remarks Only the lines containing "Ban " are looked at; they're found with memmem(), which skips over all other
+ * lines without splitting the text into lines first.
+ */
+void LogScanner::scanText(string_view text, Segment& segment) const {
+    const auto* const begin = text.data();
+    const auto* const end = begin + text.size();
+
+    for (const auto* pos = begin; pos < end;) {
+        const auto* marker = static_cast<const char*>(memmem(pos, static_cast<size_t>(end - pos), BAN_MARKER.data(), BAN_MARKER.size()));
+        if (marker == nullptr) { break; }
+
+        const auto* lineStart = static_cast<const char*>(memrchr(begin, '\n', static_cast<size_t>(marker - begin)));
+        lineStart = lineStart == nullptr ? begin : lineStart + 1;
+        const auto* lineEnd = static_cast<const char*>(std::memchr(marker, '\n', static_cast<size_t>(end - marker)));
+        if (lineEnd == nullptr) { lineEnd = end; }
+        pos = lineEnd + 1;
+
+        LogEvent event;
+        if (!parseLogLine(string_view(lineStart, static_cast<size_t>(lineEnd - lineStart)), event) || event.action != LogEvent::Action::Ban) {
+            continue;
+        }
+
+        const auto timeMs = parseTimestamp(event.timestamp, segment.hour, segment.hourStartMs);
+        if (timeMs < m_sinceMs || timeMs >= m_untilMs) { continue; }
+
+        segment.bans.push_back({ timeMs, string(event.jail), string(event.ip) });
+    }
+}
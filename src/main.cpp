@@ -9,396 +9,1743 @@
  */
 
 #include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <exception>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
-#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
-#include <nlohmann/json.hpp>
 #include <fmt/format.h>
 
 #include <getopt.h>
 #include <unistd.h>
 
+#include "ban_snapshot.hpp"
+#include "bulk_uploader.hpp"
+#include "category_table.hpp"
+#include "child_reader.hpp"
+#include "cidr_trie.hpp"
+#include "comment_template.hpp"
+#include "compression.hpp"
+#include "csv_writer.hpp"
+#include "f2b_database.hpp"
+#include "f2b_log.hpp"
+#include "f2b_parser.hpp"
+#include "f2b_socket.hpp"
+#include "host_aggregator.hpp"
+#include "ip_address.hpp"
+#include "ip_deduplicator.hpp"
+#include "log_follower.hpp"
+#include "log_scanner.hpp"
+#include "mapped_file.hpp"
+#include "report_cache.hpp"
+#include "report_scheduler.hpp"
+#include "run_stats.hpp"
+#include "shard_writer.hpp"
 #include "string_splitter.hpp"
+#include "thread_pool.hpp"
 #include "version.hpp"
 
 namespace fs = std::filesystem;
 
 using fmt::format;
 
-using nlohmann::json;
-
-using defcat_t = std::vector<int32_t>;
-using lookup_t = std::map<std::string, int32_t>;
+using banset_t = std::unordered_map<std::string, std::unordered_set<IpAddress, IpAddressHash>>;
+using bansink_t = std::function<void(string_view, string_view, const BanDetails&)>;
+using feeder_t = std::function<void(Fail2BanParser&, const bansink_t&)>;
+using batchcompletion_t = std::function<BulkUploader::CompletionCallback(size_t)>;
 using std::cerr;
 using std::cin;
 using std::cout;
 using std::endl;
 using std::error_code;
 using std::exception;
-using std::ifstream;
-using std::istreambuf_iterator;
-using std::map;
 using std::ofstream;
 using std::string;
 using std::string_view;
 using std::system_error;
-using std::transform;
 using std::vector;
 
-// prototypes
-static constexpr string_view getShortArgs(); //!< Gets the short string of args for getopt_long
-static const option* getOptions(); //!< Gets the array of options for getopt_long
+/**
+ * @brief A slice of one jail's banned IPs, which is rendered to CSV rows on the thread pool.
+ * 
+ * @remarks A task carries everything its worker needs; workers share nothing but read-only configuration.
+ */
+struct JailTask {
+    /**
+     * @brief Where a rendered row ends, and which IP it reports.
+     */
+    struct Row {
+        size_t      end; //!< The offset just past the row in @see rows
+        IpAddress   address; //!< The reported IP
+    };
+
+    string              jail; //!< The jail the IPs are banned in (the first of them, if deduplicated)
+    string              jails; //!< The jails named in the comment (all jails the IPs are banned in)
+    string              categories; //!< The categories reported (those of all jails the IPs are banned in)
+    const CommentTemplate*
+                        comment = nullptr; //!< The comment, bound to all of its variables
+    vector<IpAddress>   addresses; //!< The banned IPs
+    vector<BanDetails>  details; //!< The details of the bans, by index into addresses (empty unless the input has them)
+    size_t              ipCount = 0; //!< The amount of IPs
+    fmt::memory_buffer  rows; //!< The rendered CSV rows
+    vector<Row>         rowInfo; //!< One entry per rendered row
+    std::future<void>   isRendered; //!< Becomes ready once the rows are rendered
+    double              renderWallSeconds = 0; //!< The wall time the worker spent rendering (with --stats)
+    double              renderCpuSeconds = 0; //!< The CPU time the worker spent rendering (with --stats)
+};
+
+// prototypes
+static constexpr string_view getShortArgs(); //!< Gets the short string of args for getopt_long
+static const option* getOptions(); //!< Gets the array of options for getopt_long
+
+static bool     alreadyReported(const IpAddress&); //!< Indicates whether or not an IP has already been reported
+static bool     compileComment(); //!< Compiles the report comment and binds the hostname
+static bool     emitBan(CsvWriter&, string_view, const IpAddress&, const CommentTemplate&, const CommentTemplate::Values&); //!< Filters a banned IP and writes its CSV row
+static bool     findFail2Ban(); //!< Attempts to find fail2ban-client in the system's $PATH
+static bool     isExcluded(const IpAddress&); //!< Indicates whether or not an IP is covered by the exclusion list
+static bool     isJailSelected(string_view); //!< Indicates whether or not a jail is reported, as selected by --jails and --skip-jails
+static bool     loadCategoryOverrides(); //!< Loads the per-jail category overrides
+static bool     loadExclusions(); //!< Loads the CIDR exclusion list (and compiles it to an image if requested)
+static bool     finishUpload(); //!< Waits for all uploads to complete and prints a summary
+static bool     openOutput(); //!< Creates the output file (compressed, if requested)
+static bool     finishOutput(); //!< Completes and closes the output file
+static bool     openShards(); //!< Creates the shard directory and starts the shard writers
+static bool     finishShards(); //!< Waits for the outstanding shards and prints a summary
+static bool     openReportCache(); //!< Opens the cache of reported IPs
+static bool     openScheduler(); //!< Opens the queue of scheduled reports
+static bool     drainQueue(); //!< Delivers the queued reports which are due, as far as the daily quota allows
+static bool     closeScheduler(); //!< Writes the queue to disk and prints a summary
+static bool     openSnapshot(); //!< Loads the snapshot of the IPs banned at the end of the previous run
+static bool     commitSnapshot(); //!< Replaces the snapshot with the IPs banned during this run
+static bool     commitDbCheckpoint(); //!< Records the end of the window read from fail2ban's database
+static bool     openUploader(); //!< Sets up the abuseipdb bulk-report uploader
+static bool     outputCsv(const feeder_t&, bool = true); //!< Streams fail2ban's output through the parser and dumps the CSV-encoded data to the terminal
+static bool     parseArgs(int32_t argc, char** argv); //!< Parses the application arguments
+static bool     parseTimeArg(const string&, int64_t&); //!< Parses a point in time passed on the command-line
+static bool     parseFail2BanFromFile(); //!< Parses fail2ban output from a given file
+static bool     parseFail2BanFromChild(); //!< Runs fail2ban-client and parses its output while it is being produced
+static bool     parseFail2BanFromDatabase(); //!< Reads the bans from fail2ban's database
+static bool     parseFail2BanFromLogs(); //!< Reads the bans from fail2ban's (rotated) log files
+static bool     parseFail2BanFromHosts(); //!< Merges the ban lists exported by many hosts
+static bool     parseFail2BanFromSocket(Fail2BanSocket&); //!< Parses the ban list received through fail2ban's control socket
+static bool     parseFail2BanFromStdIn(); //!< Parses fail2ban output from stdin
+static bool     watchFail2BanLog(); //!< Follows fail2ban's log and outputs newly banned IPs as they appear
+static int32_t  finishRun(int32_t); //!< Prints the run's stats (if requested) and returns the exit code
+static int32_t  processInput(); //!< Processes the selected input (file, stdin or fail2ban) and returns the exit code
+static BulkUploader::CompletionCallback cacheOnAcceptance(size_t); //!< Takes the next uploaded rows' IPs and caches them once their batch is accepted
+static CsvWriter makeCsvWriter(const batchcompletion_t& = nullptr); //!< Creates a writer for stdout or, when uploading or sharding, for the uploader or the shards
+static string   getTimeString(time_t); //!< Formats a point in time as expected by abuseipdb
+static vector<string> getSelectedJails(string_view); //!< Extracts the selected jails from the answer to fail2ban's status command
+static string   getBanTimeString(string_view); //!< Formats the timestamp of a fail2ban log line as expected by abuseipdb
+static string_view getCategoriesForJail(string_view); //!< Gets the categories for a given jail
+static void     cacheReportedIp(const IpAddress&); //!< Stores the reported IP into the cache file
+static void     recordReport(const IpAddress&); //!< Caches an IP whose row was written or, when uploading, tracks it until its batch is accepted
+static void     closeReportCache(); //!< Compacts (if requested) and syncs the cache of reported IPs
+static void     feedFromFd(int32_t, Fail2BanParser&); //!< Reads fail2ban's output from a file descriptor into the parser
+static void     feedParser(Fail2BanParser&, string_view); //!< Feeds a chunk of fail2ban's output into the parser
+static void     feedMappedInput(Fail2BanParser&, string_view); //!< Feeds a complete (possibly compressed) input into the parser
+static void     mergeJailTask(JailTask&, CsvWriter&); //!< Writes a rendered task's rows, skipping IPs reported meanwhile
+static void     printHelpText(const string&); //!< Prints the help text to the terminal
+static void     queueReport(const IpAddress&, string_view, string_view); //!< Queues a rendered row instead of writing it
+static void     renderJailTask(JailTask&, string_view); //!< Renders a task's rows (runs on the thread pool)
+
+// globals
+static bool     g_readFromFile = false; //!< Whether or not to read f2b input from a file
+static bool     g_readFromStdIn = false; //!< Whether or not to read f2b input from stdin
+static bool     g_callF2b = false; //!< Whether or not -% was passed explicitly
+static bool     g_csvHeaderWritten = false; //!< Whether or not the CSV header was already printed
+
+static bool     g_useCache = false; //!< Whether or not to skip IPs which were reported recently
+static bool     g_useCacheBloomFilter = false; //!< Whether or not to build a Bloom prefilter for the cache
+static bool     g_compactCache = false; //!< Whether or not to compact the cache after the run
+static bool     g_deduplicate = true; //!< Whether or not to report IPs banned in several jails only once
+
+static constexpr size_t READ_CHUNK_SIZE = 64 * 1024; //!< The amount of bytes read from the input per call to read(2)
+static constexpr size_t JAIL_TASK_SIZE = 16 * 1024; //!< The maximum amount of IPs rendered per task
+static constexpr size_t MAX_F2B_CLIENTS = 8; //!< The maximum amount of fail2ban-client processes querying jails at once
+static constexpr size_t TASKS_PER_THREAD = 4; //!< The amount of tasks queued per thread before the parser waits for the oldest one
+static constexpr int32_t WATCH_TIMEOUT_MS = 1000; //!< The maximum time watch mode waits for inotify events before checking for rotation
+static constexpr int32_t WATCH_UPLOAD_TIMEOUT_MS = 20; //!< The maximum time watch mode waits for log events while uploads are outstanding
+static constexpr string_view UNKNOWN_VALUE = "unknown"; //!< Rendered for comment variables whose value the input doesn't provide
+
+static volatile sig_atomic_t
+                g_stopRequested = 0; //!< Set by SIGINT/SIGTERM to end watch mode
+
+/**
+ * @brief Values returned by getopt_long for options without a short equivalent.
+ */
+enum LongOption: int32_t {
+    OPT_CACHE_TTL = 0x100,
+    OPT_CACHE_BLOOM,
+    OPT_COMPACT_CACHE,
+    OPT_COMPILE_EXCLUDE,
+    OPT_CATEGORY_FILE,
+    OPT_POLL_INTERVAL,
+    OPT_F2B_SOCKET,
+    OPT_UPLOAD,
+    OPT_API_KEY,
+    OPT_MAX_REQUESTS,
+    OPT_THREADS,
+    OPT_STATS,
+    OPT_NO_DEDUPE,
+    OPT_SINCE_SNAPSHOT,
+    OPT_F2B_DB,
+    OPT_DB_CHECKPOINT,
+    OPT_COMPRESS,
+    OPT_FROM_LOG,
+    OPT_SINCE,
+    OPT_UNTIL,
+    OPT_AGGREGATE,
+    OPT_QUEUE,
+    OPT_DAILY_QUOTA,
+    OPT_JAILS,
+    OPT_SKIP_JAILS,
+    OPT_SHARD_DIR,
+    OPT_SHARD_ROWS,
+    OPT_SHARD_BYTES,
+};
+
+static CategoryTable
+                g_categoryTable; //!< Maps jails to their abuseipdb categories (built-in defaults + overrides)
+
+static string   g_cacheFile = "/tmp/f2abipdb.cache"; //!< The path to the cache file
+static string   g_categoryFile = ""; //!< The file containing category overrides
+static time_t   g_cacheTtl = 24 * 60 * 60; //!< The time (in seconds) after which a cached IP may be reported again
+static time_t   g_runTime = time(nullptr); //!< The time at which this run started
+static std::unique_ptr<ReportCache>
+                g_reportCache = nullptr; //!< The cache of reported IPs (if enabled)
+static string   g_excludeFile = ""; //!< The file containing CIDR ranges which must never be reported
+static string   g_excludeImageFile = ""; //!< The file to write the compiled exclusion list to
+static std::unique_ptr<CidrTrie>
+                g_exclusions = nullptr; //!< The CIDR ranges which must never be reported (if any)
+static string   g_watchLogFile = ""; //!< The fail2ban log to follow in watch mode (empty if not watching)
+static uint32_t g_pollIntervalMs = 0; //!< The interval at which to poll the log in watch mode (0 = inotify)
+static banset_t g_bannedIps; //!< The IPs currently banned, per jail (watch mode only)
+static string   g_fail2banExe = ""; //!< The path to the fail2ban-client executable
+static string   g_fail2banSocket = Fail2BanSocket::DEFAULT_SOCKET_PATH; //!< The path to fail2ban's control socket
+static string   g_uploadUrl = ""; //!< The bulk-report endpoint to upload to (empty if printing CSV)
+static string   g_apiKey = ""; //!< The abuseipdb API key
+static size_t   g_maxRequests = BulkUploader::DEFAULT_MAX_IN_FLIGHT; //!< The maximum amount of concurrent upload requests
+static std::unique_ptr<BulkUploader>
+                g_uploader = nullptr; //!< The uploader (if uploading)
+static size_t   g_threadCount = std::max(1u, std::thread::hardware_concurrency()); //!< The amount of threads rendering CSV rows
+static string   g_snapshotFile = ""; //!< The snapshot of the previously banned IPs (empty if reporting all banned IPs)
+static string   g_f2bDatabaseFile = ""; //!< fail2ban's database to read the bans from (empty if not reading the database)
+static string   g_dbCheckpointFile = ""; //!< Records up to when bans were read from the database (empty if reading active bans)
+static int64_t  g_dbCheckpoint = 0; //!< The end of the window read by the previous run (0 if there was none)
+static int64_t  g_dbWindowEnd = 0; //!< The end of the window read by this run (0 until the database was read)
+static std::unique_ptr<BanSnapshot>
+                g_snapshot = nullptr; //!< The loaded snapshot (if any)
+static vector<string>
+                g_logPatterns; //!< The fail2ban logs (shell patterns) to read past bans from (empty if not reading logs)
+static int64_t  g_logSince = std::numeric_limits<int64_t>::min(); //!< Only bans at or after this time are read from the logs
+static int64_t  g_logUntil = std::numeric_limits<int64_t>::max(); //!< Only bans before this time are read from the logs
+static vector<string>
+                g_aggregateInputs; //!< The hosts' ban lists (files or directories) to merge (empty if not aggregating)
+static string   g_queueFile = ""; //!< The queue of scheduled reports (empty if reporting straight away)
+static uint32_t g_dailyQuota = ReportScheduler::DEFAULT_DAILY_QUOTA; //!< The maximum amount of reports per day when scheduling (0 = unlimited)
+static std::unique_ptr<ReportScheduler>
+                g_scheduler = nullptr; //!< The queue of scheduled reports (if scheduling)
+static size_t   g_reportsQueued = 0; //!< The amount of reports queued during this run
+static size_t   g_reportsAlreadyQueued = 0; //!< The amount of reports dropped because the IP's report was still pending
+static size_t   g_reportsDelivered = 0; //!< The amount of queued reports delivered during this run
+static std::deque<IpAddress>
+                g_unsubmittedIps; //!< The IPs of the rows written for upload, but not yet submitted in a batch (in order)
+static std::unordered_set<IpAddress, IpAddressHash>
+                g_uploadedIps; //!< The IPs whose rows were written for upload, but whose batch wasn't settled yet; skipped like cached ones
+static string   g_outputFile = ""; //!< The file to write the CSV to (empty if writing to stdout)
+static string   g_outputCompression = ""; //!< The compression of the output file (empty to choose by extension)
+static string   g_shardDir = ""; //!< The directory to write the CSV to in size-bounded shards (empty if not sharding)
+static size_t   g_shardRows = BulkUploader::MAX_BATCH_LINES - 1; //!< The maximum amount of rows per shard (excluding the header)
+static size_t   g_shardBytes = BulkUploader::MAX_BATCH_BYTES; //!< The maximum size of a shard (including the header)
+static std::unique_ptr<CompressedWriter>
+                g_output = nullptr; //!< The output file (if any)
+static std::unique_ptr<ShardWriter>
+                g_shards = nullptr; //!< The writers of the shards (if sharding)
+static std::unique_ptr<RunStats>
+                g_stats = nullptr; //!< The run's timings and counters (if requested)
+static string   g_fileToRead = "fail2ban.json"; //!< The file to read input from
+static string   g_jailName = ""; //!< The name of the jail (if specific jail exported from f2b)
+static std::set<string, std::less<>>
+                g_includedJails; //!< The only jails which are reported (all if empty)
+static std::set<string, std::less<>>
+                g_skippedJails; //!< The jails which are never reported
+static string   g_reportComment = "IP banned by fail2ban; banned in jail {0}. Report generated by fail2abuseipdb.";
+static CommentTemplate
+                g_commentTemplate; //!< The compiled report comment, with the hostname bound
+
+// main
+int main(int32_t argc, char** argv) {
+    if (!parseArgs(argc, argv)) { return 0; }
+
+    int32_t rval = 0;
+
+    if (!compileComment()) { return finishRun(12); }
+    if (!g_categoryFile.empty() && !loadCategoryOverrides()) { return finishRun(8); }
+    if (!g_excludeFile.empty() && !loadExclusions()) { return finishRun(7); }
+    if (!g_excludeImageFile.empty()) { return finishRun(0); } // only compiling the exclusion list
+    if (g_useCache && !openReportCache()) { return finishRun(6); }
+    if (!g_snapshotFile.empty() && !openSnapshot()) { return finishRun(11); }
+    if (!g_uploadUrl.empty() && !openUploader()) { return finishRun(10); }
+    if (!g_outputFile.empty() && !openOutput()) { return finishRun(14); }
+    if (!g_shardDir.empty() && !openShards()) { return finishRun(17); }
+    if (!g_queueFile.empty() && !openScheduler()) { return finishRun(16); }
+
+    // in watch mode, the current ban list is only read if a source was given explicitly
+    if (g_watchLogFile.empty() || g_readFromFile || g_readFromStdIn || g_callF2b || !g_f2bDatabaseFile.empty()) {
+        RunStats::Scope inputScope(g_stats.get(), RunStats::Stage::Input);
+        rval = processInput();
+    }
+
+    // reports queued by earlier runs are due, even if this one failed
+    if (g_scheduler != nullptr && !drainQueue() && rval == 0) { rval = 16; }
+
+    if (rval == 0 && !g_watchLogFile.empty()) {
+        RunStats::Scope watchScope(g_stats.get(), RunStats::Stage::Watch);
+        rval = watchFail2BanLog() ? 0 : 9;
+    }
+
+    if (g_uploader != nullptr) {
+        RunStats::Scope uploadScope(g_stats.get(), RunStats::Stage::Upload);
+        if (!finishUpload() && rval == 0) { rval = 10; }
+    }
+
+    {
+        RunStats::Scope teardownScope(g_stats.get(), RunStats::Stage::Teardown);
+        if (g_output != nullptr && !finishOutput() && rval == 0) { rval = 14; }
+        if (g_shards != nullptr && !finishShards() && rval == 0) { rval = 17; }
+        if (g_scheduler != nullptr && !closeScheduler() && rval == 0) { rval = 16; }
+        // a failed run keeps the old snapshot, so the IPs it missed are output by the next one
+        if (g_snapshot != nullptr && rval == 0 && !commitSnapshot()) { rval = 11; }
+        if (!g_dbCheckpointFile.empty() && g_dbWindowEnd != 0 && rval == 0 && !commitDbCheckpoint()) { rval = 13; }
+        closeReportCache();
+    }
+
+    return finishRun(rval);
+}
+
+/**
+ * @brief Prints the run's stats as JSON to stderr, if they were requested.
+ * 
+ * @param exitCode The exit code of the run.
+ * 
+ * @return int32_t The exit code.
+ */
+int32_t finishRun(int32_t exitCode) {
+    if (g_stats != nullptr) { cerr << g_stats->toJson(exitCode) << endl; }
+
+    return exitCode;
+}
+
+/**
+ * @brief Processes the input selected on the command-line.
+ * 
+ * @return int32_t The exit code.
+ */
+int32_t processInput() {
+    if (!g_f2bDatabaseFile.empty()) {
+        return parseFail2BanFromDatabase() ? 0 : 13;
+    } else if (!g_logPatterns.empty()) {
+        return parseFail2BanFromLogs() ? 0 : 15;
+    } else if (!g_aggregateInputs.empty()) {
+        return parseFail2BanFromHosts() ? 0 : 1;
+    } else if (g_readFromFile) {
+        return parseFail2BanFromFile() ? 0 : 1;
+    } else if (g_readFromStdIn) {
+        return parseFail2BanFromStdIn() ? 0 : 2;
+    }
+
+    // talking to fail2ban-server directly saves a Python interpreter, a shell and a temporary file
+    std::unique_ptr<Fail2BanSocket> f2bSocket;
+    try {
+        f2bSocket = std::make_unique<Fail2BanSocket>(g_fail2banSocket);
+    } catch (const system_error& ex) {
+        cerr << "Failed to connect to fail2ban's socket; falling back to fail2ban-client." << endl
+             << "Error description: " << ex.what() << endl;
+    }
+    if (f2bSocket != nullptr) { return parseFail2BanFromSocket(*f2bSocket) ? 0 : 3; }
+
+    if (getuid() != 0) {
+        cerr << "Insufficent permissions! To execute fail2ban directly, elevated permissions are required." << endl;
+        return 4;
+    }
+    if (g_fail2banExe.empty()) {
+        cerr << "Searching for fail2ban..." << endl;
+        if (!findFail2Ban()) {
+            cerr << "Failed to find fail2ban! Aborting." << endl;
+            return 3;
+        }
+    }
+
+    return parseFail2BanFromChild() ? 0 : 3;
+}
+
+/**
+ * @brief Follows fail2ban's log and outputs a CSV row for every IP banned after the start of the run.
+ * 
+ * @remarks The currently banned IPs are kept in memory (seeded by the initial input, if any); bans of IPs which are
+ * already banned in the same jail (e.g. restored bans) are not output again. Runs until SIGINT or SIGTERM is received.
+ * 
+ * @return true If watching ended because a stop was requested.
+ * @return false If the log could not be followed.
+ */
+bool watchFail2BanLog() {
+    struct sigaction stopAction{};
+    stopAction.sa_handler = [](int32_t) { g_stopRequested = 1; };
+    sigemptyset(&stopAction.sa_mask);
+    sigaction(SIGINT, &stopAction, nullptr);
+    sigaction(SIGTERM, &stopAction, nullptr);
+
+    try {
+        LogFollower follower(g_watchLogFile, g_pollIntervalMs);
+        auto csvWriter = makeCsvWriter();
+        csvWriter.flush();
+
+        // each jail's comment is rendered once; the times vary per ban
+        std::map<string, CommentTemplate, std::less<>> jailComments;
+        CommentTemplate::Values commentValues{};
+        commentValues[static_cast<size_t>(CommentTemplate::Field::Failures)] = UNKNOWN_VALUE;
+        string reportTime, banTime;
+
+        const auto onLine = [&](string_view line) {
+            LogEvent event;
+            IpAddress address;
+            if (g_stats != nullptr) { g_stats->addBytesRead(line.size() + 1); }
+            if (!parseLogLine(line, event) || !isJailSelected(event.jail) || !IpAddress::parse(event.ip, address)) { return; }
+
+            auto& jailIps = g_bannedIps[string(event.jail)];
+            if (event.action == LogEvent::Action::Unban) {
+                jailIps.erase(address);
+            } else if (jailIps.insert(address).second) {
+                auto comment = jailComments.find(event.jail);
+                if (comment == jailComments.end()) {
+                    comment = jailComments.emplace(event.jail, g_commentTemplate.bind(CommentTemplate::Field::Jails, event.jail)).first;
+                }
+
+                reportTime = getTimeString(g_runTime);
+                banTime = comment->second.uses(CommentTemplate::Field::BanTime) ? getBanTimeString(event.timestamp) : string();
+                commentValues[static_cast<size_t>(CommentTemplate::Field::ReportTime)] = reportTime;
+                commentValues[static_cast<size_t>(CommentTemplate::Field::BanTime)] = banTime;
+                emitBan(csvWriter, event.jail, address, comment->second, commentValues);
+            }
+        };
+
+        while (g_stopRequested == 0) {
+            g_runTime = time(nullptr);
+            // requests only progress while the uploader is called, so it's polled frequently until it's idle again
+            const bool isUploading = g_uploader != nullptr && g_uploader->isBusy();
+            if (follower.poll(onLine, isUploading ? WATCH_UPLOAD_TIMEOUT_MS : WATCH_TIMEOUT_MS) > 0) {
+                csvWriter.flush();
+                if (g_output != nullptr) { g_output->flush(); }
+            }
+            if (g_uploader != nullptr) { g_uploader->poll(); }
+
+            // queued reports become due as time passes, not only when something is banned
+            if (g_scheduler != nullptr && !drainQueue()) { return false; }
+        }
+    } catch (const exception& ex) {
+        cerr << "Failed to watch " << g_watchLogFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Whether or not an IP has been reported within the cache TTL.
+ * 
+ * @param ip The IP to check against
+ * 
+ * @return true If the IP has previously been reported.
+ * @return false Otherwise.
+ */
+bool alreadyReported(const IpAddress& ip) {
+    return g_reportCache != nullptr && (g_reportCache->contains(ip, g_runTime) || g_uploadedIps.count(ip) > 0);
+}
+
+/**
+ * @brief Whether or not an IP is covered by one of the ranges in the exclusion list.
+ * 
+ * @param ip The IP to check.
+ * 
+ * @return true If the IP must not be reported.
+ * @return false Otherwise.
+ */
+bool isExcluded(const IpAddress& ip) {
+    return g_exclusions != nullptr && g_exclusions->contains(ip);
+}
+
+/**
+ * @brief Whether or not a jail's bans are reported, i.e. it's in the --jails list (if any) and not in the --skip-jails list.
+ * 
+ * @param jail The jail to check.
+ * 
+ * @return true If the jail's bans are reported.
+ * @return false Otherwise.
+ */
+bool isJailSelected(string_view jail) {
+    return (g_includedJails.empty() || g_includedJails.count(jail) > 0) && g_skippedJails.count(jail) == 0;
+}
+
+/**
+ * @brief Loads the exclusion list pointed to by @see g_excludeFile and, if requested, writes it to @see g_excludeImageFile.
+ * 
+ * @return true If the list could be loaded (and compiled).
+ * @return false Otherwise.
+ */
+bool loadExclusions() {
+    try {
+        g_exclusions = std::make_unique<CidrTrie>(CidrTrie::load(g_excludeFile));
+
+        if (!g_excludeImageFile.empty()) {
+            g_exclusions->writeImage(g_excludeImageFile);
+            cerr << "Compiled " << g_excludeFile << " to " << g_excludeImageFile << " (" << g_exclusions->nodeCount() << " nodes)" << endl;
+        }
+    } catch (const exception& ex) {
+        cerr << "Failed to load exclusion list " << g_excludeFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Loads the category overrides from @see g_categoryFile.
+ * 
+ * @return true If the overrides could be loaded.
+ * @return false Otherwise.
+ */
+bool loadCategoryOverrides() {
+    try {
+        g_categoryTable.loadOverrides(g_categoryFile);
+    } catch (const exception& ex) {
+        cerr << "Failed to load category overrides " << g_categoryFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Opens the cache file pointed to by @see g_cacheFile.
+ * 
+ * @return true If the cache could be opened.
+ * @return false Otherwise.
+ */
+bool openReportCache() {
+    try {
+        g_reportCache = std::make_unique<ReportCache>(g_cacheFile, g_cacheTtl, g_useCacheBloomFilter);
+    } catch (const exception& ex) {
+        cerr << "Failed to open cache " << g_cacheFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sets up the uploader for @see g_uploadUrl.
+ * 
+ * @return true If the uploader is ready.
+ * @return false Otherwise.
+ */
+bool openUploader() {
+    if (g_apiKey.empty() && getenv("ABUSEIPDB_API_KEY") != nullptr) { g_apiKey = getenv("ABUSEIPDB_API_KEY"); }
+    if (g_apiKey.empty()) {
+        cerr << "Uploading requires an API key! Pass --api-key or set ABUSEIPDB_API_KEY." << endl;
+        return false;
+    }
+
+    try {
+        g_uploader = std::make_unique<BulkUploader>(g_uploadUrl, g_apiKey, g_maxRequests);
+    } catch (const exception& ex) {
+        cerr << "Failed to set up the upload to " << g_uploadUrl << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Creates @see g_outputFile, compressed as requested by @see g_outputCompression or else by its extension, and
+ * writes the CSV header to it.
+ * 
+ * @return true If the file was created.
+ * @return false Otherwise.
+ */
+bool openOutput() {
+    auto compression = compressionForPath(g_outputFile);
+    if (!g_outputCompression.empty() && !parseCompression(g_outputCompression, compression)) {
+        cerr << "Unknown compression " << g_outputCompression << "! Use none, gzip or zstd." << endl;
+        return false;
+    }
+
+    try {
+        g_output = std::make_unique<CompressedWriter>(g_outputFile, compression);
+        g_output->write(CsvWriter::CSV_HEADER);
+    } catch (const exception& ex) {
+        cerr << "Failed to create output file " << g_outputFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Ends the (compressed) stream and closes @see g_outputFile.
+ * 
+ * @return true If the complete output was written.
+ * @return false Otherwise.
+ */
+bool finishOutput() {
+    try {
+        g_output->finish();
+    } catch (const exception& ex) {
+        cerr << "Failed to write output file " << g_outputFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    g_output.reset();
+    return true;
+}
+
+/**
+ * @brief Creates @see g_shardDir and starts the writers of the shards. The shards of a run are named after the time it
+ * started and the process ID, so that runs never overwrite each other's shards.
+ * 
+ * @return true If the directory could be created.
+ * @return false Otherwise.
+ */
+bool openShards() {
+    try {
+        g_shards = std::make_unique<ShardWriter>(g_shardDir, fmt::format("f2abipdb-{0:d}-{1:d}-", static_cast<int64_t>(g_runTime), getpid()));
+    } catch (const exception& ex) {
+        cerr << "Failed to create shard directory " << g_shardDir << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Waits until the outstanding shards are complete and prints a summary to stderr.
+ * 
+ * @return true If all shards were written.
+ * @return false Otherwise.
+ */
+bool finishShards() {
+    try {
+        g_shards->sync();
+    } catch (const exception& ex) {
+        cerr << "Failed to write the shards to " << g_shardDir << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    cerr << "Wrote " << g_shards->shardCount() << " shard(s) to " << g_shardDir << "." << endl;
+    g_shards.reset();
+    return true;
+}
+
+/**
+ * @brief Waits for the outstanding uploads and prints a summary to stderr.
+ * 
+ * @return true If every batch was accepted.
+ * @return false Otherwise.
+ */
+bool finishUpload() {
+    const bool isComplete = g_uploader->finish();
+
+    cerr << format("Uploaded {0:d} row(s) in {1:d} request(s) ({2:d} retried); abuseipdb saved {3:d} report(s).",
+                   g_uploader->rowsUploaded(), g_uploader->batchesUploaded(), g_uploader->retries(), g_uploader->reportsSaved()) << endl;
+    if (!isComplete) {
+        cerr << "Failed to upload " << g_uploader->batchesFailed() << " request(s)!" << endl
+             << "Error description: " << g_uploader->lastError() << endl;
+    }
+
+    g_uploader.reset();
+    return isComplete;
+}
+
+/**
+ * @brief Compacts the cache (if requested) and writes it back to disk.
+ */
+void closeReportCache() {
+    if (g_reportCache == nullptr) { return; }
+
+    try {
+        if (g_compactCache) { g_reportCache->compact(g_runTime); }
+        g_reportCache->sync();
+    } catch (const exception& ex) {
+        cerr << "Failed to compact cache " << g_cacheFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+    }
+
+    g_reportCache.reset();
+}
+
+/**
+ * @brief Opens the queue pointed to by @see g_queueFile.
+ * 
+ * @return true If the queue could be opened.
+ * @return false Otherwise.
+ */
+bool openScheduler() {
+    try {
+        g_scheduler = std::make_unique<ReportScheduler>(g_queueFile, g_dailyQuota);
+    } catch (const exception& ex) {
+        cerr << "Failed to open queue " << g_queueFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Takes the reports which are due from the queue and writes them out (or uploads them), then writes the queue
+ * to disk.
+ * 
+ * @remarks Uploaded reports are recorded as reported once their batch was accepted, and go back to the queue if it was
+ * given up on; reports written to stdout or the output file are reported once they're written.
+ * 
+ * @return true If the reports were written (or handed to the uploader) and the queue was written.
+ * @return false Otherwise.
+ */
+bool drainQueue() {
+    try {
+        const auto now = time(nullptr);
+        const auto reports = g_scheduler->take(now);
+        if (!reports.empty()) {
+            // the writer keeps the rows in order, so each batch carries the next rowCount reports
+            size_t nextReport = 0;
+            auto csvWriter = makeCsvWriter([&](size_t rowCount) -> BulkUploader::CompletionCallback {
+                vector<IpAddress> addresses;
+                for (; rowCount > 0; rowCount--) { addresses.push_back(reports[nextReport++].address); }
+
+                return [addresses = std::move(addresses)](bool isAccepted) {
+                    if (g_scheduler == nullptr) { return; }
+
+                    const auto reportTime = time(nullptr);
+                    for (const auto& address : addresses) {
+                        if (isAccepted) {
+                            g_scheduler->markReported(address, reportTime);
+                        } else {
+                            g_scheduler->requeue(address);
+                        }
+                    }
+                    if (isAccepted) { g_reportsDelivered += addresses.size(); }
+                };
+            });
+
+            for (const auto& report : reports) { csvWriter.appendRow(report.row); }
+            csvWriter.flush();
+
+            if (g_uploader == nullptr) {
+                // shards are only delivered once they're complete
+                if (g_shards != nullptr) { g_shards->sync(); }
+                for (const auto& report : reports) { g_scheduler->markReported(report.address, now); }
+                g_reportsDelivered += reports.size();
+            }
+            if (!g_watchLogFile.empty() && g_output != nullptr) { g_output->flush(); }
+        }
+
+        g_scheduler->sync(now);
+    } catch (const exception& ex) {
+        cerr << "Failed to deliver the reports queued in " << g_queueFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Writes the queue (including the outcome of the uploads) to disk, prints a summary to stderr and closes it.
+ * 
+ * @return true If the queue was written.
+ * @return false Otherwise.
+ */
+bool closeScheduler() {
+    try {
+        g_scheduler->sync(time(nullptr));
+    } catch (const exception& ex) {
+        cerr << "Failed to write queue " << g_queueFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    const auto nextDue = g_scheduler->nextDue();
+    cerr << format("Queued {0:d} report(s) ({1:d} already pending) and delivered {2:d}; {3:d} report(s) pending.",
+                   g_reportsQueued, g_reportsAlreadyQueued, g_reportsDelivered, g_scheduler->pendingCount());
+    if (nextDue != 0) { cerr << " The next is due at " << getTimeString(nextDue) << "."; }
+    cerr << endl;
+
+    g_scheduler.reset();
+    return true;
+}
+
+/**
+ * @brief Queues a report for delivery once abuseipdb's limits allow it.
+ * 
+ * @param address The reported IP.
+ * @param jail The jail the IP is banned in.
+ * @param row The rendered CSV row.
+ */
+void queueReport(const IpAddress& address, string_view jail, string_view row) {
+    if (g_scheduler->enqueue(address, jail, row, g_runTime)) {
+        g_reportsQueued++;
+    } else {
+        g_reportsAlreadyQueued++;
+    }
+}
+
+/**
+ * @brief Loads the snapshot of the IPs banned at the end of the previous run.
+ * 
+ * @return true If the snapshot was loaded (or doesn't exist yet).
+ * @return false Otherwise.
+ */
+bool openSnapshot() {
+    try {
+        g_snapshot = std::make_unique<BanSnapshot>(g_snapshotFile);
+    } catch (const exception& ex) {
+        cerr << "Failed to load snapshot " << g_snapshotFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Replaces the snapshot with the IPs banned during this run.
+ * 
+ * @return true If the snapshot was written.
+ * @return false Otherwise.
+ */
+bool commitSnapshot() {
+    try {
+        g_snapshot->commit();
+    } catch (const exception& ex) {
+        cerr << "Failed to write snapshot " << g_snapshotFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+
+    g_snapshot.reset();
+    return true;
+}
+
+/**
+ * @brief Records the end of the window read from fail2ban's database, so the next run continues from there.
+ * 
+ * @return true If the checkpoint was written.
+ * @return false Otherwise.
+ */
+bool commitDbCheckpoint() {
+    const auto tmpPath = g_dbCheckpointFile + ".tmp";
+    {
+        ofstream checkpointFile(tmpPath, std::ios::trunc);
+        checkpointFile << g_dbWindowEnd << endl;
+        if (!checkpointFile.good()) {
+            cerr << "Failed to write checkpoint " << g_dbCheckpointFile << "!" << endl;
+            return false;
+        }
+    }
+
+    if (rename(tmpPath.c_str(), g_dbCheckpointFile.c_str()) != 0) {
+        cerr << "Failed to write checkpoint " << g_dbCheckpointFile << "!" << endl
+             << "Error description: " << strerror(errno) << endl;
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Attempts to find fail2ban-client in the directories listed in $PATH.
+ * 
+ * @return true If the executable was found.
+ * @return false Otherwise. 
+ */
+bool findFail2Ban() {
+    const static string PATH = "PATH";
+    const static string FAIL2BAN_EXE = "fail2ban-client";
+
+    const auto* pathVar = getenv(PATH.c_str());
+    if (pathVar == nullptr) { return false; }
+
+    for (const auto directory : StringSplit(string_view(pathVar, strnlen(pathVar, 4096)), ':')) {
+        // empty entries mean the working directory; missing directories are skipped rather than aborting the search
+        error_code error;
+        const auto candidate = fs::path(directory.empty() ? "." : directory) / FAIL2BAN_EXE;
+        if (fs::is_regular_file(candidate, error) && access(candidate.c_str(), X_OK) == 0) {
+            g_fail2banExe = candidate.string();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Parses the f2b input from the file pointed to by @see g_fileToRead
+ * 
+ * @remarks The file is memory-mapped and handed to the parser in one go, so IPs and jail names are never copied.
+ * 
+ * @return true If the file was read correctly.
+ * @return false Otherwise.
+ */
+bool parseFail2BanFromFile() {
+    if (!fs::exists(g_fileToRead) || !fs::is_regular_file(g_fileToRead)) {
+        cerr << "File " << g_fileToRead << " cannot be read! Aborting..." << endl;
+        return false;
+    }
+
+    try {
+        const MappedFile mappedFile(g_fileToRead);
+        return outputCsv([&](Fail2BanParser& parser, const bansink_t&) { feedMappedInput(parser, mappedFile.view()); });
+    } catch (const system_error& ex) {
+        cerr << "Failed to open file " << g_fileToRead << ". Aborting..." << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+}
+
+/**
+ * @brief Reads the bans from fail2ban's database, jail by jail.
+ * 
+ * @remarks Without a checkpoint (or on the first run with one), the bans which are active right now are read. With a
+ * checkpoint, the bans since the end of the previous run's window are read, whether or not they expired meanwhile. A
+ * window ends just before the current second, so bans written during that second are left for the next run.
+ * 
+ * @return true If the bans were read.
+ * @return false Otherwise.
+ */
+bool parseFail2BanFromDatabase() {
+    bool isIncremental = false;
+    if (!g_dbCheckpointFile.empty()) {
+        std::ifstream checkpointFile(g_dbCheckpointFile);
+        if (checkpointFile.is_open()) {
+            if (!(checkpointFile >> g_dbCheckpoint) || g_dbCheckpoint < 0) {
+                cerr << "Failed to read checkpoint " << g_dbCheckpointFile << "!" << endl;
+                return false;
+            }
+            isIncremental = true;
+        }
+    }
+
+    try {
+        const Fail2BanDatabase database(g_f2bDatabaseFile);
+        const int64_t windowEnd = g_runTime;
+
+        const bool rval = outputCsv([&](Fail2BanParser&, const bansink_t& banSink) {
+            for (const auto& jail : database.jails()) {
+                if (!g_jailName.empty() && jail != g_jailName) { continue; }
+
+                RunStats::Scope parseScope(g_stats.get(), RunStats::Stage::Parse);
+                database.readBans(jail, g_dbCheckpoint, windowEnd, !isIncremental, [&](string_view, string_view ip, int64_t banTime, int32_t failures) {
+                    banSink(jail, ip, BanDetails{ banTime, failures });
+                });
+            }
+        }, false);
+        if (rval) { g_dbWindowEnd = windowEnd - 1; }
+
+        return rval;
+    } catch (const exception& ex) {
+        cerr << "Failed to open fail2ban's database " << g_f2bDatabaseFile << "!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+}
+
+/**
+ * @brief Reads the bans within the time window (--since/--until) from fail2ban's log files, oldest first.
+ * 
+ * @remarks Rotated and compressed logs are read as well; the bans of all files are merged by their timestamp. Each ban
+ * is read, whether or not it was lifted meanwhile.
+ * 
+ * @return true If the bans were read.
+ * @return false Otherwise.
+ */
+bool parseFail2BanFromLogs() {
+    try {
+        const auto logFiles = LogScanner::expandPatterns(g_logPatterns);
+        LogScanner scanner(g_logSince, g_logUntil);
+
+        const bool rval = outputCsv([&](Fail2BanParser&, const bansink_t& banSink) {
+            RunStats::Scope parseScope(g_stats.get(), RunStats::Stage::Parse);
+            ThreadPool scanPool(g_threadCount);
+            scanner.scan(logFiles, scanPool, [&](string_view jail, string_view ip, int64_t banTime) {
+                if (!g_jailName.empty() && jail != g_jailName) { return; }
+
+                banSink(jail, ip, BanDetails{ banTime, -1 });
+            });
+            if (g_stats != nullptr) { g_stats->addBytesRead(scanner.bytesScanned()); }
+        }, false);
+
+        return rval;
+    } catch (const exception& ex) {
+        cerr << "Failed to read fail2ban's logs!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+}
+
+/**
+ * @brief Merges the ban lists exported by many hosts (e.g. collected from a fleet of servers) into one report.
+ * 
+ * @remarks Each IP is reported once, with the jails it's banned in on any of the hosts. Hosts whose list can't be parsed
+ * are reported; the IPs read from them up to the error are kept, but the run fails.
+ * 
+ * @return true If all lists were read.
+ * @return false Otherwise.
+ */
+bool parseFail2BanFromHosts() {
+    bool isComplete = true;
+    try {
+        const auto hostFiles = HostAggregator::expandInputs(g_aggregateInputs);
+        HostAggregator aggregator(g_jailName);
+
+        const bool rval = outputCsv([&](Fail2BanParser&, const bansink_t& banSink) {
+            {
+                RunStats::Scope parseScope(g_stats.get(), RunStats::Stage::Parse);
+                ThreadPool aggregatePool(g_threadCount);
+                aggregator.aggregate(hostFiles, aggregatePool, [&](const string& path, const string& error) {
+                    cerr << "Failed to parse " << path << "! Invalid format?" << endl
+                         << "Error description: " << error << endl;
+                    isComplete = false;
+                });
+            }
+            if (aggregator.invalidCount() > 0) { cerr << "Skipped " << aggregator.invalidCount() << " invalid IP(s)." << endl; }
+
+            BanDetails details;
+            for (const auto& entry : aggregator.entries()) {
+                details.hostCount = entry.hostCount;
+                const auto ip = entry.address.toString();
+                for (const auto jailId : aggregator.jailSet(entry.jailSet)) { banSink(aggregator.jailName(jailId), ip, details); }
+            }
+        }, false);
+
+        return rval && isComplete;
+    } catch (const exception& ex) {
+        cerr << "Failed to read the hosts' ban lists!" << endl
+             << "Error description: " << ex.what() << endl;
+        return false;
+    }
+}
+
+/**
+ * @brief Lists fail2ban's jails with fail2ban-client, then queries the ban list of each selected jail with a client of its
+ * own and streams their output into the pipeline.
+ * 
+ * @remarks Each client spends most of its time starting Python and printing its list, so up to @see MAX_F2B_CLIENTS of
+ * them run at once, and the run takes about as long as the slowest jail instead of all of them combined. Each client's
+ * output is read on a separate thread and parsed as it arrives, whichever client it comes from, with a parser per client
+ * using the jail name as the default, like single-jail exports with -j. As soon as a client is done, the next jail's
+ * client takes its place, so a slow jail doesn't hold up the others.
+ * 
+ * @return true If everything was successful.
+ * @return false Otherwise.
+ */
+bool parseFail2BanFromChild() {
+    const auto waitForClient = [](ChildReader& childReader) {
+        if (const auto exitCode = childReader.wait(); exitCode != 0) {
+            throw std::runtime_error(fmt::format("{0:s} exited with code {1:d}", g_fail2banExe, exitCode));
+        }
+    };
+
+    return outputCsv([&](Fail2BanParser&, const bansink_t& banSink) {
+        string chunk;
+        string status;
+        {
+            ChildReader statusReader({ g_fail2banExe, "status" });
+            while (statusReader.next(chunk)) { status.append(chunk); }
+            waitForClient(statusReader);
+        }
+        const auto jails = getSelectedJails(status);
+
+        // the clients' readers signal new output here (declared before the clients, which use it until they're gone)
+        std::mutex readyMutex;
+        std::condition_variable readyCondition;
+        uint64_t readyCount = 0;
+        const auto onReady = [&]() {
+            {
+                std::lock_guard<std::mutex> lock(readyMutex);
+                readyCount++;
+            }
+            readyCondition.notify_one();
+        };
+
+        struct JailClient {
+            std::unique_ptr<Fail2BanParser> parser;
+            std::unique_ptr<ChildReader>    reader;
+        };
+        vector<JailClient> clients;
+        size_t nextJail = 0;
+        const auto startClients = [&]() {
+            for (; nextJail < jails.size() && clients.size() < MAX_F2B_CLIENTS; nextJail++) {
+                auto parser = std::make_unique<Fail2BanParser>([&](string_view parsedJail, string_view ip) { banSink(parsedJail, ip, BanDetails{}); }, jails[nextJail]);
+                auto reader = std::make_unique<ChildReader>(vector<string>{ g_fail2banExe, "get", jails[nextJail], "banned" }, onReady);
+                clients.push_back({ std::move(parser), std::move(reader) });
+            }
+        };
+
+        startClients();
+        while (!clients.empty()) {
+            uint64_t seenReadyCount = 0;
+            {
+                std::lock_guard<std::mutex> lock(readyMutex);
+                seenReadyCount = readyCount;
+            }
+
+            bool isProgress = false;
+            for (auto client = clients.begin(); client != clients.end();) {
+                while (client->reader->tryNext(chunk)) {
+                    feedParser(*client->parser, chunk);
+                    isProgress = true;
+                }
+
+                if (!client->reader->isDrained()) {
+                    ++client;
+                    continue;
+                }
+
+                waitForClient(*client->reader);
+                client->parser->finish();
+                client = clients.erase(client);
+                isProgress = true;
+            }
+            startClients();
+
+            if (!isProgress) {
+                std::unique_lock<std::mutex> lock(readyMutex);
+                readyCondition.wait(lock, [&]() { return readyCount != seenReadyCount; });
+            }
+        }
+    }, false);
+}
+
+/**
+ * @brief Requests the ban list of all jails through fail2ban's control socket and streams the addresses into the pipeline.
+ * 
+ * @remarks The answer is decoded while it's being received, and each address is passed on as soon as it's decoded; the
+ * ban list is never held (or rendered and parsed again) as a whole. If jails were selected with --jails or --skip-jails,
+ * the jails are listed first and only the selected jails are queried. fail2ban-server answers one command at a time, so
+ * they're queried in turn over the same connection.
+ * 
+ * @param f2bSocket The connected socket.
+ * 
+ * @return true If everything was successful.
+ * @return false Otherwise.
+ */
+bool parseFail2BanFromSocket(Fail2BanSocket& f2bSocket) {
+    return outputCsv([&](Fail2BanParser&, const bansink_t& banSink) {
+        const auto onBan = [&](string_view jail, string_view ip) { banSink(jail, ip, BanDetails{}); };
+        RunStats::Scope parseScope(g_stats.get(), RunStats::Stage::Parse);
+
+        if (g_includedJails.empty() && g_skippedJails.empty()) {
+            f2bSocket.queryBans({ "banned" }, g_jailName, onBan);
+        } else {
+            string status;
+            f2bSocket.send({ "status" }, [&](string_view chunk) { status.append(chunk); });
+
+            for (const auto& jail : getSelectedJails(status)) { f2bSocket.queryBans({ "get", jail, "banned" }, jail, onBan); }
+        }
+
+        if (g_stats != nullptr) { g_stats->addBytesRead(f2bSocket.bytesReceived()); }
+    }, false);
+}
+
+/**
+ * @brief Attempts to read input from fail2ban from stdin.
+ * 
+ * @remarks If stdin is redirected from a regular file, the file is memory-mapped instead of read.
+ * 
+ * @return true If everything was successful.
+ * @return false Otherwise.
+ */
+bool parseFail2BanFromStdIn() {
+    if (MappedFile::isMappable(STDIN_FILENO)) {
+        try {
+            const MappedFile mappedFile(STDIN_FILENO);
+            return outputCsv([&](Fail2BanParser& parser, const bansink_t&) { feedMappedInput(parser, mappedFile.view()); });
+        } catch (const system_error&) {
+            // fall back to reading
+        }
+    }
+
+    return outputCsv([](Fail2BanParser& parser, const bansink_t&) { feedFromFd(STDIN_FILENO, parser); });
+}
+
+/**
+ * @brief Reads fail2ban's output from a file descriptor and feeds it into the parser chunk by chunk.
+ * 
+ * @param fd The file descriptor to read from.
+ * @param parser The parser to feed.
+ * 
+ * @throws system_error If reading from the file descriptor fails.
+ */
+void feedFromFd(int32_t fd, Fail2BanParser& parser) {
+    vector<char> buffer(READ_CHUNK_SIZE);
+    for (;;) {
+        const auto bytesRead = read(fd, buffer.data(), buffer.size());
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        } else if (bytesRead < 0) {
+            throw system_error(error_code(errno, std::generic_category()), "Failed to read fail2ban output");
+        } else if (bytesRead == 0) {
+            break;
+        }
+
+        feedParser(parser, string_view(buffer.data(), static_cast<size_t>(bytesRead)));
+    }
+}
+
+/**
+ * @brief Feeds a complete input into the parser, decompressing it on the fly if it's gzip- or zstd-compressed.
+ * 
+ * @param parser The parser to feed.
+ * @param input The input (e.g. a mapped file).
+ * 
+ * @throws std::runtime_error If the compressed input is damaged.
+ */
+void feedMappedInput(Fail2BanParser& parser, string_view input) {
+    if (detectCompression(input) == Compression::None) {
+        feedParser(parser, input);
+        return;
+    }
+
+    decompress(input, [&](string_view chunk) { feedParser(parser, chunk); });
+}
+
+/**
+ * @brief Feeds a chunk of fail2ban's output into the parser, accounting the time to the parse stage.
+ * 
+ * @param parser The parser to feed.
+ * @param chunk The chunk to feed.
+ */
+void feedParser(Fail2BanParser& parser, string_view chunk) {
+    RunStats::Scope parseScope(g_stats.get(), RunStats::Stage::Parse);
+    if (g_stats != nullptr) { g_stats->addBytesRead(chunk.size()); }
+
+    parser.feed(chunk);
+}
+
+/**
+ * @brief Streams fail2ban's output through the parser and outputs the CSV-encoded data to the terminal.
+ * 
+ * @param feeder A function which feeds the complete input into the given parser (or, for input which isn't fail2ban's
+ * output, straight into the given sink).
+ * @param isParsed Whether the input is fail2ban's output (false if the feeder only uses the sink).
+ * 
+ * @return true If CSV could be generated and printed.
+ * @return false Otherwise
+ * 
+ * @remarks Each jail's IPs are collected into tasks of up to @see JAIL_TASK_SIZE IPs, which are rendered in parallel on
+ * a thread pool, each into its own buffer. The buffers are merged in the order the IPs were read, so the output is
+ * identical regardless of the amount of threads. If the input turns out to be malformed, the rows generated up to that
+ * point remain.
+ */
+bool outputCsv(const feeder_t& feeder, bool isParsed) {
+    bool rval = true;
+
+    const auto timeString = getTimeString(g_runTime);
 
-using svec_t = vector<string>;
+    // everything but the jails (and the details of bans read from the database) is the same for all rows of a run, so
+    // each jail's comment is rendered once
+    auto runComment = g_commentTemplate.bind(CommentTemplate::Field::ReportTime, timeString);
+    const bool hasBanDetails = !g_f2bDatabaseFile.empty() || !g_logPatterns.empty() || !g_aggregateInputs.empty();
+    if (!hasBanDetails) {
+        runComment = runComment.bind(CommentTemplate::Field::BanTime, UNKNOWN_VALUE).bind(CommentTemplate::Field::Failures, UNKNOWN_VALUE);
+    }
+    std::map<string, CommentTemplate, std::less<>> jailComments;
+    const auto getJailComment = [&](string_view jails) -> const CommentTemplate* {
+        auto iter = jailComments.find(jails);
+        if (iter == jailComments.end()) {
+            iter = jailComments.emplace(jails, runComment.bind(CommentTemplate::Field::Jails, jails.empty() ? "UNKNOWN" : jails)).first;
+        }
 
-static bool     alreadyReported(const string&); //!< Indicates whether or not an IP has already been reported
-static bool     dumpF2bToFile(); //!< Dumps fail2ban's output to a file before attempting to read it back through parseFail2BanFromFile()
-static bool     findFail2Ban(); //!< Attempts to find fail2ban-client in the system's $PATH
-static bool     outputCsv(const json&); //!< Dumps the CSV-encoded data to the terminal
-static bool     parseArgs(int32_t argc, char** argv); //!< Parses the application arguments
-static bool     parseFail2BanFromFile(); //!< Parses fail2ban output from a given file
-static bool     parseFail2BanFromStdIn(); //!< Parses fail2ban output from stdin
-static string   exec(const string&, int32_t&); //!< Executes a program and returns the output
-static string   getCategoriesForJail(); //!< Gets the categories for the currently selected jail
-static svec_t   getLinesFromJson(const json&, const string&); //!< Gets a CSV-formatted line from a JSON object
-// static void     cacheReportedIp(const string&); //!< Stores the reported IP into a cache file
-static void     printHelpText(const string&); //!< Prints the help text to the terminal
-static void     transformFail2BanInput(string&); //!< Transforms the fail2ban output to valid JSON
+        return &iter->second;
+    };
 
-// globals
-static bool     g_readFromFile = false; //!< Whether or not to read f2b input from a file
-static bool     g_readFromStdIn = false; //!< Whether or not to read f2b input from stdin
+    auto csvWriter = makeCsvWriter();
 
-/**
- * @brief Category lookup table
- */
-static map<string, int32_t> 
-                g_categoryLookup = {
-    { "sshd",                   22 },
-    { "apache-auth",            21 },
-    { "apache-batbots",         19 },
-    { "apache-overflows",       21 },
-    { "apache-nohome",          21 },
-    { "apache-fakegooglebot",   19 },
-    { "apache-modsecurity",     21 },
-    { "apache-shellshock",      21 },
-    { "php-url-fopen",          21 },
-    { "roundcube-auth",         21 },
-    { "postfix",                -1 },
-    { "sendmail-auth",          20 },
-    { "sendmail-reject",        -1 },
-    { "dovecot",                -1 },
-    { "mysqld-auth",            21 },
-    { "pam-generic",            20 },
-    { "postfix-flood-attack",   04 }
-};
+    // the tasks must outlive the pool, which may still be working on them when something goes wrong
+    std::deque<std::unique_ptr<JailTask>> tasks;
+    std::unique_ptr<JailTask> currentTask;
+    ThreadPool threadPool(g_threadCount);
+    const auto maxQueuedTasks = threadPool.threadCount() * TASKS_PER_THREAD;
 
-/**
- * @brief Default categories for each entry
- */
-static defcat_t g_defaultCategories = {
-    15, 18
-};
+    // without workers, tasks are rendered by this thread and accounted like any other stage
+    const bool isRenderedInline = g_threadCount <= 1;
+    if (g_stats != nullptr) { g_stats->setThreadCount(threadPool.threadCount()); }
 
-static string   g_cacheFile = "/tmp/f2abipdb.cache"; //!< [[unused currently]] The path to the cache file
-static string   g_fail2banExe = ""; //!< The path to the fail2ban-client executable
-static string   g_fileToRead = "fail2ban.json"; //!< The file to read input from
-static string   g_jailName = ""; //!< The name of the jail (if specific jail exported from f2b)
-static string   g_reportComment = "IP banned by fail2ban; banned in jail {0}. Report generated by fail2abuseipdb.";
+    const auto mergeTasks = [&](size_t maxRemaining) {
+        RunStats::Scope mergeScope(g_stats.get(), RunStats::Stage::Merge);
+        while (!tasks.empty() && (tasks.size() > maxRemaining || tasks.front()->isRendered.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+            tasks.front()->isRendered.get();
+            mergeJailTask(*tasks.front(), csvWriter);
+            tasks.pop_front();
+        }
+    };
+    const auto submitTask = [&]() {
+        if (currentTask == nullptr) { return; }
+
+        auto* task = currentTask.get();
+        const bool isTimed = g_stats != nullptr && !isRenderedInline;
+        {
+            RunStats::Scope renderScope(isRenderedInline ? g_stats.get() : nullptr, RunStats::Stage::Render);
+            task->isRendered = threadPool.submit([task, &timeString, isTimed]() {
+                const auto start = isTimed ? RunStats::sample() : RunStats::Sample{};
+                renderJailTask(*task, timeString);
+                if (!isTimed) { return; }
+
+                const auto end = RunStats::sample();
+                task->renderWallSeconds = std::chrono::duration<double>(end.wall - start.wall).count();
+                task->renderCpuSeconds = end.cpuSeconds - start.cpuSeconds;
+            });
+        }
+        tasks.push_back(std::move(currentTask));
+        mergeTasks(maxQueuedTasks);
+    };
 
-// main
-int main(int32_t argc, char** argv) {
-    if (!parseArgs(argc, argv)) { return 0; }
+    // IPs banned in several jails are collected first and reported once, with the categories of all of their jails
+    auto deduplicator = g_deduplicate ? std::make_unique<IpDeduplicator>(hasBanDetails) : nullptr;
+    const auto submitUniqueIps = [&]() {
+        if (deduplicator == nullptr) { return; }
 
-    int32_t rval = 0;
+        RunStats::Scope parseScope(g_stats.get(), RunStats::Stage::Parse);
+        deduplicator->finish();
+        if (g_stats != nullptr) {
+            for (uint32_t jailId = 0; jailId < deduplicator->jailCount(); jailId++) {
+                g_stats->jail(deduplicator->jailName(jailId)).duplicates += deduplicator->duplicateCount(jailId);
+            }
+        }
 
-    if (g_readFromFile) {
-        rval = parseFail2BanFromFile() ? 0 : 1;
-    } else if (g_readFromStdIn) {
-        rval = parseFail2BanFromStdIn() ? 0 : 2;
-    } else {
-        if (getuid() != 0) {
-            cerr << "Insufficent permissions! To execute fail2ban directly, elevated permissions are required." << endl;
-            return 4;
+        // only output the IPs which weren't banned at the time of the snapshot
+        const auto& entries = deduplicator->entries();
+        vector<bool> isNew;
+        if (g_snapshot != nullptr) {
+            vector<IpAddress> addresses(entries.size());
+            for (size_t i = 0; i < entries.size(); i++) { addresses[i] = entries[i].address; }
+            isNew = g_snapshot->diff(addresses);
         }
-        if (g_fail2banExe.empty()) {
-            cerr << "Searching for fail2ban..." << endl;
-            cerr << "!! WARNING !! Search may or may not be broken!" << endl; // TODO: Remove when bug fixed
-            if (!findFail2Ban()) {
-                cerr << "Failed to find fail2ban! Aborting." << endl;
-                return 3;
+
+        // group the IPs by the jails they're banned in (a counting sort keeps them in order of appearance within a group)
+        vector<size_t> groupStarts(deduplicator->jailSetCount() + 1, 0);
+        for (const auto& entry : entries) { groupStarts[entry.jailSet + 1]++; }
+        for (size_t i = 1; i < groupStarts.size(); i++) { groupStarts[i] += groupStarts[i - 1]; }
+        vector<uint32_t> order(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) { order[groupStarts[entries[i].jailSet]++] = static_cast<uint32_t>(i); }
+
+        uint32_t currentJailSet = 0;
+        vector<uint64_t> unchangedCounts(deduplicator->jailSetCount(), 0);
+        for (const auto index : order) {
+            const auto& entry = entries[index];
+            if (!isNew.empty() && !isNew[index]) {
+                unchangedCounts[entry.jailSet]++;
+                continue;
+            }
+
+            if (currentTask == nullptr || entry.jailSet != currentJailSet || currentTask->ipCount >= JAIL_TASK_SIZE) {
+                submitTask();
+                currentJailSet = entry.jailSet;
+                currentTask = std::make_unique<JailTask>();
+
+                vector<string_view> jails;
+                for (const auto jailId : deduplicator->jailSet(currentJailSet)) {
+                    jails.push_back(deduplicator->jailName(jailId));
+                    if (!currentTask->jails.empty()) { currentTask->jails.append(", "); }
+                    currentTask->jails.append(jails.back());
+                }
+                currentTask->jail = jails.front();
+                currentTask->categories = g_categoryTable.categoriesFor(jails);
+                currentTask->comment = getJailComment(currentTask->jails);
             }
+
+            currentTask->addresses.push_back(entry.address);
+            if (hasBanDetails) { currentTask->details.push_back(deduplicator->details()[index]); }
+            currentTask->ipCount++;
         }
-        if (!dumpF2bToFile()) {
-            cerr << "Failed to get output from fail2ban" << endl;
-            return 3;
+
+        // like rows, unchanged IPs count towards the first jail they're banned in
+        for (uint32_t jailSet = 1; g_stats != nullptr && jailSet < unchangedCounts.size(); jailSet++) {
+            if (unchangedCounts[jailSet] > 0) { g_stats->jail(deduplicator->jailName(deduplicator->jailSet(jailSet).front())).unchanged += unchangedCounts[jailSet]; }
+        }
+
+        submitTask();
+        deduplicator.reset();
+    };
+
+    const bool isWatching = !g_watchLogFile.empty();
+    size_t invalidCount = 0;
+    const auto addBan = [&](string_view jail, string_view ip, const BanDetails& details) {
+        if (!isJailSelected(jail)) { return; }
+
+        // abuseipdb rejects anything but a valid address, and non-canonical forms would slip past the cache
+        IpAddress address;
+        const bool isValid = IpAddress::parse(ip, address);
+        if (g_stats != nullptr) {
+            auto& counters = g_stats->jail(jail);
+            counters.seen++;
+            if (!isValid) { counters.invalid++; }
         }
+        if (!isValid) {
+            invalidCount++;
+            return;
+        }
+
+        // remember what's banned right now, so that watch mode only outputs new bans
+        if (isWatching) { g_bannedIps[string(jail)].insert(address); }
+
+        if (deduplicator != nullptr) {
+            deduplicator->add(address, deduplicator->jailId(jail), details);
+            return;
+        }
+
+        if (currentTask == nullptr || currentTask->jail != jail || currentTask->ipCount >= JAIL_TASK_SIZE) {
+            submitTask();
+            currentTask = std::make_unique<JailTask>();
+            currentTask->jail = jail;
+            currentTask->jails = jail;
+            currentTask->categories = getCategoriesForJail(jail);
+            currentTask->comment = getJailComment(jail);
+        }
+
+        currentTask->addresses.push_back(address);
+        if (hasBanDetails) { currentTask->details.push_back(details); }
+        currentTask->ipCount++;
+    };
+    const bansink_t banSink = addBan;
+    Fail2BanParser parser([&](string_view jail, string_view ip) { addBan(jail, ip, BanDetails{}); }, g_jailName);
 
-        rval = parseFail2BanFromFile() ? 0 : 3;
+    try {
+        try {
+            feeder(parser, banSink);
+            if (isParsed) { parser.finish(); }
+        } catch (const Fail2BanParseError&) {
+            // keep what was read up to the error
+            submitTask();
+            submitUniqueIps();
+            mergeTasks(0);
+            csvWriter.flush();
+            throw;
+        }
+
+        submitTask();
+        submitUniqueIps();
+        mergeTasks(0);
+        csvWriter.flush();
+
+        if (invalidCount > 0) { cerr << "Skipped " << invalidCount << " invalid IP(s)." << endl; }
+    } catch (const Fail2BanParseError& ex) {
+        cerr << "Failed to parse fail2ban output! Invalid format?" << endl
+             << "Error description: " << ex.what() << endl;
+        rval = false;
+    } catch (const exception& ex) {
+        cerr << "Failed to process fail2ban output!" << endl
+             << "Error description: " << ex.what() << endl;
+        rval = false;
     }
 
     return rval;
 }
 
 /**
- * @brief [[Not implemented]] Whether or not an IP has previously been reported.
- * 
- * @remarks Reserved for future use
+ * @brief Renders the rows of all IPs in a task which aren't excluded.
  * 
- * @param ip The IP to check against
+ * @remarks Runs on the thread pool; the cache is only consulted when the rows are merged.
  * 
- * @return true If the IP has previously been reported.
- * @return false Otherwise.
+ * @param task The task to render.
+ * @param timeString The report time.
  */
-bool alreadyReported(const string& ip) {
-    return false;
+void renderJailTask(JailTask& task, string_view timeString) {
+    task.rowInfo.reserve(task.ipCount);
+
+    // only bans read from the database, the logs or several hosts have details; without them, the comment is fully bound
+    const bool hasDetails = !task.details.empty();
+    const bool usesBanTime = hasDetails && task.comment->uses(CommentTemplate::Field::BanTime);
+    CommentTemplate::Values values{};
+    string banTime;
+    int64_t formattedBanTime = -1;
+
+    for (size_t i = 0; i < task.addresses.size(); i++) {
+        const auto& address = task.addresses[i];
+        if (isExcluded(address)) { continue; }
+
+        std::optional<fmt::format_int> failures, hostCount;
+        if (hasDetails) {
+            const auto& details = task.details[i];
+            // bans arrive in order of time, so consecutive rows mostly share the formatted time
+            if (usesBanTime && details.banTime != formattedBanTime) {
+                banTime = details.banTime > 0 ? getTimeString(static_cast<time_t>(details.banTime)) : string(UNKNOWN_VALUE);
+                formattedBanTime = details.banTime;
+            }
+            if (details.failures >= 0) { failures.emplace(details.failures); }
+            if (details.hostCount > 0) { hostCount.emplace(details.hostCount); }
+
+            values[static_cast<size_t>(CommentTemplate::Field::BanTime)] = banTime;
+            values[static_cast<size_t>(CommentTemplate::Field::Failures)] = failures ? string_view(failures->data(), failures->size()) : UNKNOWN_VALUE;
+            values[static_cast<size_t>(CommentTemplate::Field::Hosts)] = hostCount ? string_view(hostCount->data(), hostCount->size()) : UNKNOWN_VALUE;
+        }
+
+        CsvWriter::formatRow(task.rows, address.toString(), task.categories, timeString, [&](fmt::memory_buffer& buffer) { task.comment->render(buffer, values); });
+        task.rowInfo.push_back({ task.rows.size(), address });
+    }
 }
 
 /**
- * @brief Dumps fail2ban's output to a file
+ * @brief Writes the rendered rows of a task, skipping IPs which are in the cache (including those reported by an
+ * earlier task of this run), and records the reported IPs in the cache.
  * 
- * @return true If dumping was successful.
- * @return false Otherwise.
+ * @param task The rendered task.
+ * @param csvWriter The writer to write the rows to.
  */
-bool dumpF2bToFile() {
-    int32_t returnCode = 0;
-    g_fileToRead = fmt::format("{0:s}/{1:d}.f2b", fs::temp_directory_path().string(), time(nullptr));
-    exec(fmt::format(R"({0:s} banned 2>/dev/null > {1:s})", g_fail2banExe, g_fileToRead), returnCode);
+void mergeJailTask(JailTask& task, CsvWriter& csvWriter) {
+    size_t rowStart = 0;
+    size_t cachedCount = 0;
+    for (const auto& row : task.rowInfo) {
+        const string_view rowData(task.rows.data() + rowStart, row.end - rowStart);
+        rowStart = row.end;
+
+        if (g_reportCache != nullptr) {
+            if (alreadyReported(row.address)) {
+                cachedCount++;
+                continue;
+            }
+        }
+
+        if (g_scheduler != nullptr) {
+            if (g_reportCache != nullptr) { cacheReportedIp(row.address); }
+            queueReport(row.address, task.jail, rowData);
+        } else {
+            recordReport(row.address);
+            csvWriter.appendRow(rowData);
+        }
+    }
 
-    return returnCode == 0;
+    if (g_stats != nullptr) {
+        // IPs are counted as they're read; deduplicated IPs' rows count towards the first jail they're banned in
+        auto& counters = g_stats->jail(task.jail);
+        counters.excluded += task.ipCount - task.rowInfo.size();
+        counters.cached += cachedCount;
+        counters.emitted += task.rowInfo.size() - cachedCount;
+        g_stats->addRender(task.renderWallSeconds, task.renderCpuSeconds);
+    }
 }
 
 /**
- * @brief Attempts to find fail2ban-client on the system-
+ * @brief Runs a banned IP through the exclusion list and the cache and, if it passes both, writes its CSV row.
  * 
- * @return true If the executable was found.
- * @return false Otherwise. 
+ * @param csvWriter The writer to write the row to.
+ * @param jail The jail the IP is banned in.
+ * @param address The banned IP.
+ * @param comment The jail's comment.
+ * @param values The values of the comment's variables; the report time is also the row's report date.
+ * 
+ * @return true If a row was written.
+ * @return false If the IP was filtered.
  */
-bool findFail2Ban() {
-    const static string PATH = "PATH";
-    const static string FAIL2BAN_EXE = "fail2ban-client";
+bool emitBan(CsvWriter& csvWriter, string_view jail, const IpAddress& address, const CommentTemplate& comment, const CommentTemplate::Values& values) {
+    auto* counters = g_stats != nullptr ? &g_stats->jail(jail) : nullptr;
+    if (counters != nullptr) { counters->seen++; }
 
-    if (getenv(PATH.c_str()) == nullptr) { return false; }
-
-    string pathVar{};
-    {
-        auto pathCharPtr = getenv(PATH.c_str());
-        pathVar = string(pathCharPtr, strnlen(pathCharPtr, 4096));
+    if (isExcluded(address)) {
+        if (counters != nullptr) { counters->excluded++; }
+        return false;
+    }
+    if (g_reportCache != nullptr && alreadyReported(address)) {
+        if (counters != nullptr) { counters->cached++; }
+        return false;
     }
 
-    for (const auto path : StringSplit(pathVar, ":")) {
-        const auto iterator = fs::directory_iterator(path);
-        const auto iteratorEnd = fs::directory_iterator();
-        const auto iterPosition = std::find_if(iterator, iteratorEnd, [&](const auto& file) {
-            return file.is_regular_file() && file.path().filename() == FAIL2BAN_EXE;
-        });
-
-        if (iterPosition != iteratorEnd) {
-            g_fail2banExe = iterPosition->path().string();
-            return true;
-        }
+    const auto timeString = values[static_cast<size_t>(CommentTemplate::Field::ReportTime)];
+    const auto renderComment = [&](fmt::memory_buffer& buffer) { comment.render(buffer, values); };
+    if (g_scheduler != nullptr) {
+        fmt::memory_buffer row;
+        CsvWriter::formatRow(row, address.toString(), getCategoriesForJail(jail), timeString, renderComment);
+        if (g_reportCache != nullptr) { cacheReportedIp(address); }
+        queueReport(address, jail, string_view(row.data(), row.size()));
+    } else {
+        recordReport(address);
+        csvWriter.writeRow(address.toString(), getCategoriesForJail(jail), timeString, renderComment);
     }
 
-    return false;
+    if (counters != nullptr) { counters->emitted++; }
+    return true;
 }
 
 /**
- * @brief Parses the f2b input from the file pointed to by @see g_fileToRead
+ * @brief Compiles the report comment (@see g_reportComment) and binds the hostname, which is the same for every row.
  * 
- * @return true If the file was read correctly.
+ * @return true If the comment is valid.
  * @return false Otherwise.
  */
-bool parseFail2BanFromFile() {
-    bool rval = true;
-
-    string fileContents{};
-    json entries;
-
-    if (!fs::exists(g_fileToRead) || !fs::is_regular_file(g_fileToRead)) {
-        cerr << "File " << g_fileToRead << " cannot be read! Aborting..." << endl;
-        rval = false;
-        goto Exit;
-    }
-    {
-        ifstream fStream(g_fileToRead, ifstream::openmode::_S_in);
-        if (!fStream.good()) {
-            cerr << "Failed to open file " << g_fileToRead << ". Aborting..." << endl;
-            rval = false;
-            goto Exit;
-        }
-        fStream.unsetf(std::ios_base::skipws);
-        vector<char> buffer((istreambuf_iterator<char>(fStream)), (istreambuf_iterator<char>()));
-        fileContents = string(buffer.begin(), buffer.end());
-    }
-
-    transformFail2BanInput(fileContents);
+bool compileComment() {
     try {
-        entries = json::parse(fileContents);
+        char hostname[256] = {0};
+        const string_view hostnameValue = gethostname(hostname, sizeof(hostname) - 1) == 0 ? string_view(hostname) : UNKNOWN_VALUE;
+
+        g_commentTemplate = CommentTemplate(g_reportComment).bind(CommentTemplate::Field::Hostname, hostnameValue);
+        if (g_aggregateInputs.empty()) { g_commentTemplate = g_commentTemplate.bind(CommentTemplate::Field::Hosts, UNKNOWN_VALUE); }
     } catch (const exception& ex) {
-        cerr << "Failed to parse JSON! Invalid format?" << endl
+        cerr << "Failed to compile the comment!" << endl
              << "Error description: " << ex.what() << endl;
-        rval = false;
-        goto Exit;
+        return false;
     }
 
-    rval = outputCsv(entries);
-
-    Exit:
-    return rval;
+    return true;
 }
 
 /**
- * @brief Attempts to read input from fail2ban from stdin.
+ * @brief Creates the writer the CSV rows go to: stdout, the output file, or the uploader's batches when uploading (and
+ * the output file as well, if there is one, as an archive of what was uploaded).
  * 
- * @return true If everything was successful.
- * @return false Otherwise.
+ * @remarks The CSV header is written to stdout once per run, and to the output file when it's created; the uploader adds
+ * it to every batch itself.
+ * 
+ * @param batchCompletion Creates the callback invoked once an uploaded batch (of the given amount of rows) was accepted or
+ * given up on; only used when uploading.
+ * 
+ * @return CsvWriter The writer.
  */
-bool parseFail2BanFromStdIn() {
-    bool rval = true;
-
-    string f2bOutput{};
-    json entries;
-
-    for (string line{}; std::getline(cin, line);) {
-        f2bOutput.append(line).append("\n");
+CsvWriter makeCsvWriter(const batchcompletion_t& batchCompletion) {
+    if (g_uploader != nullptr) {
+        return CsvWriter([batchCompletion](string_view rows, size_t rowCount) {
+            g_uploader->submit(rows, rowCount, batchCompletion ? batchCompletion(rowCount) : cacheOnAcceptance(rowCount));
+            if (g_output != nullptr) { g_output->write(rows); }
+        }, BulkUploader::MAX_BATCH_LINES - 1, BulkUploader::MAX_BATCH_BYTES - CsvWriter::CSV_HEADER.size());
     }
 
-    if (f2bOutput.empty()) {
-        rval = false;
-        cerr << "Failed to read input from stdin!" << endl;
-        goto Exit;
+    if (g_shards != nullptr) {
+        return CsvWriter([](string_view rows, size_t) { g_shards->write(rows); }, g_shardRows, g_shardBytes - CsvWriter::CSV_HEADER.size());
     }
 
-    transformFail2BanInput(f2bOutput);
-    try {
-        entries = json::parse(f2bOutput);
-    } catch (const exception& ex) {
-        cerr << "Failed to parse JSON! Invalid format?" << endl
-             << "Error description: " << ex.what() << endl;
-        rval = false;
-        goto Exit;
+    if (g_output != nullptr) {
+        return CsvWriter([](string_view rows, size_t) { g_output->write(rows); }, std::numeric_limits<size_t>::max(), CsvWriter::DEFAULT_BUFFER_SIZE);
     }
 
-    rval = outputCsv(entries);
+    CsvWriter csvWriter(STDOUT_FILENO);
+    if (!g_csvHeaderWritten) {
+        csvWriter.writeHeader();
+        g_csvHeaderWritten = true;
+    }
 
-    Exit:
-    return rval;
+    return csvWriter;
 }
 
 /**
- * @brief Outputs the CSV-encoded data to the terminal.
+ * @brief Formats a point in time as expected by abuseipdb.
  * 
- * @param entries A @see nlohmann::json object containing the f2b entries
+ * @param timePoint The point in time to format.
  * 
- * @return true If CSV could be generated and printed.
- * @return false Otherwise
+ * @return string The formatted time (local time, ISO 8601 with UTC offset).
  */
-bool outputCsv(const json& entries) {
-    bool rval = true;
-
-    const time_t timeNow = time(nullptr);
+string getTimeString(time_t timePoint) {
     struct tm tStruct{0};
-    localtime_r(&timeNow, &tStruct);
-    string timeString(256, 0);
-    strftime(&timeString[0], timeString.size(), "%F %T%z", &tStruct);
-    timeString.shrink_to_fit();
+    localtime_r(&timePoint, &tStruct);
+    string timeString(64, 0);
+    timeString.resize(strftime(&timeString[0], timeString.size(), "%F %T%z", &tStruct));
 
-    vector<string> csvLines{
-        "IP,Categories,ReportDate,Comment"
-    };
-
-    // I'm expecting an array of strings (complete jail output) or an array of string (specific fail output)
-    if (!entries.is_array()) {
-        cerr << "Invalid input. Expected array, got " << entries.type_name() << endl;
-        rval = false;
-        goto Exit;
-    }
-
-    {
-        const auto newLines = getLinesFromJson(entries, timeString);
-        csvLines.insert(csvLines.end(), newLines.begin(), newLines.end());
-    }
+    return timeString;
+}
 
-    for (const auto& line : csvLines) {
-        cout << line << endl;
-    }
+/**
+ * @brief Formats the timestamp of a fail2ban log line as expected by abuseipdb.
+ * 
+ * @param timestamp The timestamp ("YYYY-MM-DD HH:MM:SS,mmm", local time).
+ * 
+ * @return string The formatted time, or @see UNKNOWN_VALUE if the timestamp can't be read.
+ */
+string getBanTimeString(string_view timestamp) {
+    const string text(timestamp.substr(0, timestamp.find(',')));
+    struct tm tStruct{0};
+    const auto* end = strptime(text.c_str(), "%Y-%m-%d %H:%M:%S", &tStruct);
+    if (end == nullptr || *end != '\0') { return string(UNKNOWN_VALUE); }
 
-    Exit:
-    return rval;
+    tStruct.tm_isdst = -1;
+    return getTimeString(mktime(&tStruct));
 }
 
 /**
- * @brief Gets all the lines (reported IPs) from the JSON resulting from fail2ban
- * 
- * @param entries The JSON to parse
- * @param timeString The current time
- * 
- * @return svec_t A vector of strings containing the IPs
- */
-svec_t getLinesFromJson(const json& entries, const string& timeString) {
-    vector<string> lines;
-    string currentIp{};
-    for (const auto& entry : entries) {
-        // This should probably be split up,
-        // but right now I can't be bothered.
-        // As long as it works, I'm fine with it, I guess.
-        // For now at least
-        if (!entry.is_object() && entry.is_string()) {
-            currentIp = entry.get<string>();
-
-            if (alreadyReported(currentIp)) { continue; }
-
-            // Specific jail output
-            // We don't need to look anything up, just grab default cats and append to list
-            lines.push_back(format(
-                R"({0:s},"{1:s}",{2:s},"{3:s}")",
-                currentIp,
-                getCategoriesForJail(),
-                timeString,
-                format(g_reportComment, g_jailName.empty() ? "UNKNOWN" : g_jailName)
-            ));
-        } else if (entry.is_object()) {
-            const auto& obj = entry.get<json::object_t>();
-            g_jailName = obj.begin()->first;
-            const auto newLines = getLinesFromJson(*entry.begin(), timeString);
-            lines.insert(lines.end(), newLines.begin(), newLines.end());
-        }
+ * @brief Extracts the jail list from the answer to fail2ban's status command and filters it by --jails and --skip-jails.
+ * 
+ * @remarks fail2ban-client prints the list as "`- Jail list:\tsshd, nginx", the socket answers with
+ * "('Jail list', 'sshd, nginx')"; both are understood.
+ * 
+ * @param status The answer to the status command.
+ * 
+ * @return vector<string> The selected jails, in the order fail2ban lists them.
+ */
+vector<string> getSelectedJails(string_view status) {
+    constexpr string_view JAIL_LIST_LABEL = "Jail list";
+    const auto labelPos = status.find(JAIL_LIST_LABEL);
+    if (labelPos == string_view::npos) { throw std::runtime_error("fail2ban's status contains no jail list"); }
+
+    auto jailList = status.substr(labelPos + JAIL_LIST_LABEL.size());
+    jailList.remove_prefix(std::min(jailList.find_first_not_of(":', \t"), jailList.size()));
+    jailList = jailList.substr(0, jailList.find_first_of("'\n)"));
+
+    vector<string> jails;
+    std::set<string_view, std::less<>> runningJails;
+    for (auto jail : StringSplit(jailList, ',')) {
+        jail.remove_prefix(std::min(jail.find_first_not_of(' '), jail.size()));
+        jail = jail.substr(0, jail.find_last_not_of(' ') + 1);
+        if (jail.empty()) { continue; }
+
+        runningJails.insert(jail);
+        if (isJailSelected(jail)) { jails.emplace_back(jail); }
+    }
+
+    for (const auto& jail : g_includedJails) {
+        if (runningJails.count(jail) == 0) { cerr << "Warning: jail " << jail << " isn't running; skipping." << endl; }
     }
-    return lines;
+
+    return jails;
 }
 
 /**
  * @brief Gets the categories set for a given jail
  * 
- * @return string A comma-separated string containing the abuseipdb categories.
+ * @param jail The name of the jail
+ * 
+ * @return string_view A comma-separated string containing the abuseipdb categories.
  * 
  * @remarks Categories are listed [https://www.abuseipdb.com/categories](here)
  */
-string getCategoriesForJail() {
-    string categories{};
-    for (size_t i = 0; i < g_defaultCategories.size(); i++) {
-        if (i > 0) {
-            categories.push_back(',');
-        }
-
-        categories.append(std::to_string(g_defaultCategories[i]));
-    }
-
-    const auto posInMap = std::find_if(g_categoryLookup.begin(), g_categoryLookup.end(), [](const auto x) {
-        return x.first == g_jailName;
-    });
-
-    if (posInMap != g_categoryLookup.end() && posInMap->second != -1) {
-        categories.append(format(",{0:d}", posInMap->second));
-    }
-
-    return categories;
+string_view getCategoriesForJail(string_view jail) {
+    return g_categoryTable.categoriesFor(jail);
 }
 
 // other impl
@@ -415,7 +1762,7 @@ bool parseArgs(int32_t argc, char** argv) {
     bool rVal = true;
 
     int32_t curIdx = 0;
-    char optVal = 0;
+    int32_t optVal = 0;
 
     if (argc == 1) {
         goto UglyHelp;
@@ -463,43 +1810,246 @@ bool parseArgs(int32_t argc, char** argv) {
                 }
                 g_fail2banExe = optarg;
                 break;
+            case 'C':
+                g_useCache = true;
+                if (optarg != nullptr) { g_cacheFile = optarg; }
+                break;
+            case OPT_CACHE_TTL:
+                try {
+                    g_cacheTtl = std::stol(optarg);
+                } catch (const exception&) {
+                    cerr << "Error: invalid cache TTL " << optarg << "!" << endl;
+                    rVal = false;
+                    goto Exit;
+                }
+                break;
+            case OPT_CACHE_BLOOM:
+                g_useCacheBloomFilter = true;
+                break;
+            case OPT_COMPACT_CACHE:
+                g_compactCache = true;
+                break;
+            case 'x':
+                if (optarg == nullptr) {
+                    cerr << "Error: missing required argument for exclusion list!" << endl;
+                    break;
+                }
+                g_excludeFile = optarg;
+                break;
+            case OPT_COMPILE_EXCLUDE:
+                g_excludeImageFile = optarg;
+                break;
+            case OPT_CATEGORY_FILE:
+                g_categoryFile = optarg;
+                break;
+            case '%':
+                g_callF2b = true;
+                break;
+            case 'w':
+                g_watchLogFile = optarg == nullptr ? "/var/log/fail2ban.log" : optarg;
+                break;
+            case OPT_UPLOAD:
+                g_uploadUrl = optarg == nullptr ? BulkUploader::DEFAULT_URL : optarg;
+                break;
+            case OPT_API_KEY:
+                g_apiKey = optarg;
+                break;
+            case OPT_THREADS:
+                try {
+                    g_threadCount = std::max<size_t>(1, std::stoul(optarg));
+                } catch (const exception&) {
+                    cerr << "Error: invalid amount of threads " << optarg << "!" << endl;
+                    rVal = false;
+                    goto Exit;
+                }
+                break;
+            case OPT_MAX_REQUESTS:
+                try {
+                    g_maxRequests = std::stoul(optarg);
+                } catch (const exception&) {
+                    cerr << "Error: invalid amount of requests " << optarg << "!" << endl;
+                    rVal = false;
+                    goto Exit;
+                }
+                break;
+            case OPT_SHARD_DIR:
+                g_shardDir = optarg;
+                break;
+            case OPT_SHARD_ROWS:
+                try {
+                    g_shardRows = std::stoul(optarg);
+                    if (g_shardRows == 0) { throw std::out_of_range("no rows"); }
+                } catch (const exception&) {
+                    cerr << "Error: invalid amount of rows per shard " << optarg << "!" << endl;
+                    rVal = false;
+                    goto Exit;
+                }
+                break;
+            case OPT_SHARD_BYTES:
+                try {
+                    g_shardBytes = std::stoul(optarg);
+                    if (g_shardBytes <= CsvWriter::CSV_HEADER.size() || g_shardBytes > ShardWriter::MAX_SHARD_SIZE) { throw std::out_of_range("shard size"); }
+                } catch (const exception&) {
+                    cerr << "Error: invalid shard size " << optarg << " (must exceed the " << CsvWriter::CSV_HEADER.size()
+                         << "-byte header and be at most " << ShardWriter::MAX_SHARD_SIZE << " bytes)!" << endl;
+                    rVal = false;
+                    goto Exit;
+                }
+                break;
+            case OPT_F2B_SOCKET:
+                g_fail2banSocket = optarg;
+                break;
+            case OPT_SINCE_SNAPSHOT:
+                g_snapshotFile = optarg;
+                break;
+            case OPT_NO_DEDUPE:
+                g_deduplicate = false;
+                break;
+            case 'o':
+                g_outputFile = optarg;
+                break;
+            case OPT_COMPRESS:
+                g_outputCompression = optarg;
+                break;
+            case OPT_F2B_DB:
+                g_f2bDatabaseFile = optarg == nullptr ? string(Fail2BanDatabase::DEFAULT_DATABASE_PATH) : optarg;
+                break;
+            case OPT_DB_CHECKPOINT:
+                g_dbCheckpointFile = optarg;
+                break;
+            case OPT_AGGREGATE:
+                g_aggregateInputs.emplace_back(optarg);
+                break;
+            case OPT_JAILS:
+            case OPT_SKIP_JAILS:
+                for (const auto jail : StringSplit(optarg, ',')) {
+                    if (!jail.empty()) { (optVal == OPT_JAILS ? g_includedJails : g_skippedJails).emplace(jail); }
+                }
+                break;
+            case OPT_FROM_LOG:
+                g_logPatterns.emplace_back(optarg == nullptr ? LogScanner::DEFAULT_LOG_PATTERN : optarg);
+                break;
+            case OPT_SINCE:
+            case OPT_UNTIL:
+                if (!parseTimeArg(optarg, optVal == OPT_SINCE ? g_logSince : g_logUntil)) {
+                    cerr << "Error: invalid point in time " << optarg << "!" << endl;
+                    rVal = false;
+                    goto Exit;
+                }
+                break;
+            case OPT_STATS:
+                if (g_stats == nullptr) { g_stats = std::make_unique<RunStats>(); }
+                break;
+            case OPT_QUEUE:
+                g_queueFile = optarg;
+                break;
+            case OPT_DAILY_QUOTA:
+                try {
+                    g_dailyQuota = static_cast<uint32_t>(std::stoul(optarg));
+                } catch (const exception&) {
+                    cerr << "Error: invalid daily quota " << optarg << "!" << endl;
+                    rVal = false;
+                    goto Exit;
+                }
+                break;
+            case OPT_POLL_INTERVAL:
+                try {
+                    g_pollIntervalMs = static_cast<uint32_t>(std::stoul(optarg));
+                } catch (const exception&) {
+                    cerr << "Error: invalid poll interval " << optarg << "!" << endl;
+                    rVal = false;
+                    goto Exit;
+                }
+                break;
         }
     }
 
+    if (rVal && !g_excludeImageFile.empty() && g_excludeFile.empty()) {
+        cerr << "Error: --compile-exclude requires --exclude-file!" << endl;
+        rVal = false;
+    }
+
+    if (rVal && !g_outputCompression.empty() && g_outputFile.empty()) {
+        cerr << "Error: --compress requires --output!" << endl;
+        rVal = false;
+    }
+
+    if (rVal && !g_shardDir.empty() && (!g_outputFile.empty() || !g_uploadUrl.empty())) {
+        cerr << "Error: --shard-dir can't be combined with --output or --upload!" << endl;
+        rVal = false;
+    }
+
+    if (rVal && (g_shardRows != BulkUploader::MAX_BATCH_LINES - 1 || g_shardBytes != BulkUploader::MAX_BATCH_BYTES) && g_shardDir.empty()) {
+        cerr << "Error: --shard-rows and --shard-bytes require --shard-dir!" << endl;
+        rVal = false;
+    }
+
+    if (rVal && !g_dbCheckpointFile.empty() && g_f2bDatabaseFile.empty()) {
+        cerr << "Error: --db-checkpoint requires --f2b-db!" << endl;
+        rVal = false;
+    }
+
+    if (rVal && (g_logSince != std::numeric_limits<int64_t>::min() || g_logUntil != std::numeric_limits<int64_t>::max()) && g_logPatterns.empty()) {
+        cerr << "Error: --since and --until require --from-log!" << endl;
+        rVal = false;
+    }
+
+    if (rVal && (!g_f2bDatabaseFile.empty() + !g_logPatterns.empty() + !g_aggregateInputs.empty()) > 1) {
+        cerr << "Error: only one of --f2b-db, --from-log and --aggregate may be used!" << endl;
+        rVal = false;
+    }
+
+    if (rVal && g_dailyQuota != ReportScheduler::DEFAULT_DAILY_QUOTA && g_queueFile.empty()) {
+        cerr << "Error: --daily-quota requires --queue!" << endl;
+        rVal = false;
+    }
+
+    if (rVal && !g_snapshotFile.empty() && !g_deduplicate) {
+        cerr << "Error: --since-snapshot can't be combined with --no-dedupe!" << endl;
+        rVal = false;
+    }
+
     Exit:
     return rVal;
 }
 
 /**
- * @brief Executes a command on the current system and returns both output and exit code.
+ * @brief Parses a point in time passed on the command-line: a UNIX time, a local date ("YYYY-MM-DD", optionally
+ * followed by " HH:MM[:SS]") or a duration before the start of the run ("90s", "30m", "12h", "7d").
  * 
- * @param cmd The command to execute.
- * @param returnCode The return code of the executed command.
+ * @param text The text to parse.
+ * @param out The point in time (UNIX time).
  * 
- * @return string The output of the executed command.
+ * @return true If the text is a valid point in time.
+ * @return false Otherwise.
  */
-string exec(const string& cmd, int32_t& returnCode) {
-    string commandOutput;
-
-    FILE* pipe = popen(cmd.c_str(), "r");
-
-    if (!pipe) {
-        // you'd have to throw a system_error or something here; or just remove the exception
-        throw system_error(error_code(errno, std::generic_category()), "Failed to start process!");
+bool parseTimeArg(const string& text, int64_t& out) {
+    char* end = nullptr;
+    errno = 0;
+    const int64_t value = std::strtoll(text.c_str(), &end, 10);
+    if (end != text.c_str() && errno == 0 && value >= 0) {
+        const string_view suffix(end);
+        const int64_t unit = suffix == "s" ? 1 : suffix == "m" ? 60 : suffix == "h" ? 60 * 60 : suffix == "d" ? 24 * 60 * 60 : 0;
+        if (suffix.empty()) {
+            out = value;
+            return true;
+        } else if (unit != 0 && value <= g_runTime / unit) {
+            out = g_runTime - value * unit;
+            return true;
+        }
     }
 
-    try {
-        char outputBuffer[512] = {0};
-        while (!feof(pipe) && fgets(outputBuffer, sizeof(outputBuffer) / sizeof(outputBuffer[0]), pipe) != NULL) {
-            commandOutput += outputBuffer;
-        }
-    } catch (...) {
-        returnCode = pclose(pipe);
-        throw;
+    for (const auto* format : { "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%d" }) {
+        struct tm tStruct{0};
+        const auto* formatEnd = strptime(text.c_str(), format, &tStruct);
+        if (formatEnd == nullptr || *formatEnd != '\0') { continue; }
+
+        tStruct.tm_isdst = -1;
+        out = mktime(&tStruct);
+        return true;
     }
 
-    returnCode = pclose(pipe);
-    return commandOutput;
+    return false;
 }
 
 /**
@@ -515,20 +2065,60 @@ void printHelpText(const string& binName) {
             {0} -f[/path/to/file] # Use [file] to parse fail2ban jail contents
             {0} -% # to attempt to get output directly from fail2ban (requires elevated privileges!)
             {0} --stdin # to read input from stdin
+            {0} --f2b-db[=/path/to/db] # to read the bans from fail2ban's database
+            {0} --from-log[=/var/log/fail2ban.log*] --since=7d # to read past bans from fail2ban's (rotated) logs
+            {0} --aggregate=/path/to/exports/ # to merge the ban lists of many hosts into one report
 
         Arguments:
             --help, -h              Prints this text and exits
             --stdin, -s             Reads input from stdin
-            --file=, -f[file]       Reads input from [file] or fail2ban.json if optarg is empty
+            --file=, -f[file]       Reads input from [file] or fail2ban.json if optarg is empty (may be gzip- or zstd-compressed)
             --version, -v           Prints the version information and exits
             --comment, -c[text]     Sets the value for the comment field. Variables are available below
             --jail-name, -j[jail]   Sets the name of the jail (useful if exporting specific jails from fail2ban)
             --f2b, -e[f2b-client]   Sets the location of the fail2ban-client executable (local system will not be searched)
             --call-f2b, -%          No, that's not a typo. Calls fail2ban directly. !! WARNING: REQUIRES ELEVATED PRIVILEGES. NOT RECOMMENDED !!
+            --cache=, -C[file]      Skips IPs reported within the cache TTL and records reported IPs in [file] (default: {2})
+            --cache-ttl=<seconds>   Sets the time after which a cached IP may be reported again (default: {3})
+            --cache-bloom           Builds an in-memory Bloom filter to speed up cache lookups for large caches
+            --compact-cache         Removes expired entries from the cache after the run
+            --exclude-file=, -x<f>  Never reports IPs in any of the CIDR ranges listed in <f> (one per line, or a compiled image)
+            --compile-exclude=<f>   Compiles the list passed to --exclude-file to the binary image <f> and exits
+            --category-file=<f>     Overrides the default and per-jail categories with the ones listed in <f> ("<jail> = <cat>,<cat>")
+            --watch=, -w[log]       Keeps running and outputs IPs as they are banned in [log] (default: /var/log/fail2ban.log)
+            --threads=<n>           The amount of threads rendering the CSV rows (default: one per core)
+            --upload[=url]          Uploads the reports to abuseipdb's bulk-report API instead of printing them (or to [url])
+            --api-key=<key>         The abuseipdb API key used for uploading (default: $ABUSEIPDB_API_KEY)
+            --max-requests=<n>      The maximum amount of concurrent upload requests (default: 4)
+            --f2b-socket=<f>        Sets the path to fail2ban's control socket used by -% (default: /var/run/fail2ban/fail2ban.sock)
+            --poll-interval=<ms>    Polls the log every <ms> milliseconds instead of using inotify (watch mode)
+            --no-dedupe             Reports IPs banned in several jails once per jail instead of once with all jails' categories
+            --since-snapshot=<f>    Only outputs IPs which weren't banned at the end of the previous run, as recorded in <f>
+            --f2b-db[=db]           Reads the active bans from fail2ban's database [db] (default: /var/lib/fail2ban/fail2ban.sqlite3)
+            --db-checkpoint=<f>     Reads the bans since the previous run (recorded in <f>) from the database instead
+            --output=, -o<f>        Writes the CSV to <f> instead of stdout (also when uploading, as an archive); compressed if <f> ends in .gz or .zst
+            --compress=<c>          Sets the compression of the output file: none, gzip or zstd (default: by extension)
+            --from-log[=pattern]    Reads every ban from the logs matching [pattern], including rotated and compressed ones (default: /var/log/fail2ban.log*; may be repeated)
+            --since=<time>          Only reads bans from the logs at or after <time> (UNIX time, "YYYY-MM-DD[ HH:MM[:SS]]" or a duration ago: 30m, 12h, 7d)
+            --until=<time>          Only reads bans from the logs before <time> (same formats as --since)
+            --aggregate=<path>      Merges the ban lists of many hosts (one file per host, like -f; or a directory of them) into one report (may be repeated)
+            --queue=<f>             Queues the reports in <f> and only sends them as abuseipdb's limits allow (15 minutes per IP, the daily quota)
+            --daily-quota=<n>       The maximum amount of queued reports sent per day (UTC; default: {4}; 0 for no limit)
+            --shard-dir=<dir>       Writes the CSV to <dir> in shards of bounded size, each with a header; shards appear once complete
+            --shard-rows=<n>        The maximum amount of rows per shard, excluding the header (default: {5})
+            --shard-bytes=<n>       The maximum size of a shard in bytes, including the header (default: {6}; at most 1GiB)
+            --jails=<j1,j2,...>     Only reports the bans of the listed jails (may be repeated; -% only queries these jails)
+            --skip-jails=<j1,...>   Never reports the bans of the listed jails (may be repeated; -% doesn't query them)
+            --stats                 Prints per-stage timings, memory usage and per-jail counters as JSON to stderr when done
 
         Comment variables:
-            {{0}}                   Jail name
+            {{0}}                   Jail name (all jails the IP is banned in, comma-separated)
             {{1}}                   Report time
+            {{2}}                   Ban time (watch mode, --f2b-db and --from-log only; "unknown" otherwise)
+            {{3}}                   Failure count (--f2b-db only; "unknown" otherwise)
+            {{4}}                   Hostname
+            {{5}}                   Amount of hosts which banned the IP (--aggregate only; "unknown" otherwise)
+            Variables accept a format spec ({{0:>12}}); use {{{{ and }}}} for literal braces.
 
         Exit codes:
             0                       Success
@@ -537,9 +2127,22 @@ void printHelpText(const string& binName) {
             3                       Failed to parse input from fail2ban exec
             4                       Insufficent execution rights
             5                       Could not find fail2ban-client
+            6                       Failed to open the cache file
+            7                       Failed to load the exclusion list
+            8                       Failed to load the category overrides
+            9                       Failed to watch fail2ban's log
+            10                      Failed to upload the reports
+            11                      Failed to read or write the snapshot
+            12                      Invalid comment
+            13                      Failed to read fail2ban's database (or the checkpoint)
+            14                      Failed to write the output file
+            15                      Failed to read fail2ban's logs
+            16                      Failed to read or write the report queue
+            17                      Failed to write the shards
     )";
 
-    cout << format(RAW, binName, getProjectVersion()) << endl;
+    cout << format(RAW, binName, getProjectVersion(), g_cacheFile, g_cacheTtl, ReportScheduler::DEFAULT_DAILY_QUOTA,
+                  BulkUploader::MAX_BATCH_LINES - 1, BulkUploader::MAX_BATCH_BYTES) << endl;
 }
 
 /**
@@ -547,7 +2150,7 @@ void printHelpText(const string& binName) {
  * 
  * @return constexpr string_view The arg string.
  */
-constexpr string_view getShortArgs() { return "hsf:vc:j:e:%"; }
+constexpr string_view getShortArgs() { return "hsf:vc:j:e:%C::x:w::o:"; }
 
 /**
  * @brief Gets the array of options required for getopt_long.
@@ -564,6 +2167,38 @@ const option* getOptions() {
         { "jail-name",  required_argument,  nullptr,    'j' },
         { "f2b",        required_argument,  nullptr,    'e' },
         { "call-f2b",   no_argument,        nullptr,    '%' },
+        { "cache",      optional_argument,  nullptr,    'C' },
+        { "cache-ttl",  required_argument,  nullptr,    OPT_CACHE_TTL },
+        { "cache-bloom", no_argument,       nullptr,    OPT_CACHE_BLOOM },
+        { "compact-cache", no_argument,     nullptr,    OPT_COMPACT_CACHE },
+        { "exclude-file", required_argument, nullptr,   'x' },
+        { "compile-exclude", required_argument, nullptr, OPT_COMPILE_EXCLUDE },
+        { "category-file", required_argument, nullptr,  OPT_CATEGORY_FILE },
+        { "watch",      optional_argument,  nullptr,    'w' },
+        { "poll-interval", required_argument, nullptr,  OPT_POLL_INTERVAL },
+        { "f2b-socket", required_argument,  nullptr,    OPT_F2B_SOCKET },
+        { "upload",     optional_argument,  nullptr,    OPT_UPLOAD },
+        { "threads",    required_argument,  nullptr,    OPT_THREADS },
+        { "api-key",    required_argument,  nullptr,    OPT_API_KEY },
+        { "max-requests", required_argument, nullptr,   OPT_MAX_REQUESTS },
+        { "stats",      no_argument,        nullptr,    OPT_STATS },
+        { "no-dedupe",  no_argument,        nullptr,    OPT_NO_DEDUPE },
+        { "since-snapshot", required_argument, nullptr, OPT_SINCE_SNAPSHOT },
+        { "f2b-db",     optional_argument,  nullptr,    OPT_F2B_DB },
+        { "output",     required_argument,  nullptr,    'o' },
+        { "compress",   required_argument,  nullptr,    OPT_COMPRESS },
+        { "db-checkpoint", required_argument, nullptr,  OPT_DB_CHECKPOINT },
+        { "from-log",   optional_argument,  nullptr,    OPT_FROM_LOG },
+        { "since",      required_argument,  nullptr,    OPT_SINCE },
+        { "until",      required_argument,  nullptr,    OPT_UNTIL },
+        { "aggregate",  required_argument,  nullptr,    OPT_AGGREGATE },
+        { "queue",      required_argument,  nullptr,    OPT_QUEUE },
+        { "daily-quota", required_argument, nullptr,    OPT_DAILY_QUOTA },
+        { "jails",      required_argument,  nullptr,    OPT_JAILS },
+        { "shard-dir",  required_argument,  nullptr,    OPT_SHARD_DIR },
+        { "shard-rows", required_argument,  nullptr,    OPT_SHARD_ROWS },
+        { "shard-bytes", required_argument, nullptr,    OPT_SHARD_BYTES },
+        { "skip-jails", required_argument,  nullptr,    OPT_SKIP_JAILS },
         { nullptr,      no_argument,        nullptr,     0  }
     };
 
@@ -571,28 +2206,61 @@ const option* getOptions() {
 }
 
 /**
- * @brief Transforms fail2ban's output to a valid JSON.
+ * @brief Records that an IP's row was written: caches the IP straight away or, when uploading, remembers it until its
+ * batch was submitted.
+ * 
+ * @remarks Must be called before the row is written, as writing it may submit the batch it ends up in.
+ * 
+ * @param ip The IP whose row is written.
+ */
+void recordReport(const IpAddress& ip) {
+    if (g_uploader == nullptr) {
+        if (g_reportCache != nullptr) { cacheReportedIp(ip); }
+        return;
+    }
+
+    // an upload may still fail, so the IP is only cached once abuseipdb accepted its batch (see cacheOnAcceptance())
+    g_unsubmittedIps.push_back(ip);
+    if (g_reportCache != nullptr) { g_uploadedIps.insert(ip); }
+}
+
+/**
+ * @brief Takes the IPs of the next rowCount rows written for upload (see @see recordReport()) and returns a callback
+ * which caches them if their batch was accepted, and stops skipping them as pending either way.
+ * 
+ * @param rowCount The amount of rows in the batch.
  * 
- * @param input Raw fail2ban ouput.
+ * @return BulkUploader::CompletionCallback The callback to pass along with the batch.
  */
-void transformFail2BanInput(string& input) {
-    string output{};
-    transform(input.begin(), input.end(), std::back_inserter(output), [&](const char c) {
-        if (c == '\'') { return '"'; }
-        return c;
-    });
+BulkUploader::CompletionCallback cacheOnAcceptance(size_t rowCount) {
+    vector<IpAddress> addresses;
+    addresses.reserve(rowCount);
+    for (; rowCount > 0 && !g_unsubmittedIps.empty(); rowCount--) {
+        addresses.push_back(g_unsubmittedIps.front());
+        g_unsubmittedIps.pop_front();
+    }
 
-    input = output;
+    return [addresses = std::move(addresses)](bool isAccepted) {
+        for (const auto& address : addresses) {
+            if (isAccepted && g_reportCache != nullptr) { cacheReportedIp(address); }
+            // settled either way: accepted IPs are covered by the cache (and its TTL), rejected ones may be reported again
+            g_uploadedIps.erase(address);
+        }
+    };
 }
 
 /**
- * @brief [[Unused / Reserved for future use]] Caches a recently reported IP.
+ * @brief Caches a recently reported IP.
  * 
  * @param ip The IP to cache.
  */
-void cacheReportedIp(const string& ip) {
-    ofstream cacheOutput(g_cacheFile, std::ios_base::openmode::_S_app);
-    cacheOutput << ip << ":" << time(nullptr) << endl;
-    cacheOutput.close();
+void cacheReportedIp(const IpAddress& ip) {
+    try {
+        g_reportCache->markReported(ip, g_runTime);
+    } catch (const exception& ex) {
+        // losing the cache must not lose the report
+        cerr << "Failed to update cache " << g_cacheFile << "; caching disabled for this run!" << endl
+             << "Error description: " << ex.what() << endl;
+        g_reportCache.reset();
+    }
 }
-
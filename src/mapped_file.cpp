@@ -0,0 +1,91 @@
+/**
+ * @file mapped_file.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the read-only, memory-mapped file.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.hpp"
+
+using std::error_code;
+using std::system_error;
+
+MappedFile::MappedFile(const string& path) {
+    const int32_t fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw system_error(error_code(errno, std::generic_category()), "Failed to open " + path);
+    }
+
+    try {
+        mapFd(fd);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+}
+
+MappedFile::MappedFile(int32_t fd) { mapFd(fd); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept:
+m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) { }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile() { unmap(); }
+
+bool MappedFile::isMappable(int32_t fd) {
+    struct stat fileStat{};
+    return fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode);
+}
+
+void MappedFile::mapFd(int32_t fd) {
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0) {
+        throw system_error(error_code(errno, std::generic_category()), "Failed to stat file");
+    }
+
+    m_size = static_cast<size_t>(fileStat.st_size);
+    if (m_size == 0) { return; } // mmap(2) refuses zero-length mappings; an empty view is just as good
+
+    m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m_data == MAP_FAILED) {
+        m_data = nullptr;
+        m_size = 0;
+        throw system_error(error_code(errno, std::generic_category()), "Failed to map file");
+    }
+
+    // purely advisory; failure is not an error
+    madvise(m_data, m_size, MADV_SEQUENTIAL);
+    madvise(m_data, m_size, MADV_WILLNEED);
+}
+
+void MappedFile::unmap() {
+    if (m_data != nullptr) {
+        munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
@@ -0,0 +1,330 @@
+/**
+ * @file report_cache.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the persistent, memory-mapped cache of reported IPs.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "report_cache.hpp"
+
+using std::error_code;
+using std::runtime_error;
+using std::system_error;
+
+static constexpr char       CACHE_MAGIC[8] = { 'F', '2', 'A', 'B', 'C', 'A', 'C', 'H' }; //!< Identifies a cache file
+static constexpr uint32_t   CACHE_VERSION = 1; //!< The current version of the on-disk format
+static constexpr uint32_t   BLOOM_HASHES = 7; //!< The amount of hash functions used by the Bloom filter
+static constexpr uint64_t   BLOOM_BITS_PER_SLOT = 10; //!< The size of the Bloom filter per slot of the table
+
+/**
+ * @brief The header at the start of every cache file.
+ */
+struct ReportCache::Header {
+    char        magic[8]; //!< @see CACHE_MAGIC
+    uint32_t    version; //!< @see CACHE_VERSION
+    uint32_t    slotSize; //!< sizeof(Slot), guards against incompatible builds
+    uint64_t    capacity; //!< The amount of slots; always a power of two
+    uint64_t    count; //!< The amount of occupied slots
+    uint8_t     reserved[32]; //!< Pads the header to 64 bytes
+};
+
+/**
+ * @brief A single slot of the table. A slot with a last-reported time of zero is empty.
+ */
+struct ReportCache::Slot {
+    uint8_t     key[16]; //!< The packed address
+    int64_t     lastReported; //!< The time the address was last reported
+};
+
+static_assert(sizeof(ReportCache::Header) == 64, "Cache header must be 64 bytes");
+
+static error_code lastError() { return error_code(errno, std::generic_category()); }
+
+static uint64_t nextPowerOfTwo(uint64_t value) {
+    uint64_t result = 1;
+    while (result < value) { result <<= 1; }
+    return result;
+}
+
+static size_t fileSizeForCapacity(uint64_t capacity) { return sizeof(ReportCache::Header) + capacity * sizeof(ReportCache::Slot); }
+
+ReportCache::ReportCache(const string& path, time_t ttl, bool useBloomFilter):
+m_path(path), m_ttl(ttl), m_useBloomFilter(useBloomFilter) {
+    openAndLock();
+
+    try {
+        mapFile();
+    } catch (...) {
+        close(m_fd);
+        throw;
+    }
+
+    if (m_useBloomFilter) { buildBloomFilter(); }
+}
+
+ReportCache::~ReportCache() {
+    unmapFile();
+    if (m_fd >= 0) { close(m_fd); } // also releases the lock
+}
+
+bool ReportCache::contains(const IpAddress& address, time_t now) const {
+    const auto hash = address.hash();
+    if (m_useBloomFilter && !mayContain(hash)) { return false; }
+
+    const auto mask = capacity() - 1;
+    const auto* table = slots();
+    for (auto i = hash & mask;; i = (i + 1) & mask) {
+        const auto& slot = table[i];
+        if (slot.lastReported == 0) {
+            return false;
+        } else if (std::memcmp(slot.key, address.bytes.data(), sizeof(slot.key)) == 0) {
+            return !isExpired(slot.lastReported, now);
+        }
+    }
+}
+
+void ReportCache::markReported(const IpAddress& address, time_t now) {
+    auto* header = static_cast<Header*>(m_mapping);
+    if (static_cast<double>(header->count + 1) > static_cast<double>(header->capacity) * MAX_LOAD_FACTOR) {
+        rebuild(header->capacity * 2, now);
+        header = static_cast<Header*>(m_mapping);
+    }
+
+    const auto hash = address.hash();
+    const auto mask = header->capacity - 1;
+    auto* table = slots();
+    Slot* target = nullptr;
+
+    for (auto i = hash & mask;; i = (i + 1) & mask) {
+        auto& slot = table[i];
+        if (slot.lastReported == 0) {
+            if (target == nullptr) {
+                target = &slot;
+                header->count++;
+            }
+            break;
+        } else if (std::memcmp(slot.key, address.bytes.data(), sizeof(slot.key)) == 0) {
+            slot.lastReported = now;
+            return;
+        } else if (target == nullptr && isExpired(slot.lastReported, now)) {
+            // reuse the first expired slot, but keep probing in case the address is further along the chain
+            target = &slot;
+        }
+    }
+
+    // the key is written before the timestamp, so an interrupted update never yields a valid entry for the wrong key
+    std::memcpy(target->key, address.bytes.data(), sizeof(target->key));
+    target->lastReported = now;
+
+    if (m_useBloomFilter) { addToBloomFilter(hash); }
+}
+
+void ReportCache::compact(time_t now) {
+    uint64_t liveEntries = 0;
+    const auto* table = slots();
+    for (uint64_t i = 0; i < capacity(); i++) {
+        if (table[i].lastReported != 0 && !isExpired(table[i].lastReported, now)) { liveEntries++; }
+    }
+
+    // leave the compacted table half empty, so it doesn't have to grow again straight away
+    rebuild(std::max(MIN_CAPACITY, nextPowerOfTwo(liveEntries * 2)), now);
+}
+
+void ReportCache::sync() {
+    if (m_mapping != nullptr) { msync(m_mapping, m_mappingSize, MS_SYNC); }
+}
+
+uint64_t ReportCache::size() const { return static_cast<const Header*>(m_mapping)->count; }
+
+uint64_t ReportCache::capacity() const { return static_cast<const Header*>(m_mapping)->capacity; }
+
+/**
+ * @brief Opens the cache file and acquires an exclusive lock on it.
+ *
+ * @remarks If another process replaced the file (compaction) while we were waiting for the lock, the new file is opened instead.
+ */
+void ReportCache::openAndLock() {
+    for (;;) {
+        m_fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (m_fd < 0) { throw system_error(lastError(), "Failed to open cache file " + m_path); }
+
+        if (flock(m_fd, LOCK_EX) != 0) {
+            const auto error = lastError();
+            close(m_fd);
+            throw system_error(error, "Failed to lock cache file " + m_path);
+        }
+
+        struct stat lockedStat{}, pathStat{};
+        if (fstat(m_fd, &lockedStat) == 0 && stat(m_path.c_str(), &pathStat) == 0 &&
+            lockedStat.st_dev == pathStat.st_dev && lockedStat.st_ino == pathStat.st_ino) {
+            return;
+        }
+
+        close(m_fd);
+    }
+}
+
+/**
+ * @brief Maps the (locked) cache file, initialising it if it's empty.
+ */
+void ReportCache::mapFile() {
+    struct stat fileStat{};
+    if (fstat(m_fd, &fileStat) != 0) { throw system_error(lastError(), "Failed to stat cache file " + m_path); }
+
+    const bool isNew = fileStat.st_size == 0;
+    if (isNew) {
+        if (ftruncate(m_fd, static_cast<off_t>(fileSizeForCapacity(MIN_CAPACITY))) != 0) {
+            throw system_error(lastError(), "Failed to resize cache file " + m_path);
+        }
+        m_mappingSize = fileSizeForCapacity(MIN_CAPACITY);
+    } else {
+        m_mappingSize = static_cast<size_t>(fileStat.st_size);
+        if (m_mappingSize < sizeof(Header)) { throw runtime_error(m_path + " is not a valid cache file"); }
+    }
+
+    m_mapping = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (m_mapping == MAP_FAILED) {
+        m_mapping = nullptr;
+        throw system_error(lastError(), "Failed to map cache file " + m_path);
+    }
+
+    auto* header = static_cast<Header*>(m_mapping);
+    if (isNew) {
+        std::memcpy(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header->version = CACHE_VERSION;
+        header->slotSize = sizeof(Slot);
+        header->capacity = MIN_CAPACITY;
+        header->count = 0;
+        return;
+    }
+
+    const bool isValid = std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                         header->version == CACHE_VERSION && header->slotSize == sizeof(Slot) &&
+                         header->capacity != 0 && (header->capacity & (header->capacity - 1)) == 0 &&
+                         fileSizeForCapacity(header->capacity) == m_mappingSize;
+    if (!isValid) {
+        unmapFile();
+        throw runtime_error(m_path + " is not a valid cache file (or was created by an incompatible version)");
+    }
+}
+
+void ReportCache::unmapFile() {
+    if (m_mapping != nullptr) {
+        munmap(m_mapping, m_mappingSize);
+        m_mapping = nullptr;
+        m_mappingSize = 0;
+    }
+}
+
+/**
+ * @brief Writes all live entries into a new table of the given capacity and atomically replaces the cache file with it.
+ */
+void ReportCache::rebuild(uint64_t newCapacity, time_t now) {
+    const auto tmpPath = m_path + ".tmp";
+    const auto newSize = fileSizeForCapacity(newCapacity);
+
+    const int32_t newFd = open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (newFd < 0) { throw system_error(lastError(), "Failed to create " + tmpPath); }
+
+    // lock the new file before it becomes visible under the real name
+    void* newMapping = MAP_FAILED;
+    if (flock(newFd, LOCK_EX) != 0 || ftruncate(newFd, static_cast<off_t>(newSize)) != 0 ||
+        (newMapping = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, newFd, 0)) == MAP_FAILED) {
+        const auto error = lastError();
+        close(newFd);
+        unlink(tmpPath.c_str());
+        throw system_error(error, "Failed to prepare " + tmpPath);
+    }
+
+    auto* newHeader = static_cast<Header*>(newMapping);
+    std::memcpy(newHeader, m_mapping, sizeof(Header));
+    newHeader->capacity = newCapacity;
+    newHeader->count = 0;
+
+    auto* newTable = reinterpret_cast<Slot*>(static_cast<uint8_t*>(newMapping) + sizeof(Header));
+    const auto* oldTable = slots();
+    const auto mask = newCapacity - 1;
+    for (uint64_t i = 0; i < capacity(); i++) {
+        const auto& slot = oldTable[i];
+        if (slot.lastReported == 0 || isExpired(slot.lastReported, now)) { continue; }
+
+        IpAddress address;
+        std::memcpy(address.bytes.data(), slot.key, sizeof(slot.key));
+        auto index = address.hash() & mask;
+        while (newTable[index].lastReported != 0) { index = (index + 1) & mask; }
+
+        newTable[index] = slot;
+        newHeader->count++;
+    }
+
+    if (msync(newMapping, newSize, MS_SYNC) != 0 || rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+        const auto error = lastError();
+        munmap(newMapping, newSize);
+        close(newFd);
+        unlink(tmpPath.c_str());
+        throw system_error(error, "Failed to replace cache file " + m_path);
+    }
+
+    unmapFile();
+    close(m_fd);
+    m_fd = newFd;
+    m_mapping = newMapping;
+    m_mappingSize = newSize;
+
+    if (m_useBloomFilter) { buildBloomFilter(); }
+}
+
+void ReportCache::buildBloomFilter() {
+    const auto bits = nextPowerOfTwo(capacity() * BLOOM_BITS_PER_SLOT);
+    m_bloomBits.assign(bits / 64, 0);
+    m_bloomMask = bits - 1;
+
+    const auto* table = slots();
+    for (uint64_t i = 0; i < capacity(); i++) {
+        if (table[i].lastReported == 0) { continue; }
+
+        IpAddress address;
+        std::memcpy(address.bytes.data(), table[i].key, sizeof(table[i].key));
+        addToBloomFilter(address.hash());
+    }
+}
+
+void ReportCache::addToBloomFilter(uint64_t hash) {
+    // double hashing (Kirsch-Mitzenmacher)
+    const auto h2 = (hash >> 32) | 1;
+    for (uint32_t i = 0; i < BLOOM_HASHES; i++) {
+        const auto bit = (hash + i * h2) & m_bloomMask;
+        m_bloomBits[bit / 64] |= 1ull << (bit % 64);
+    }
+}
+
+bool ReportCache::mayContain(uint64_t hash) const {
+    const auto h2 = (hash >> 32) | 1;
+    for (uint32_t i = 0; i < BLOOM_HASHES; i++) {
+        const auto bit = (hash + i * h2) & m_bloomMask;
+        if ((m_bloomBits[bit / 64] & (1ull << (bit % 64))) == 0) { return false; }
+    }
+
+    return true;
+}
+
+bool ReportCache::isExpired(int64_t lastReported, time_t now) const { return now - lastReported >= m_ttl; }
+
+ReportCache::Slot* ReportCache::slots() const {
+    return reinterpret_cast<Slot*>(static_cast<uint8_t*>(m_mapping) + sizeof(Header));
+}
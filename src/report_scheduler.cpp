@@ -0,0 +1,423 @@
+/**
+ * @file report_scheduler.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the persistent queue which paces reports to abuseipdb's limits.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "mapped_file.hpp"
+#include "report_scheduler.hpp"
+
+using std::error_code;
+using std::runtime_error;
+using std::system_error;
+
+static constexpr char       QUEUE_MAGIC[8] = { 'F', '2', 'A', 'B', 'Q', 'U', 'E', 'U' }; //!< Identifies a queue file
+static constexpr uint32_t   QUEUE_VERSION = 1; //!< The current version of the on-disk format
+static constexpr time_t     SECONDS_PER_DAY = 24 * 60 * 60; //!< abuseipdb's quotas reset at midnight UTC
+
+/**
+ * @brief The header at the start of every queue file.
+ */
+struct ReportScheduler::Header {
+    char        magic[8]; //!< @see QUEUE_MAGIC
+    uint32_t    version; //!< @see QUEUE_VERSION
+    uint32_t    reserved; //!< Pads the header to 16 bytes
+};
+
+static_assert(sizeof(ReportScheduler::Header) == 16, "Queue header must be 16 bytes");
+
+/**
+ * @brief The types of records in the log. Each record is preceded by its payload's size and CRC-32 (both uint32_t).
+ */
+enum class RecordType: uint8_t {
+    Queued = 1, //!< A report was queued: address, not before, sequence, jail, row
+    Reported = 2, //!< A report was delivered: address, time
+};
+
+static constexpr size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t); //!< The size and the CRC-32 preceding each payload
+static constexpr size_t REPORTED_RECORD_SIZE = RECORD_HEADER_SIZE + 1 + 16 + sizeof(int64_t); //!< The size of a Reported record
+
+static error_code lastError() { return error_code(errno, std::generic_category()); }
+
+template<typename T>
+static void appendValue(string& out, T value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+/**
+ * @brief Reads values from a record's payload, failing (instead of reading past the end) if it's too short.
+ */
+struct PayloadReader {
+    string_view data; //!< The rest of the payload
+
+    template<typename T>
+    bool read(T& value) {
+        if (data.size() < sizeof(value)) { return false; }
+
+        std::memcpy(&value, data.data(), sizeof(value));
+        data.remove_prefix(sizeof(value));
+        return true;
+    }
+
+    bool read(string& value) {
+        uint32_t length = 0;
+        if (!read(length) || data.size() < length) { return false; }
+
+        value.assign(data.substr(0, length));
+        data.remove_prefix(length);
+        return true;
+    }
+};
+
+/**
+ * @brief Appends a record with the payload written by writePayload to the log.
+ */
+template<typename PayloadWriter>
+static void appendRecord(string& log, PayloadWriter&& writePayload) {
+    const auto recordStart = log.size();
+    log.append(RECORD_HEADER_SIZE, '\0');
+    writePayload(log);
+
+    const auto payloadSize = static_cast<uint32_t>(log.size() - recordStart - RECORD_HEADER_SIZE);
+    const auto checksum = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(log.data() + recordStart + RECORD_HEADER_SIZE), payloadSize));
+    std::memcpy(&log[recordStart], &payloadSize, sizeof(payloadSize));
+    std::memcpy(&log[recordStart + sizeof(payloadSize)], &checksum, sizeof(checksum));
+}
+
+/**
+ * @brief Writes all of data to a file descriptor.
+ */
+static void writeAll(int32_t fd, string_view data, const string& path) {
+    while (!data.empty()) {
+        const auto bytesWritten = write(fd, data.data(), data.size());
+        if (bytesWritten < 0 && errno == EINTR) {
+            continue;
+        } else if (bytesWritten < 0) {
+            throw system_error(lastError(), "Failed to write queue file " + path);
+        }
+
+        data.remove_prefix(static_cast<size_t>(bytesWritten));
+    }
+}
+
+static string makeHeader() {
+    ReportScheduler::Header header{};
+    std::memcpy(header.magic, QUEUE_MAGIC, sizeof(QUEUE_MAGIC));
+    header.version = QUEUE_VERSION;
+
+    return string(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+ReportScheduler::ReportScheduler(const string& path, uint32_t dailyQuota): m_path(path), m_dailyQuota(dailyQuota) {
+    openAndLock();
+
+    try {
+        replay();
+    } catch (...) {
+        close(m_fd);
+        throw;
+    }
+}
+
+ReportScheduler::~ReportScheduler() {
+    if (m_fd >= 0) { close(m_fd); } // also releases the lock
+}
+
+bool ReportScheduler::enqueue(const IpAddress& address, string_view jail, string_view row, time_t now) {
+    if (m_pending.find(address) != m_pending.end()) { return false; }
+
+    auto notBefore = now;
+    if (const auto lastReported = m_lastReported.find(address); lastReported != m_lastReported.end()) {
+        notBefore = std::max(notBefore, lastReported->second + REPORT_INTERVAL);
+    }
+
+    const auto& entry = m_pending.emplace(address, Entry{ m_nextSequence++, notBefore, string(jail), string(row) }).first->second;
+    pushDue(address, entry);
+    appendQueued(m_unwritten, address, entry);
+    m_pendingSize += queuedRecordSize(entry);
+
+    return true;
+}
+
+std::vector<ReportScheduler::Report> ReportScheduler::take(time_t now) {
+    expireReports(now);
+
+    auto remaining = std::numeric_limits<size_t>::max();
+    if (m_dailyQuota != 0) {
+        const auto used = reportedToday(now) + m_takenCount;
+        remaining = used < m_dailyQuota ? m_dailyQuota - used : 0;
+    }
+
+    std::vector<Report> reports;
+    while (remaining > 0 && !m_due.empty() && m_due.top().notBefore <= now) {
+        const auto item = m_due.top();
+        m_due.pop();
+
+        const auto entry = m_pending.find(item.address);
+        if (entry == m_pending.end() || entry->second.sequence != item.sequence || entry->second.isTaken) { continue; }
+
+        entry->second.isTaken = true;
+        m_takenCount++;
+        remaining--;
+        reports.push_back({ item.address, entry->second.jail, entry->second.row });
+    }
+
+    return reports;
+}
+
+void ReportScheduler::markReported(const IpAddress& address, time_t now) {
+    const auto entry = m_pending.find(address);
+    if (entry == m_pending.end() || !entry->second.isTaken) { return; }
+
+    m_pendingSize -= queuedRecordSize(entry->second);
+    m_pending.erase(entry);
+    m_takenCount--;
+
+    m_reported.push_back({ now, address });
+    m_lastReported[address] = now;
+    appendReported(m_unwritten, m_reported.back());
+}
+
+void ReportScheduler::requeue(const IpAddress& address) {
+    const auto entry = m_pending.find(address);
+    if (entry == m_pending.end() || !entry->second.isTaken) { return; }
+
+    entry->second.isTaken = false;
+    m_takenCount--;
+    pushDue(address, entry->second);
+}
+
+void ReportScheduler::sync(time_t now) {
+    if (!m_unwritten.empty()) {
+        try {
+            writeAll(m_fd, m_unwritten, m_path);
+            if (fdatasync(m_fd) != 0) { throw system_error(lastError(), "Failed to sync queue file " + m_path); }
+        } catch (...) {
+            // records appended after a partial one would be lost on replay; the unwritten ones are retried next time
+            if (ftruncate(m_fd, static_cast<off_t>(m_fileSize)) != 0) { /* replay cuts it off */ }
+            throw;
+        }
+
+        m_fileSize += m_unwritten.size();
+        m_unwritten.clear();
+    }
+
+    // only the pending reports and those within the limits' windows survive a compaction
+    expireReports(now);
+    if (m_fileSize < MIN_COMPACT_SIZE) { return; }
+
+    const auto liveSize = sizeof(Header) + m_pendingSize + m_reported.size() * REPORTED_RECORD_SIZE;
+    if (m_fileSize > 2 * liveSize) { compact(now); }
+}
+
+time_t ReportScheduler::nextDue() {
+    while (!m_due.empty()) {
+        const auto& item = m_due.top();
+        const auto entry = m_pending.find(item.address);
+        if (entry != m_pending.end() && entry->second.sequence == item.sequence && !entry->second.isTaken) { return item.notBefore; }
+
+        m_due.pop();
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Opens the queue file and acquires an exclusive lock on it.
+ *
+ * @remarks If another process replaced the file (compaction) while we were waiting for the lock, the new file is opened instead.
+ */
+void ReportScheduler::openAndLock() {
+    for (;;) {
+        m_fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+        if (m_fd < 0) { throw system_error(lastError(), "Failed to open queue file " + m_path); }
+
+        if (flock(m_fd, LOCK_EX) != 0) {
+            const auto error = lastError();
+            close(m_fd);
+            throw system_error(error, "Failed to lock queue file " + m_path);
+        }
+
+        struct stat lockedStat{}, pathStat{};
+        if (fstat(m_fd, &lockedStat) == 0 && stat(m_path.c_str(), &pathStat) == 0 &&
+            lockedStat.st_dev == pathStat.st_dev && lockedStat.st_ino == pathStat.st_ino) {
+            return;
+        }
+
+        close(m_fd);
+    }
+}
+
+/**
+ * @brief Rebuilds the queue from the log, initialising the log if it's empty and cutting off a torn record at its end.
+ */
+void ReportScheduler::replay() {
+    const MappedFile file(m_fd);
+    auto data = file.view();
+
+    if (data.empty()) {
+        const auto header = makeHeader();
+        writeAll(m_fd, header, m_path);
+        m_fileSize = header.size();
+        return;
+    }
+
+    const auto* header = reinterpret_cast<const Header*>(data.data());
+    if (data.size() < sizeof(Header) || std::memcmp(header->magic, QUEUE_MAGIC, sizeof(QUEUE_MAGIC)) != 0 || header->version != QUEUE_VERSION) {
+        throw runtime_error(m_path + " is not a valid queue file (or was created by an incompatible version)");
+    }
+
+    size_t offset = sizeof(Header);
+    while (data.size() - offset >= RECORD_HEADER_SIZE) {
+        uint32_t payloadSize = 0, checksum = 0;
+        std::memcpy(&payloadSize, data.data() + offset, sizeof(payloadSize));
+        std::memcpy(&checksum, data.data() + offset + sizeof(payloadSize), sizeof(checksum));
+        if (data.size() - offset - RECORD_HEADER_SIZE < payloadSize) { break; }
+
+        const auto payload = data.substr(offset + RECORD_HEADER_SIZE, payloadSize);
+        if (crc32(0, reinterpret_cast<const Bytef*>(payload.data()), payloadSize) != checksum) { break; }
+
+        PayloadReader reader{ payload };
+        uint8_t type = 0;
+        IpAddress address;
+        if (!reader.read(type) || !reader.read(address.bytes)) { break; }
+
+        if (type == static_cast<uint8_t>(RecordType::Queued)) {
+            Entry entry{};
+            int64_t notBefore = 0;
+            if (!reader.read(notBefore) || !reader.read(entry.sequence) || !reader.read(entry.jail) || !reader.read(entry.row)) { break; }
+
+            entry.notBefore = static_cast<time_t>(notBefore);
+            m_nextSequence = std::max(m_nextSequence, entry.sequence + 1);
+            const auto [iter, isNew] = m_pending.emplace(address, std::move(entry));
+            if (isNew) {
+                pushDue(address, iter->second);
+                m_pendingSize += queuedRecordSize(iter->second);
+            }
+        } else if (type == static_cast<uint8_t>(RecordType::Reported)) {
+            int64_t reportTime = 0;
+            if (!reader.read(reportTime)) { break; }
+
+            if (const auto iter = m_pending.find(address); iter != m_pending.end()) {
+                m_pendingSize -= queuedRecordSize(iter->second);
+                m_pending.erase(iter);
+            }
+            m_reported.push_back({ static_cast<time_t>(reportTime), address });
+            m_lastReported[address] = static_cast<time_t>(reportTime);
+        } else {
+            break;
+        }
+
+        offset += RECORD_HEADER_SIZE + payloadSize;
+    }
+
+    // whatever follows the last complete record was being written when the process died
+    if (offset < data.size() && ftruncate(m_fd, static_cast<off_t>(offset)) != 0) {
+        throw system_error(lastError(), "Failed to truncate queue file " + m_path);
+    }
+    m_fileSize = offset;
+}
+
+/**
+ * @brief Writes the pending reports (in order) and the reports within the limits' windows to a new log, which atomically
+ * replaces the current one.
+ */
+void ReportScheduler::compact(time_t now) {
+    expireReports(now);
+
+    std::vector<std::pair<const IpAddress*, const Entry*>> entries;
+    entries.reserve(m_pending.size());
+    for (const auto& [address, entry] : m_pending) { entries.emplace_back(&address, &entry); }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.second->sequence < b.second->sequence; });
+
+    string log = makeHeader();
+    for (const auto& report : m_reported) { appendReported(log, report); }
+    for (const auto& [address, entry] : entries) { appendQueued(log, *address, *entry); }
+
+    const auto tmpPath = m_path + ".tmp";
+    const int32_t newFd = open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    if (newFd < 0) { throw system_error(lastError(), "Failed to create " + tmpPath); }
+
+    // lock the new file before it becomes visible under the real name
+    try {
+        if (flock(newFd, LOCK_EX) != 0) { throw system_error(lastError(), "Failed to lock " + tmpPath); }
+        writeAll(newFd, log, tmpPath);
+        if (fdatasync(newFd) != 0 || rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+            throw system_error(lastError(), "Failed to replace queue file " + m_path);
+        }
+    } catch (...) {
+        close(newFd);
+        unlink(tmpPath.c_str());
+        throw;
+    }
+
+    close(m_fd);
+    m_fd = newFd;
+    m_fileSize = log.size();
+}
+
+/**
+ * @brief Forgets the reports which count towards neither the daily quota nor the interval between two reports of an IP.
+ */
+void ReportScheduler::expireReports(time_t now) {
+    const auto keepFrom = std::min(now - now % SECONDS_PER_DAY, now - REPORT_INTERVAL);
+    while (!m_reported.empty() && m_reported.front().time < keepFrom) {
+        const auto& report = m_reported.front();
+        if (const auto lastReported = m_lastReported.find(report.address); lastReported != m_lastReported.end() && lastReported->second <= report.time) {
+            m_lastReported.erase(lastReported);
+        }
+        m_reported.pop_front();
+    }
+}
+
+void ReportScheduler::appendQueued(string& log, const IpAddress& address, const Entry& entry) const {
+    appendRecord(log, [&](string& out) {
+        appendValue(out, static_cast<uint8_t>(RecordType::Queued));
+        out.append(reinterpret_cast<const char*>(address.bytes.data()), address.bytes.size());
+        appendValue(out, static_cast<int64_t>(entry.notBefore));
+        appendValue(out, entry.sequence);
+        appendValue(out, static_cast<uint32_t>(entry.jail.size()));
+        out.append(entry.jail);
+        appendValue(out, static_cast<uint32_t>(entry.row.size()));
+        out.append(entry.row);
+    });
+}
+
+void ReportScheduler::appendReported(string& log, const Reported& report) const {
+    appendRecord(log, [&](string& out) {
+        appendValue(out, static_cast<uint8_t>(RecordType::Reported));
+        out.append(reinterpret_cast<const char*>(report.address.bytes.data()), report.address.bytes.size());
+        appendValue(out, static_cast<int64_t>(report.time));
+    });
+}
+
+uint64_t ReportScheduler::queuedRecordSize(const Entry& entry) {
+    return RECORD_HEADER_SIZE + 1 + 16 + sizeof(int64_t) + sizeof(entry.sequence) + 2 * sizeof(uint32_t) + entry.jail.size() + entry.row.size();
+}
+
+void ReportScheduler::pushDue(const IpAddress& address, const Entry& entry) { m_due.push({ entry.notBefore, entry.sequence, address }); }
+
+/**
+ * @brief Counts the reports delivered since midnight (UTC).
+ */
+size_t ReportScheduler::reportedToday(time_t now) const {
+    const auto dayStart = now - now % SECONDS_PER_DAY;
+    const auto firstToday = std::partition_point(m_reported.begin(), m_reported.end(), [&](const Reported& report) { return report.time < dayStart; });
+
+    return static_cast<size_t>(m_reported.end() - firstToday);
+}
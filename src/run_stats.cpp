@@ -0,0 +1,138 @@
+/**
+ * @file run_stats.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the per-run instrumentation.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <iterator>
+
+#include <fmt/format.h>
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include "run_stats.hpp"
+#include "version.hpp"
+
+static constexpr const char* STAGE_NAMES[] = { "setup", "input", "parse", "render", "merge", "watch", "upload", "teardown" };
+static_assert(std::size(STAGE_NAMES) == static_cast<size_t>(RunStats::Stage::COUNT), "every stage needs a name");
+
+static double toMilliseconds(double seconds) { return seconds * 1e3; }
+
+static double toSeconds(const timeval& time) { return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6; }
+
+/**
+ * @brief Appends a string as a JSON string literal.
+ */
+static void appendJsonString(fmt::memory_buffer& buffer, string_view text) {
+    buffer.push_back('"');
+    for (const auto c : text) {
+        if (c == '"' || c == '\\') {
+            buffer.push_back('\\');
+            buffer.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            fmt::format_to(std::back_inserter(buffer), "\\u{0:04x}", static_cast<uint32_t>(c));
+        } else {
+            buffer.push_back(c);
+        }
+    }
+    buffer.push_back('"');
+}
+
+RunStats::RunStats(): m_start(sample()), m_lastSample(m_start) {
+    m_stageStack.push_back(Stage::Setup);
+}
+
+RunStats::Sample RunStats::sample() {
+    timespec cpuTime{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime);
+
+    return { std::chrono::steady_clock::now(), static_cast<double>(cpuTime.tv_sec) + static_cast<double>(cpuTime.tv_nsec) / 1e9 };
+}
+
+void RunStats::enter(Stage stage) {
+    credit(sample());
+    m_stageStack.push_back(stage);
+}
+
+void RunStats::leave() {
+    credit(sample());
+    if (m_stageStack.size() > 1) { m_stageStack.pop_back(); }
+}
+
+void RunStats::addRender(double wallSeconds, double cpuSeconds) {
+    auto& totals = m_stages[static_cast<size_t>(Stage::Render)];
+    totals.wallSeconds += wallSeconds;
+    totals.cpuSeconds += cpuSeconds;
+}
+
+RunStats::JailCounters& RunStats::jail(string_view name) {
+    // most lookups are for the same jail as the previous one
+    if (!m_jails.empty() && m_jails.back().first == name) { return m_jails.back().second; }
+
+    const auto [index, isNew] = m_jailIndices.try_emplace(string(name), m_jails.size());
+    if (isNew) { m_jails.emplace_back(string(name), JailCounters{}); }
+
+    return m_jails[index->second].second;
+}
+
+string RunStats::toJson(int32_t exitCode) const {
+    const auto now = sample();
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    JailCounters totals;
+    for (const auto& [name, counters] : m_jails) {
+        totals.seen += counters.seen;
+        totals.invalid += counters.invalid;
+        totals.emitted += counters.emitted;
+        totals.excluded += counters.excluded;
+        totals.cached += counters.cached;
+        totals.duplicates += counters.duplicates;
+        totals.unchanged += counters.unchanged;
+    }
+
+    fmt::memory_buffer json;
+    auto out = std::back_inserter(json);
+    fmt::format_to(out, R"({{"version":"{0:s}","exit_code":{1:d},"wall_ms":{2:.3f},"cpu_user_ms":{3:.3f},"cpu_system_ms":{4:.3f},)",
+                   getProjectVersion(), exitCode, toMilliseconds(std::chrono::duration<double>(now.wall - m_start.wall).count()),
+                   toMilliseconds(toSeconds(usage.ru_utime)), toMilliseconds(toSeconds(usage.ru_stime)));
+    fmt::format_to(out, R"("peak_rss_kb":{0:d},"threads":{1:d},"bytes_read":{2:d},"ips_seen":{3:d},"ips_emitted":{4:d},"skipped_excluded":{5:d},"skipped_cached":{6:d},"skipped_duplicate":{7:d},"skipped_unchanged":{8:d},"skipped_invalid":{9:d},)",
+                   usage.ru_maxrss, m_threadCount, m_bytesRead, totals.seen, totals.emitted, totals.excluded, totals.cached, totals.duplicates,
+                   totals.unchanged, totals.invalid);
+
+    json.append(string_view(R"("stages":{)"));
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        if (i > 0) { json.push_back(','); }
+        fmt::format_to(out, R"("{0:s}":{{"wall_ms":{1:.3f},"cpu_ms":{2:.3f}}})", STAGE_NAMES[i],
+                       toMilliseconds(m_stages[i].wallSeconds), toMilliseconds(m_stages[i].cpuSeconds));
+    }
+
+    json.append(string_view(R"(},"jails":{)"));
+    for (size_t i = 0; i < m_jails.size(); i++) {
+        const auto& [name, counters] = m_jails[i];
+        if (i > 0) { json.push_back(','); }
+        appendJsonString(json, name);
+        fmt::format_to(out, R"(:{{"seen":{0:d},"emitted":{1:d},"excluded":{2:d},"cached":{3:d},"duplicates":{4:d},"unchanged":{5:d},"invalid":{6:d}}})",
+                       counters.seen, counters.emitted, counters.excluded, counters.cached, counters.duplicates, counters.unchanged,
+                       counters.invalid);
+    }
+    json.append(string_view("}}"));
+
+    return fmt::to_string(json);
+}
+
+/**
+ * @brief Credits the time since the last sample to the current stage.
+ */
+void RunStats::credit(const Sample& now) {
+    auto& totals = m_stages[static_cast<size_t>(m_stageStack.back())];
+    totals.wallSeconds += std::chrono::duration<double>(now.wall - m_lastSample.wall).count();
+    totals.cpuSeconds += now.cpuSeconds - m_lastSample.cpuSeconds;
+    m_lastSample = now;
+}
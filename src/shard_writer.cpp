@@ -0,0 +1,91 @@
+/**
+ * @file shard_writer.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the writer splitting the CSV output into separate, size-bounded files.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include <cerrno>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "csv_writer.hpp"
+#include "shard_writer.hpp"
+
+namespace fs = std::filesystem;
+
+using std::error_code;
+using std::system_error;
+
+ShardWriter::ShardWriter(const string& directory, string_view prefix, size_t writerCount):
+m_directory(directory), m_prefix(prefix), m_writers(writerCount) {
+    fs::create_directories(m_directory);
+}
+
+ShardWriter::~ShardWriter() {
+    for (auto& pending : m_pending) { pending.wait(); }
+}
+
+void ShardWriter::write(string_view rows) {
+    string data;
+    data.reserve(CsvWriter::CSV_HEADER.size() + rows.size());
+    data.append(CsvWriter::CSV_HEADER).append(rows);
+
+    auto name = fmt::format("{0:s}{1:06d}{2:s}", m_prefix, m_nextShard++, SHARD_EXTENSION);
+    m_pending.push_back(m_writers.submit([this, name = std::move(name), data = std::move(data)]() { writeShard(name, data); }));
+
+    // bound the memory held by queued shards
+    while (m_pending.size() > m_writers.threadCount() * SHARDS_PER_WRITER) {
+        auto oldest = std::move(m_pending.front());
+        m_pending.pop_front();
+        oldest.get();
+    }
+}
+
+void ShardWriter::sync() {
+    while (!m_pending.empty()) {
+        auto oldest = std::move(m_pending.front());
+        m_pending.pop_front();
+        oldest.get();
+    }
+}
+
+/**
+ * @brief Writes a shard to a hidden temporary file, syncs it and renames it to its final name (runs on the writers).
+ */
+void ShardWriter::writeShard(const string& name, const string& data) const {
+    const auto path = (fs::path(m_directory) / name).string();
+    const auto tmpPath = (fs::path(m_directory) / ("." + name + ".tmp")).string();
+    const int32_t fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) { throw system_error(error_code(errno, std::generic_category()), "Failed to create " + tmpPath); }
+
+    const auto writeAll = [&](const char* bytes, size_t size) {
+        while (size > 0) {
+            const auto written = ::write(fd, bytes, size);
+            if (written < 0 && errno == EINTR) { continue; }
+            if (written < 0) { return false; }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    };
+
+    bool isWritten = writeAll(data.data(), data.size()) && fsync(fd) == 0;
+    const error_code writeError(errno, std::generic_category());
+    isWritten = close(fd) == 0 && isWritten;
+
+    if (!isWritten || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        const error_code error = isWritten ? error_code(errno, std::generic_category()) : writeError;
+        unlink(tmpPath.c_str());
+        throw system_error(error, "Failed to write shard " + path);
+    }
+}
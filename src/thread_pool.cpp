@@ -0,0 +1,65 @@
+/**
+ * @file thread_pool.cpp
+ * @author Simon Cahill (simon@simonc.eu)
+ * @brief Contains the implementation of the fixed-size thread pool.
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Simon Cahill and Contributors
+ */
+
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount <= 1) { return; }
+
+    for (size_t i = 0; i < threadCount; i++) { m_workers.emplace_back(&ThreadPool::work, this); }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+        m_jobs.clear();
+    }
+    m_jobAvailable.notify_all();
+
+    for (auto& worker : m_workers) { worker.join(); }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> job) {
+    std::packaged_task<void()> task(std::move(job));
+    auto future = task.get_future();
+
+    if (m_workers.empty()) {
+        task();
+        return future;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(task));
+    }
+    m_jobAvailable.notify_one();
+
+    return future;
+}
+
+/**
+ * @brief Runs queued jobs until the pool is stopped.
+ */
+void ThreadPool::work() {
+    for (;;) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [&]() { return !m_jobs.empty() || m_isStopping; });
+            if (m_isStopping) { return; }
+
+            task = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        task();
+    }
+}